@@ -0,0 +1,48 @@
+# Writes the SPIR-V files in SHADER_FILES, separated by '|', into OUTPUT as
+# constexpr word arrays, along with the table `get_embedded_shaders` returns.
+# Run with `cmake -P` by the build whenever a shader changes.
+
+string(REPLACE "|" ";" SHADER_FILES "${SHADER_FILES}")
+list(SORT SHADER_FILES)
+
+set(ARRAYS "")
+set(ENTRIES "")
+list(LENGTH SHADER_FILES SHADER_COUNT)
+
+foreach(FILE ${SHADER_FILES})
+	# main.vert.spv is embedded as "main.vert" in main_vert.
+	get_filename_component(NAME "${FILE}" NAME)
+	string(REGEX REPLACE "\\.spv$" "" NAME "${NAME}")
+	string(MAKE_C_IDENTIFIER "${NAME}" IDENTIFIER)
+
+	# SPIR-V is a stream of little-endian words, so every four bytes are
+	# swapped into one hexadecimal literal.
+	file(READ "${FILE}" HEX HEX)
+	string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1," WORDS "${HEX}")
+	string(REGEX REPLACE "(0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,)"
+		"\\1\n    " WORDS "${WORDS}")
+	string(STRIP "${WORDS}" WORDS)
+
+	string(APPEND ARRAYS
+		"constexpr uint32_t ${IDENTIFIER}[] = {\n    ${WORDS}\n};\n\n")
+	string(APPEND ENTRIES
+		"    EmbeddedShader{\"${NAME}\", ${IDENTIFIER}},\n")
+endforeach()
+
+set(SOURCE "// Generated by cmake/embed_shaders.cmake. Do not edit.\n\n")
+string(APPEND SOURCE "#include \"shaders.hpp\"\n\n")
+string(APPEND SOURCE "namespace {\n${ARRAYS}")
+string(APPEND SOURCE
+	"constexpr std::array<EmbeddedShader, ${SHADER_COUNT}> SHADERS{\n")
+string(APPEND SOURCE "${ENTRIES}};\n} // namespace\n\n")
+string(APPEND SOURCE
+	"auto get_embedded_shaders() -> std::span<const EmbeddedShader> {\n")
+string(APPEND SOURCE "    return SHADERS;\n}\n")
+
+# Leave the file alone when nothing changed, so that it is not recompiled.
+if (EXISTS "${OUTPUT}")
+	file(READ "${OUTPUT}" OLD_SOURCE)
+endif()
+if (NOT "${OLD_SOURCE}" STREQUAL "${SOURCE}")
+	file(WRITE "${OUTPUT}" "${SOURCE}")
+endif()
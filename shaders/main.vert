@@ -1,7 +1,28 @@
 #version 450
 
+struct Object {
+    mat4 transform;
+    vec4 bounding_sphere;
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint lod_chain;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+// The first member of the culling pass's camera uniform, which is written
+// every frame. Reading it from memory rather than push constants keeps
+// recorded command buffers valid while the camera moves.
+layout (std140, set = 0, binding = 5) uniform Camera {
+    mat4 view_projection;
+} camera;
+
 layout (location = 0) in vec3 in_position;
 
 void main() {
-    gl_Position = vec4(in_position, 1.0);
+    gl_Position = camera.view_projection * objects[gl_InstanceIndex].transform *
+                  vec4(in_position, 1.0);
 }
@@ -0,0 +1,35 @@
+#version 450
+
+struct Object {
+    mat4 transform;
+    vec4 bounding_sphere;
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint lod_chain;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+// The whole geometry heap. Positions are tightly packed floats, as a vec3
+// array would have a 16 byte stride in std430.
+layout (std430, set = 1, binding = 0) readonly buffer Geometry {
+    float positions[];
+};
+
+// Shared with the culling pass, as in main.vert.
+layout (std140, set = 0, binding = 5) uniform Camera {
+    mat4 view_projection;
+} camera;
+
+void main() {
+    // gl_VertexIndex already includes the draw's vertexOffset.
+    uint base = uint(gl_VertexIndex) * 3u;
+    vec3 position = vec3(positions[base], positions[base + 1],
+                         positions[base + 2]);
+
+    gl_Position = camera.view_projection * objects[gl_InstanceIndex].transform *
+                  vec4(position, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 450
+
+layout (location = 0) out vec4 out_color;
+
+// Added up over every fragment shaded at a pixel. Red saturates after 8
+// layers, green after 16 and blue after 32, so the image goes from black
+// through red and yellow to white as overdraw grows.
+void main() {
+    out_color = vec4(0.125, 0.0625, 0.03125, 1.0);
+}
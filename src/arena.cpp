@@ -0,0 +1,61 @@
+#include "arena.hpp"
+
+FrameArena::FrameArena(size_t p_block_size)
+    : block_size(p_block_size), current_block(0), offset(0), used_bytes(0) {
+    blocks.push_back(Block{
+        .data = std::make_unique<std::byte[]>(block_size),
+        .size = block_size,
+    });
+}
+
+auto FrameArena::allocate_bytes(size_t p_size, size_t p_alignment) -> void * {
+    while (true) {
+        auto &block = blocks[current_block];
+
+        const auto base = reinterpret_cast<uintptr_t>(block.data.get());
+        const auto aligned =
+            (base + offset + p_alignment - 1) & ~(p_alignment - 1);
+        const auto start = aligned - base;
+
+        if (start + p_size <= block.size) {
+            used_bytes += start + p_size - offset;
+            offset = start + p_size;
+            return block.data.get() + start;
+        }
+
+        current_block++;
+        offset = 0;
+
+        if (current_block == blocks.size()) {
+            const auto size = std::max(block_size, p_size + p_alignment);
+            blocks.push_back(Block{
+                .data = std::make_unique<std::byte[]>(size),
+                .size = size,
+            });
+        }
+    }
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        const auto size = get_capacity();
+
+        blocks.clear();
+        blocks.push_back(Block{
+            .data = std::make_unique<std::byte[]>(size),
+            .size = size,
+        });
+    }
+
+    current_block = 0;
+    offset = 0;
+    used_bytes = 0;
+}
+
+auto FrameArena::get_capacity() const -> size_t {
+    size_t capacity = 0;
+    for (const auto &block : blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common.hpp"
+
+// A bump allocator for data that only lives for one frame. Allocations are
+// never freed one by one: `reset` releases all of them at once and keeps the
+// memory for the next frame. When a frame needs more than one block, the
+// blocks are merged on reset so that the next frame fits in one.
+class FrameArena {
+  public:
+    explicit FrameArena(size_t block_size = 1 << 20);
+
+    NO_COPY(FrameArena);
+
+    // Uninitialized storage for `count` values. Only for types that need no
+    // destruction, since the arena never runs destructors.
+    template <typename T> auto allocate(size_t count) -> std::span<T> {
+        static_assert(std::is_trivially_destructible_v<T>);
+        return {static_cast<T *>(allocate_bytes(count * sizeof(T), alignof(T))),
+                count};
+    }
+
+    void reset();
+
+    inline size_t get_used_bytes() const { return used_bytes; }
+
+    auto get_capacity() const -> size_t;
+
+  private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    auto allocate_bytes(size_t size, size_t alignment) -> void *;
+
+    size_t block_size;
+    std::vector<Block> blocks;
+    size_t current_block;
+    size_t offset;
+    size_t used_bytes;
+};
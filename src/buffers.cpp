@@ -1,4 +1,5 @@
 #include "buffers.hpp"
+#include "trace.hpp"
 
 Buffer::Buffer(const Device &device, VkDeviceSize size, Type type)
     : size(size), device(device) {
@@ -24,6 +25,29 @@ Buffer::Buffer(const Device &device, VkDeviceSize size, Type type)
                 case Type::Uniform:
                     return static_cast<VkBufferUsageFlags>(
                         VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+                case Type::Storage:
+                    return static_cast<VkBufferUsageFlags>(
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+                case Type::Indirect:
+                    return static_cast<VkBufferUsageFlags>(
+                        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+                case Type::Readback:
+                    return static_cast<VkBufferUsageFlags>(
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+                case Type::Geometry:
+                    return static_cast<VkBufferUsageFlags>(
+                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                        VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                        (device.get_capabilities().buffer_device_address
+                             ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+                             : 0));
                 }
             }(),
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
@@ -62,6 +86,19 @@ Buffer::Buffer(const Device &device, VkDeviceSize size, Type type)
             return static_cast<VkMemoryPropertyFlags>(
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        case Type::Storage:
+            return static_cast<VkMemoryPropertyFlags>(
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        case Type::Indirect:
+            return static_cast<VkMemoryPropertyFlags>(
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        case Type::Readback:
+            return static_cast<VkMemoryPropertyFlags>(
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        case Type::Geometry:
+            return static_cast<VkMemoryPropertyFlags>(
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         }
     }();
 
@@ -86,70 +123,89 @@ Buffer::Buffer(const Device &device, VkDeviceSize size, Type type)
         throw std::runtime_error("Could not find suitable memory type.");
     }
 
+    const auto has_device_address =
+        type == Type::Geometry &&
+        device.get_capabilities().buffer_device_address;
+
+    const VkMemoryAllocateFlagsInfo memory_allocate_flags_info{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .pNext = nullptr,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+        .deviceMask = 0,
+    };
+
     const VkMemoryAllocateInfo memory_allocate_info{
         .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext = nullptr,
+        .pNext = has_device_address ? &memory_allocate_flags_info : nullptr,
         .allocationSize = memory_requirements.size,
         .memoryTypeIndex = memory_type_index.value(),
     };
 
-    VK_ERROR(vkAllocateMemory(device.get(), &memory_allocate_info, nullptr,
-                              &memory));
+    const auto category = [&]() {
+        switch (type) {
+        case Type::Vertex:
+        case Type::Index:
+        case Type::Geometry:
+            return MemoryCategory::Geometry;
+        case Type::Staging:
+            return MemoryCategory::Staging;
+        case Type::Uniform:
+            return MemoryCategory::Uniform;
+        case Type::Storage:
+        case Type::Indirect:
+            return MemoryCategory::Storage;
+        case Type::Readback:
+            return MemoryCategory::Readback;
+        }
+
+        return MemoryCategory::Storage;
+    }();
+
+    memory = device.get_memory_tracker().allocate(
+        device.get(), memory_allocate_info, category);
 
     vkBindBufferMemory(device.get(), buffer, memory, 0);
 }
 
-auto Buffer::copy_from(const Buffer &other,
-                       const CommandPool &command_pool) const -> void {
+auto Buffer::copy_from(const Buffer &other, const CommandPool &command_pool,
+                       VkDeviceSize offset) const -> void {
     // Pick the smallest of the two sizes
-    const auto size = std::min(other.size, this->size);
+    const auto size = std::min(other.size, this->size - offset);
 
-    const auto command_buffer = command_pool.allocate_buffer();
-
-    const VkCommandBufferBeginInfo begin_info{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = nullptr,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-        .pInheritanceInfo = nullptr,
-    };
-
-    VK_ERROR(vkBeginCommandBuffer(command_buffer, &begin_info));
+    const auto command_buffer = command_pool.begin_one_time();
 
     const VkBufferCopy copy_region{
         .srcOffset = 0,
-        .dstOffset = 0,
+        .dstOffset = offset,
         .size = size,
     };
 
     vkCmdCopyBuffer(command_buffer, other.buffer, this->buffer, 1,
                     &copy_region);
 
-    VK_ERROR(vkEndCommandBuffer(command_buffer));
-
-    const VkSubmitInfo submit_info{
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 0,
-        .pWaitSemaphores = nullptr,
-        .pWaitDstStageMask = nullptr,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &command_buffer,
-        .signalSemaphoreCount = 0,
-        .pSignalSemaphores = nullptr,
-    };
-
-    VK_ERROR(vkQueueSubmit(device.get_graphics_queue(), 1, &submit_info,
-                           VK_NULL_HANDLE));
+    command_pool.end_one_time(command_buffer);
 }
 
 auto Buffer::load_using_staging(const CommandPool &command_pool,
-                                const void *data, VkDeviceSize size) -> void {
+                                const void *data, VkDeviceSize size,
+                                VkDeviceSize offset) -> void {
+    TRACE_SCOPE("Buffer::load_using_staging");
+
     StagingBuffer staging_buffer{device, size};
 
     const auto staging_data = staging_buffer.map_memory();
     memcpy(staging_data, data, size);
     staging_buffer.unmap_memory();
 
-    copy_from(staging_buffer.get(), command_pool);
-    vkQueueWaitIdle(device.get_graphics_queue());
+    copy_from(staging_buffer.get(), command_pool, offset);
+}
+
+auto Buffer::get_device_address() const -> VkDeviceAddress {
+    const VkBufferDeviceAddressInfo address_info{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .pNext = nullptr,
+        .buffer = buffer,
+    };
+
+    return vkGetBufferDeviceAddress(device.get(), &address_info);
 }
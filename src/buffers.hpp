@@ -4,17 +4,33 @@
 
 class Buffer {
   public:
-    enum class Type { Vertex, Index, Staging, Uniform };
+    enum class Type {
+        Vertex,
+        Index,
+        Staging,
+        Uniform,
+        Storage,
+        Indirect,
+        Readback,
+        // Vertices and indices of many meshes in one buffer. Bindable as a
+        // vertex, index or storage buffer and, when the device supports it,
+        // readable through its device address.
+        Geometry
+    };
 
     Buffer(const Device &device, VkDeviceSize size, Type type);
 
     NO_COPY(Buffer);
 
-    void copy_from(const Buffer &other,
-                   const CommandPool &command_buffer) const;
+    // Copies `other` into this buffer, starting `offset` bytes in.
+    void copy_from(const Buffer &other, const CommandPool &command_buffer,
+                   VkDeviceSize offset = 0) const;
 
     void load_using_staging(const CommandPool &command_pool, const void *data,
-                            VkDeviceSize size);
+                            VkDeviceSize size, VkDeviceSize offset = 0);
+
+    // Only valid for geometry buffers on devices with buffer device address.
+    auto get_device_address() const -> VkDeviceAddress;
 
     inline VkBuffer get() const { return buffer; }
 
@@ -24,9 +40,16 @@ class Buffer {
 
     inline const Device &get_device() const { return device; }
 
+    inline void set_debug_name(std::string_view name) const {
+        ::set_debug_name(device, VK_OBJECT_TYPE_BUFFER, to_debug_handle(buffer),
+                         name);
+        ::set_debug_name(device, VK_OBJECT_TYPE_DEVICE_MEMORY,
+                         to_debug_handle(memory), name);
+    }
+
     ~Buffer() {
         vkDestroyBuffer(device.get(), buffer, nullptr);
-        vkFreeMemory(device.get(), memory, nullptr);
+        device.get_memory_tracker().free(device.get(), memory);
     }
 
   private:
@@ -0,0 +1,217 @@
+#include "capabilities.hpp"
+
+namespace {
+bool has_extension(const std::vector<VkExtensionProperties> &p_extensions,
+                   std::string_view p_name) {
+    return std::any_of(p_extensions.begin(), p_extensions.end(),
+                       [&](const VkExtensionProperties &extension) {
+                           return std::string_view{extension.extensionName} ==
+                                  p_name;
+                       });
+}
+
+std::string_view yes_no(bool p_value) { return p_value ? "yes" : "no"; }
+} // namespace
+
+DeviceFeatureChain::DeviceFeatureChain(uint32_t p_api_version,
+                                       bool p_has_present_id,
+                                       bool p_has_present_wait)
+    : features{}, vulkan11{}, vulkan12{}, vulkan13{}, present_id{},
+      present_wait{} {
+    link(p_api_version, p_has_present_id, p_has_present_wait);
+}
+
+DeviceFeatureChain::DeviceFeatureChain(const DeviceCapabilities &p_caps)
+    : features{}, vulkan11{}, vulkan12{}, vulkan13{}, present_id{},
+      present_wait{} {
+    link(p_caps.api_version, p_caps.present_id, p_caps.present_wait);
+
+    auto &core = features.features;
+    core.multiDrawIndirect = p_caps.multi_draw_indirect;
+    core.drawIndirectFirstInstance = p_caps.draw_indirect_first_instance;
+    core.samplerAnisotropy = p_caps.sampler_anisotropy;
+    core.textureCompressionBC = p_caps.texture_compression_bc;
+    core.textureCompressionETC2 = p_caps.texture_compression_etc2;
+    core.pipelineStatisticsQuery = p_caps.pipeline_statistics_query;
+    core.shaderInt64 = p_caps.shader_int64;
+
+    vulkan11.shaderDrawParameters = p_caps.shader_draw_parameters;
+
+    vulkan12.drawIndirectCount = p_caps.draw_indirect_count;
+    vulkan12.runtimeDescriptorArray = p_caps.descriptor_indexing;
+    vulkan12.descriptorBindingPartiallyBound = p_caps.descriptor_indexing;
+    vulkan12.descriptorBindingVariableDescriptorCount =
+        p_caps.descriptor_indexing;
+    vulkan12.shaderSampledImageArrayNonUniformIndexing =
+        p_caps.descriptor_indexing;
+    vulkan12.samplerFilterMinmax = p_caps.sampler_filter_minmax;
+    vulkan12.timelineSemaphore = p_caps.timeline_semaphores;
+    vulkan12.bufferDeviceAddress = p_caps.buffer_device_address;
+    vulkan12.hostQueryReset = p_caps.host_query_reset;
+    vulkan12.scalarBlockLayout = p_caps.scalar_block_layout;
+
+    vulkan13.synchronization2 = p_caps.synchronization2;
+    vulkan13.dynamicRendering = p_caps.dynamic_rendering;
+
+    present_id.presentId = p_caps.present_id;
+    present_wait.presentWait = p_caps.present_wait;
+}
+
+void DeviceFeatureChain::link(uint32_t p_api_version, bool p_has_present_id,
+                              bool p_has_present_wait) {
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    vulkan11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    vulkan12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    present_id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    present_wait.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    // Each structure is prepended, so the chain ends up in reverse order.
+    void *next = nullptr;
+
+    if (p_has_present_wait) {
+        present_wait.pNext = next;
+        next = &present_wait;
+    }
+
+    if (p_has_present_id) {
+        present_id.pNext = next;
+        next = &present_id;
+    }
+
+    if (p_api_version >= VK_API_VERSION_1_3) {
+        vulkan13.pNext = next;
+        next = &vulkan13;
+    }
+
+    // The per-version structures only exist from Vulkan 1.2 on.
+    if (p_api_version >= VK_API_VERSION_1_2) {
+        vulkan12.pNext = next;
+        next = &vulkan12;
+
+        vulkan11.pNext = next;
+        next = &vulkan11;
+    }
+
+    features.pNext = next;
+}
+
+auto query_capabilities(VkPhysicalDevice p_physical_device)
+    -> DeviceCapabilities {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(p_physical_device, &properties);
+
+    uint32_t extension_count;
+    vkEnumerateDeviceExtensionProperties(p_physical_device, nullptr,
+                                         &extension_count, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(p_physical_device, nullptr,
+                                         &extension_count, extensions.data());
+
+    DeviceCapabilities caps{};
+    caps.api_version = std::min(properties.apiVersion, VK_API_VERSION_1_3);
+    caps.memory_budget =
+        has_extension(extensions, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    const auto has_present_id =
+        has_extension(extensions, VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    const auto has_present_wait =
+        has_present_id &&
+        has_extension(extensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+
+    DeviceFeatureChain chain{caps.api_version, has_present_id,
+                             has_present_wait};
+    vkGetPhysicalDeviceFeatures2(p_physical_device, chain.get());
+
+    const auto &core = chain.features.features;
+    caps.multi_draw_indirect = core.multiDrawIndirect;
+    caps.draw_indirect_first_instance = core.drawIndirectFirstInstance;
+    caps.sampler_anisotropy = core.samplerAnisotropy;
+    caps.texture_compression_bc = core.textureCompressionBC;
+    caps.texture_compression_etc2 = core.textureCompressionETC2;
+    caps.pipeline_statistics_query = core.pipelineStatisticsQuery;
+    caps.shader_int64 = core.shaderInt64;
+
+    if (caps.api_version >= VK_API_VERSION_1_2) {
+        const auto &vulkan11 = chain.vulkan11;
+        const auto &vulkan12 = chain.vulkan12;
+
+        caps.shader_draw_parameters = vulkan11.shaderDrawParameters;
+        caps.draw_indirect_count = vulkan12.drawIndirectCount;
+        caps.descriptor_indexing =
+            vulkan12.runtimeDescriptorArray &&
+            vulkan12.descriptorBindingPartiallyBound &&
+            vulkan12.descriptorBindingVariableDescriptorCount &&
+            vulkan12.shaderSampledImageArrayNonUniformIndexing;
+        caps.sampler_filter_minmax = vulkan12.samplerFilterMinmax;
+        caps.timeline_semaphores = vulkan12.timelineSemaphore;
+        caps.buffer_device_address = vulkan12.bufferDeviceAddress;
+        caps.host_query_reset = vulkan12.hostQueryReset;
+        caps.scalar_block_layout = vulkan12.scalarBlockLayout;
+    }
+
+    if (caps.api_version >= VK_API_VERSION_1_3) {
+        caps.synchronization2 = chain.vulkan13.synchronization2;
+        caps.dynamic_rendering = chain.vulkan13.dynamicRendering;
+    }
+
+    caps.present_id = has_present_id && chain.present_id.presentId;
+    caps.present_wait = caps.present_id && has_present_wait &&
+                        chain.present_wait.presentWait;
+
+    return caps;
+}
+
+bool meets_requirements(const DeviceCapabilities &p_caps) {
+    return p_caps.multi_draw_indirect && p_caps.draw_indirect_first_instance &&
+           p_caps.draw_indirect_count;
+}
+
+auto required_device_extensions(const DeviceCapabilities &p_caps)
+    -> std::vector<const char *> {
+    std::vector<const char *> extensions{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+    if (p_caps.memory_budget) {
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    if (p_caps.present_id) {
+        extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    }
+
+    if (p_caps.present_wait) {
+        extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
+
+    return extensions;
+}
+
+void log_capabilities(const DeviceCapabilities &p_caps) {
+    fmt::println("[INFO]: Device capabilities (Vulkan {}.{}):",
+                 VK_API_VERSION_MAJOR(p_caps.api_version),
+                 VK_API_VERSION_MINOR(p_caps.api_version));
+    fmt::println("[INFO]:   synchronization2: {}, dynamic rendering: {}",
+                 yes_no(p_caps.synchronization2),
+                 yes_no(p_caps.dynamic_rendering));
+    fmt::println("[INFO]:   timeline semaphores: {}, buffer device address: "
+                 "{}, descriptor indexing: {}",
+                 yes_no(p_caps.timeline_semaphores),
+                 yes_no(p_caps.buffer_device_address),
+                 yes_no(p_caps.descriptor_indexing));
+    fmt::println("[INFO]:   sampler min/max: {}, scalar block layout: {}, "
+                 "host query reset: {}",
+                 yes_no(p_caps.sampler_filter_minmax),
+                 yes_no(p_caps.scalar_block_layout),
+                 yes_no(p_caps.host_query_reset));
+    fmt::println("[INFO]:   BC: {}, ETC2: {}, anisotropy: {}, pipeline "
+                 "statistics: {}",
+                 yes_no(p_caps.texture_compression_bc),
+                 yes_no(p_caps.texture_compression_etc2),
+                 yes_no(p_caps.sampler_anisotropy),
+                 yes_no(p_caps.pipeline_statistics_query));
+    fmt::println("[INFO]:   memory budget: {}, present id: {}, present wait: {}",
+                 yes_no(p_caps.memory_budget), yes_no(p_caps.present_id),
+                 yes_no(p_caps.present_wait));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "common.hpp"
+
+// The features and extensions the engine knows how to use, as supported by a
+// physical device. Everything that is true here is also enabled on the
+// logical device, so subsystems can pick their fast paths by checking it and
+// fall back otherwise.
+struct DeviceCapabilities {
+    uint32_t api_version = 0;
+
+    // Vulkan 1.0
+    bool multi_draw_indirect = false;
+    bool draw_indirect_first_instance = false;
+    bool sampler_anisotropy = false;
+    bool texture_compression_bc = false;
+    bool texture_compression_etc2 = false;
+    bool pipeline_statistics_query = false;
+    bool shader_int64 = false;
+
+    // Vulkan 1.1
+    bool shader_draw_parameters = false;
+
+    // Vulkan 1.2
+    bool draw_indirect_count = false;
+    // Runtime sized, partially bound, non-uniformly indexed sampled image
+    // arrays.
+    bool descriptor_indexing = false;
+    bool sampler_filter_minmax = false;
+    bool timeline_semaphores = false;
+    bool buffer_device_address = false;
+    bool host_query_reset = false;
+    bool scalar_block_layout = false;
+
+    // Vulkan 1.3
+    bool synchronization2 = false;
+    bool dynamic_rendering = false;
+
+    // Device extensions
+    bool memory_budget = false;
+    bool present_id = false;
+    bool present_wait = false;
+};
+
+// Queries what the device supports of DeviceCapabilities.
+auto query_capabilities(VkPhysicalDevice physical_device) -> DeviceCapabilities;
+
+// Whether the device has what the engine can not run without: indirect count
+// draws for GPU culling, with multiple draws and a first instance per draw.
+bool meets_requirements(const DeviceCapabilities &capabilities);
+
+// Every optional device extension the capabilities call for, plus
+// VK_KHR_swapchain.
+auto required_device_extensions(const DeviceCapabilities &capabilities)
+    -> std::vector<const char *>;
+
+void log_capabilities(const DeviceCapabilities &capabilities);
+
+// The VkPhysicalDeviceFeatures2 chain, linked in place. Structures the device
+// does not know about (by API version or missing extension) are left out of
+// the chain.
+struct DeviceFeatureChain {
+    // An empty chain for vkGetPhysicalDeviceFeatures2.
+    DeviceFeatureChain(uint32_t api_version, bool has_present_id,
+                       bool has_present_wait);
+
+    // A chain enabling exactly the given capabilities, for vkCreateDevice.
+    explicit DeviceFeatureChain(const DeviceCapabilities &capabilities);
+
+    NO_COPY(DeviceFeatureChain);
+
+    inline VkPhysicalDeviceFeatures2 *get() { return &features; }
+
+    VkPhysicalDeviceFeatures2 features;
+    VkPhysicalDeviceVulkan11Features vulkan11;
+    VkPhysicalDeviceVulkan12Features vulkan12;
+    VkPhysicalDeviceVulkan13Features vulkan13;
+    VkPhysicalDevicePresentIdFeaturesKHR present_id;
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait;
+
+  private:
+    void link(uint32_t api_version, bool has_present_id,
+              bool has_present_wait);
+};
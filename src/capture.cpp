@@ -0,0 +1,602 @@
+#include "capture.hpp"
+#include "command_encoder.hpp"
+#include "render_graph.hpp"
+#include "trace.hpp"
+
+namespace {
+constexpr std::array<char, 4> CAPTURE_MAGIC{'J', 'C', 'A', 'P'};
+// Version 1 had no LOD chains.
+constexpr uint32_t CAPTURE_VERSION = 2;
+
+template <typename T>
+void write_value(std::ofstream &p_file, const T &p_value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    p_file.write(reinterpret_cast<const char *>(&p_value), sizeof(T));
+}
+
+// A 32-bit element count followed by the elements.
+template <typename T>
+void write_array(std::ofstream &p_file, std::span<const T> p_values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    write_value(p_file, static_cast<uint32_t>(p_values.size()));
+    p_file.write(reinterpret_cast<const char *>(p_values.data()),
+                 static_cast<std::streamsize>(p_values.size_bytes()));
+}
+
+class CaptureReader {
+  public:
+    explicit CaptureReader(std::string_view p_path)
+        : path(p_path), bytes(read_as_bytes(p_path)), offset(0) {}
+
+    template <typename T> auto read() -> T {
+        static_assert(std::is_trivially_copyable_v<T>);
+        require(sizeof(T));
+
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    // Reads an element count, checking that the rest of the file could hold
+    // that many elements of at least `p_element_size` bytes before anything
+    // is sized by it.
+    auto read_count(size_t p_element_size) -> uint32_t {
+        const auto count = read<uint32_t>();
+        require(static_cast<size_t>(count) * p_element_size);
+        return count;
+    }
+
+    template <typename T> auto read_array() -> std::vector<T> {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto count = read_count(sizeof(T));
+
+        std::vector<T> values(count);
+        std::memcpy(values.data(), bytes.data() + offset, count * sizeof(T));
+        offset += count * sizeof(T);
+        return values;
+    }
+
+    inline bool is_done() const { return offset == bytes.size(); }
+
+    [[noreturn]] void invalid(std::string_view p_reason) const {
+        fmt::println("[ERROR]: Invalid capture '{}': {}", path, p_reason);
+        throw Error::InvalidFileError;
+    }
+
+  private:
+    void require(size_t p_size) const {
+        if (bytes.size() - offset < p_size) {
+            invalid("truncated");
+        }
+    }
+
+    std::string_view path;
+    std::vector<char> bytes;
+    size_t offset;
+};
+
+auto average(std::span<const double> p_values) -> double {
+    return std::accumulate(p_values.begin(), p_values.end(), 0.0) /
+           static_cast<double>(std::max<size_t>(p_values.size(), 1));
+}
+
+auto median(std::vector<double> p_values) -> double {
+    if (p_values.empty()) {
+        return 0.0;
+    }
+
+    const auto middle = p_values.begin() + p_values.size() / 2;
+    std::nth_element(p_values.begin(), middle, p_values.end());
+    return *middle;
+}
+} // namespace
+
+void write_capture(std::string_view p_path, const Capture &p_capture) {
+    std::ofstream file{std::string{p_path}, std::ios::binary};
+    if (!file) {
+        fmt::println("[WARNING]: Could not write the capture to '{}'.",
+                     p_path);
+        return;
+    }
+
+    write_value(file, CAPTURE_MAGIC);
+    write_value(file, CAPTURE_VERSION);
+
+    write_value(file, static_cast<uint32_t>(p_capture.color_format));
+    write_value(file, p_capture.extent);
+    write_value(file, static_cast<uint32_t>(p_capture.occlusion_culling));
+
+    write_value(file,
+                static_cast<uint32_t>(p_capture.pipeline.vertex_input));
+    write_array(file, std::span<const char>{
+                          p_capture.pipeline.fragment_shader});
+    write_value(file, static_cast<uint32_t>(p_capture.pipeline.blend));
+
+    write_value(file, static_cast<uint32_t>(p_capture.meshes.size()));
+    for (const auto &mesh : p_capture.meshes) {
+        write_value(file, mesh.placement);
+        write_array(file, std::span{mesh.vertices});
+        write_array(file, std::span{mesh.indices});
+    }
+
+    write_array(file, std::span{p_capture.objects});
+    write_array(file, std::span{p_capture.lod_chains});
+    write_value(file, p_capture.lod_threshold);
+    write_array(file, std::span{p_capture.frames});
+
+    fmt::println("[INFO]: Captured {} frames of {} objects to '{}'",
+                 p_capture.frames.size(), p_capture.objects.size(), p_path);
+}
+
+auto read_capture(std::string_view p_path) -> Capture {
+    CaptureReader reader{p_path};
+
+    if (reader.read<std::array<char, 4>>() != CAPTURE_MAGIC) {
+        reader.invalid("not a capture");
+    }
+    const auto version = reader.read<uint32_t>();
+    if (version == 0 || version > CAPTURE_VERSION) {
+        reader.invalid("unsupported version");
+    }
+
+    Capture capture{};
+    capture.color_format = static_cast<VkFormat>(reader.read<uint32_t>());
+    capture.extent = reader.read<VkExtent2D>();
+    if (capture.extent.width == 0 || capture.extent.height == 0) {
+        reader.invalid("empty extent");
+    }
+    capture.occlusion_culling = reader.read<uint32_t>() != 0;
+
+    const auto vertex_input = reader.read<uint32_t>();
+    if (vertex_input >
+        static_cast<uint32_t>(GraphicsPipeline::VertexInput::Pulled)) {
+        reader.invalid("unknown vertex input");
+    }
+    capture.pipeline.vertex_input =
+        static_cast<GraphicsPipeline::VertexInput>(vertex_input);
+
+    const auto fragment_shader = reader.read_array<char>();
+    capture.pipeline.fragment_shader.assign(fragment_shader.begin(),
+                                            fragment_shader.end());
+
+    const auto blend = reader.read<uint32_t>();
+    if (blend > static_cast<uint32_t>(GraphicsPipeline::Blend::Additive)) {
+        reader.invalid("unknown blend mode");
+    }
+    capture.pipeline.blend = static_cast<GraphicsPipeline::Blend>(blend);
+
+    // A mesh takes at least its placement and two empty array counts.
+    capture.meshes.resize(
+        reader.read_count(sizeof(Mesh) + 2 * sizeof(uint32_t)));
+    for (auto &mesh : capture.meshes) {
+        mesh.placement = reader.read<Mesh>();
+        mesh.vertices = reader.read_array<Vertex>();
+        mesh.indices = reader.read_array<uint32_t>();
+        if (mesh.vertices.empty() || mesh.indices.empty()) {
+            reader.invalid("empty mesh");
+        }
+
+        const auto vertex_count = mesh.vertices.size();
+        if (std::any_of(mesh.indices.begin(), mesh.indices.end(),
+                        [&](uint32_t p_index) {
+                            return p_index >= vertex_count;
+                        })) {
+            reader.invalid("mesh index out of range");
+        }
+    }
+
+    capture.objects = reader.read_array<CullObject>();
+    if (version >= 2) {
+        capture.lod_chains = reader.read_array<LodChain>();
+        capture.lod_threshold = reader.read<float>();
+    }
+    capture.frames = reader.read_array<CapturedFrame>();
+
+    if (capture.lod_chains.size() > CullingPass::LOD_CHAIN_CAPACITY) {
+        reader.invalid("too many LOD chains");
+    }
+    for (const auto &chain : capture.lod_chains) {
+        if (chain.level_count == 0 || chain.level_count > MAX_LOD_LEVELS) {
+            reader.invalid("LOD chain without levels");
+        }
+    }
+
+    // Index ranges, counted from the mesh's first index, have to stay within
+    // the mesh, or replay would read past it on the GPU.
+    const auto is_within = [](uint32_t p_first, uint32_t p_count,
+                              size_t p_size) {
+        return p_first <= p_size && p_count <= p_size - p_first;
+    };
+
+    std::map<std::pair<uint32_t, int32_t>, const CapturedMesh *> meshes;
+    for (const auto &mesh : capture.meshes) {
+        meshes[{mesh.placement.first_index, mesh.placement.vertex_offset}] =
+            &mesh;
+    }
+
+    for (const auto &object : capture.objects) {
+        const auto mesh = meshes.find({object.first_index,
+                                       object.vertex_offset});
+        if (mesh == meshes.end()) {
+            reader.invalid("object without a captured mesh");
+        }
+
+        const auto index_count = mesh->second->indices.size();
+        if (object.index_count > index_count) {
+            reader.invalid("object indices outside its mesh");
+        }
+
+        if (object.lod_chain > capture.lod_chains.size()) {
+            reader.invalid("object with an unknown LOD chain");
+        }
+        if (object.lod_chain == 0) {
+            continue;
+        }
+
+        const auto &chain = capture.lod_chains[object.lod_chain - 1];
+        for (uint32_t i = 0; i < chain.level_count; i++) {
+            const auto &level = chain.levels[i];
+            if (!is_within(level.first_index, level.index_count,
+                           index_count)) {
+                reader.invalid("LOD level outside its object's mesh");
+            }
+        }
+    }
+
+    if (!reader.is_done()) {
+        reader.invalid("trailing data");
+    }
+
+    return capture;
+}
+
+void run_capture_replay(const Device &p_device,
+                        const CommandPool &p_command_pool,
+                        const Capture &p_capture, uint32_t p_iterations) {
+    if (p_capture.frames.empty() || p_capture.objects.empty() ||
+        p_iterations == 0) {
+        fmt::println("[WARNING]: The capture has nothing to replay.");
+        return;
+    }
+
+    // The captured swapchain format may not be renderable here.
+    auto color_format = p_capture.color_format;
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(p_device.get_physical(), color_format,
+                                        &format_properties);
+    if ((format_properties.optimalTilingFeatures &
+         VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT) == 0) {
+        fmt::println("[WARNING]: Replaying to R8G8B8A8_UNORM, since the "
+                     "captured format can not be rendered to.");
+        color_format = VK_FORMAT_R8G8B8A8_UNORM;
+    }
+
+    uint32_t vertex_count = 0;
+    uint32_t index_count = 0;
+    for (const auto &mesh : p_capture.meshes) {
+        vertex_count += static_cast<uint32_t>(mesh.vertices.size());
+        index_count += static_cast<uint32_t>(mesh.indices.size());
+    }
+
+    GeometryHeap geometry{p_device, std::max(vertex_count, 1u),
+                          std::max(index_count, 1u)};
+
+    // Objects are matched to their mesh by the offsets they baked.
+    std::map<std::pair<uint32_t, int32_t>, Mesh> placements;
+    for (const auto &mesh : p_capture.meshes) {
+        const auto id =
+            geometry.add_mesh(p_command_pool, mesh.vertices, mesh.indices);
+        placements[{mesh.placement.first_index,
+                    mesh.placement.vertex_offset}] = geometry.get_mesh(id);
+    }
+
+    auto objects = p_capture.objects;
+    for (auto &object : objects) {
+        const auto placement =
+            placements.find({object.first_index, object.vertex_offset});
+        if (placement == placements.end()) {
+            fmt::println("[ERROR]: A captured object has no captured mesh.");
+            throw Error::InvalidFileError;
+        }
+
+        object.first_index = placement->second.first_index;
+        object.vertex_offset = placement->second.vertex_offset;
+    }
+
+    SamplerCache sampler_cache{p_device};
+    DepthPyramid depth_pyramid{p_device, sampler_cache};
+    CullingPass culling{p_device, static_cast<uint32_t>(objects.size())};
+    culling.set_occlusion_culling(p_capture.occlusion_culling);
+    culling.upload_lod_chains(p_command_pool, p_capture.lod_chains);
+
+    const auto vertex_pulling = p_capture.pipeline.vertex_input ==
+                                GraphicsPipeline::VertexInput::Pulled;
+
+    const std::array push_constant_ranges{
+        VkPushConstantRange{
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .offset = 0,
+            .size = sizeof(GeometryHeap::PushConstants),
+        },
+    };
+
+    std::vector<VkDescriptorSetLayout> descriptor_set_layouts{
+        culling.get_descriptor_set_layout().get()};
+    if (vertex_pulling) {
+        const auto geometry_layouts = geometry.get_descriptor_set_layouts();
+        descriptor_set_layouts.insert(descriptor_set_layouts.end(),
+                                      geometry_layouts.begin(),
+                                      geometry_layouts.end());
+    }
+
+    RenderPass early_render_pass{p_device, color_format,
+                                 RenderPass::Type::Clear};
+    RenderPass late_render_pass{p_device, color_format,
+                                RenderPass::Type::Load};
+    // The vertex shader depends on what this device supports rather than on
+    // the captured one.
+    GraphicsPipeline pipeline{
+        p_device,
+        early_render_pass,
+        vertex_pulling ? geometry.get_pulled_vertex_shader() : "main.vert",
+        p_capture.pipeline.fragment_shader,
+        std::span{push_constant_ranges}.first(vertex_pulling ? 1 : 0),
+        descriptor_set_layouts,
+        p_capture.pipeline.vertex_input,
+        p_capture.pipeline.blend,
+    };
+    pipeline.set_debug_name("Replay");
+
+    Framebuffers framebuffers{p_device};
+    CommandEncoder encoder{VK_NULL_HANDLE};
+    VkExtent2D render_extent{};
+
+    const auto clear_color =
+        p_capture.pipeline.blend == GraphicsPipeline::Blend::Additive
+            ? glm::vec4{0.0, 0.0, 0.0, 1.0}
+            : glm::vec4{1.0, 0.5, 0.5, 1.0};
+
+    const auto draw_phase = [&](const RenderPass &render_pass,
+                                CullingPass::Phase phase) {
+        render_pass.begin(encoder.get(), framebuffers.get(0), render_extent,
+                          clear_color);
+
+        encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.get());
+        encoder.set_viewport(VkViewport{
+            .x = 0,
+            .y = 0,
+            .width = static_cast<float>(render_extent.width),
+            .height = static_cast<float>(render_extent.height),
+            .minDepth = 0,
+            .maxDepth = 1,
+        });
+        encoder.set_scissor(VkRect2D{.offset = {.x = 0, .y = 0},
+                                     .extent = render_extent});
+        encoder.bind_descriptor_set(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                    pipeline.get_layout(), 0,
+                                    culling.get_descriptor_set());
+
+        if (vertex_pulling) {
+            geometry.bind_pulled(encoder, pipeline.get_layout());
+        } else {
+            geometry.bind(encoder);
+        }
+
+        culling.draw(encoder, phase);
+
+        vkCmdEndRenderPass(encoder.get());
+    };
+
+    // The passes of the scene in main, without the upscale to a swapchain.
+    RenderGraph graph{p_device};
+
+    const auto scene_color = graph.create_image(
+        "Scene color",
+        TransientImageInfo{
+            .extent = p_capture.extent,
+            .format = color_format,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        });
+    const auto depth = graph.create_image(
+        "Depth", TransientImageInfo{
+                     .extent = p_capture.extent,
+                     .format = DEPTH_FORMAT,
+                     .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                              VK_IMAGE_USAGE_SAMPLED_BIT,
+                     .aspect = VK_IMAGE_ASPECT_DEPTH_BIT,
+                 });
+    const auto pyramid =
+        graph.import_image("Depth pyramid", VK_NULL_HANDLE,
+                           VK_IMAGE_ASPECT_COLOR_BIT,
+                           ResourceUsage::ComputeWrite);
+
+    const auto object_buffer =
+        graph.import_buffer("Objects", culling.get_object_buffer().get(),
+                            ResourceUsage::ComputeRead);
+    const auto visibility_buffer = graph.import_buffer(
+        "Visibility", culling.get_visibility_buffer().get(),
+        ResourceUsage::ComputeWrite);
+    const auto draw_command_buffer = graph.import_buffer(
+        "Draw commands", culling.get_draw_command_buffer().get(),
+        ResourceUsage::IndirectRead);
+    const auto counter_buffer = graph.import_buffer(
+        "Draw counts", culling.get_counter_buffer().get(),
+        ResourceUsage::TransferRead);
+    const auto statistics_buffer = graph.import_buffer(
+        "Cull statistics", culling.get_statistics_buffer().get(),
+        ResourceUsage::HostRead);
+
+    graph.add_pass(
+        "Reset cull counters",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.use(counter_buffer, ResourceUsage::TransferWrite);
+        },
+        [&](VkCommandBuffer p_command_buffer) {
+            culling.record_reset(p_command_buffer);
+        });
+
+    for (const auto phase :
+         {CullingPass::Phase::Early, CullingPass::Phase::Late}) {
+        const auto early = phase == CullingPass::Phase::Early;
+
+        if (!early) {
+            graph.add_pass(
+                "Depth pyramid",
+                [&](RenderGraph::PassBuilder &pass) {
+                    pass.use(depth, ResourceUsage::ComputeSampled);
+                    pass.use(pyramid, ResourceUsage::ComputeWrite);
+                },
+                [&](VkCommandBuffer p_command_buffer) {
+                    depth_pyramid.record(p_command_buffer);
+                    encoder.invalidate(VK_PIPELINE_BIND_POINT_COMPUTE);
+                });
+        }
+
+        graph.add_pass(
+            early ? "Cull (early)" : "Cull (late)",
+            [&, early](RenderGraph::PassBuilder &pass) {
+                if (!early) {
+                    pass.use(pyramid, ResourceUsage::ComputeRead);
+                }
+                pass.use(object_buffer, ResourceUsage::ComputeRead);
+                pass.use(visibility_buffer, early
+                                                ? ResourceUsage::ComputeRead
+                                                : ResourceUsage::ComputeWrite);
+                pass.use(draw_command_buffer, ResourceUsage::ComputeWrite);
+                pass.use(counter_buffer, ResourceUsage::ComputeWrite);
+            },
+            [&, phase](VkCommandBuffer p_command_buffer) {
+                culling.record_dispatch(p_command_buffer, phase);
+                encoder.invalidate(VK_PIPELINE_BIND_POINT_COMPUTE);
+            });
+
+        graph.add_pass(
+            early ? "Draw (early)" : "Draw (late)",
+            [&, early](RenderGraph::PassBuilder &pass) {
+                pass.use(draw_command_buffer, ResourceUsage::IndirectRead);
+                pass.use(counter_buffer, ResourceUsage::IndirectRead);
+                pass.use(object_buffer, ResourceUsage::VertexShaderRead);
+                pass.use(scene_color, early
+                                          ? ResourceUsage::ColorAttachmentClear
+                                          : ResourceUsage::ColorAttachment);
+                pass.use(depth, early ? ResourceUsage::DepthAttachmentClear
+                                      : ResourceUsage::DepthAttachment);
+            },
+            [&, early](VkCommandBuffer) {
+                draw_phase(early ? early_render_pass : late_render_pass,
+                           early ? CullingPass::Phase::Early
+                                 : CullingPass::Phase::Late);
+            });
+    }
+
+    graph.add_pass(
+        "Copy cull statistics",
+        [&](RenderGraph::PassBuilder &pass) {
+            pass.use(counter_buffer, ResourceUsage::TransferRead);
+            pass.use(statistics_buffer, ResourceUsage::TransferWrite);
+        },
+        [&](VkCommandBuffer p_command_buffer) {
+            culling.record_statistics_copy(p_command_buffer);
+        });
+
+    graph.set_output(scene_color, ResourceUsage::ColorAttachment);
+    graph.set_output(statistics_buffer, ResourceUsage::HostRead);
+    graph.compile();
+
+    const auto &depth_image = graph.get_image(depth);
+    depth_pyramid.create(p_command_pool, depth_image);
+    culling.set_depth_pyramid(depth_pyramid);
+    graph.set_image(pyramid, depth_pyramid.get_image());
+    const std::array color_views{graph.get_image(scene_color).get_view()};
+    framebuffers.create(p_device, early_render_pass, color_views,
+                        depth_image.get_view(), p_capture.extent);
+
+    TimestampQueries timestamps{p_device, 2};
+
+    std::vector<double> gpu_milliseconds;
+    std::vector<double> record_milliseconds;
+    gpu_milliseconds.reserve(p_capture.frames.size() * p_iterations);
+    record_milliseconds.reserve(p_capture.frames.size() * p_iterations);
+
+    fmt::println("[INFO]: Replaying {} frames of {} objects at {}x{}, {} "
+                 "iterations",
+                 p_capture.frames.size(), objects.size(),
+                 p_capture.extent.width, p_capture.extent.height,
+                 p_iterations);
+
+    for (uint32_t iteration = 0; iteration < p_iterations; iteration++) {
+        TRACE_SCOPE("Replay iteration");
+
+        // Starts every iteration with nothing visible, like the capture.
+        culling.upload_objects(p_command_pool, objects);
+
+        double iteration_milliseconds = 0.0;
+        CullStatistics last_statistics{};
+
+        for (const auto &frame : p_capture.frames) {
+            render_extent = VkExtent2D{
+                .width = std::clamp(frame.render_extent.width, 1u,
+                                    p_capture.extent.width),
+                .height = std::clamp(frame.render_extent.height, 1u,
+                                     p_capture.extent.height),
+            };
+            culling.set_viewport_scale(glm::vec2{
+                static_cast<float>(render_extent.width) /
+                    static_cast<float>(p_capture.extent.width),
+                static_cast<float>(render_extent.height) /
+                    static_cast<float>(p_capture.extent.height),
+            });
+            culling.set_lod_selection(LodSelection{
+                .threshold_pixels = p_capture.lod_threshold,
+                .viewport_height = render_extent.height,
+            });
+            culling.update_camera(frame.view_projection);
+
+            const auto record_start = std::chrono::steady_clock::now();
+
+            const auto command_buffer = p_command_pool.begin_one_time();
+            encoder.reset(command_buffer);
+            timestamps.reset(command_buffer);
+            timestamps.write(command_buffer, 0,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+            graph.execute(command_buffer);
+            timestamps.write(command_buffer, 1,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+            record_milliseconds.push_back(
+                std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - record_start)
+                    .count());
+
+            p_command_pool.end_one_time(command_buffer);
+
+            const auto frame_timestamps = timestamps.read(0, 2);
+            const auto milliseconds = timestamps.to_milliseconds(
+                frame_timestamps[0], frame_timestamps[1]);
+            gpu_milliseconds.push_back(milliseconds);
+            iteration_milliseconds += milliseconds;
+
+            last_statistics = culling.read_statistics();
+        }
+
+        // The same counts every iteration show that the replay is
+        // deterministic.
+        fmt::println("[INFO]:   Iteration {}: GPU {:.3f} ms, last frame drew "
+                     "{} early and {} late, {} triangles",
+                     iteration, iteration_milliseconds,
+                     last_statistics.early_draws, last_statistics.late_draws,
+                     last_statistics.triangles);
+    }
+
+    const auto [fastest, slowest] =
+        std::minmax_element(gpu_milliseconds.begin(), gpu_milliseconds.end());
+    fmt::println("[INFO]: GPU per frame: {:.3f} ms average, {:.3f} ms median, "
+                 "{:.3f} ms min, {:.3f} ms max",
+                 average(gpu_milliseconds), median(gpu_milliseconds), *fastest,
+                 *slowest);
+    fmt::println("[INFO]: CPU recording per frame: {:.3f} ms average, {:.3f} "
+                 "ms median",
+                 average(record_milliseconds), median(record_milliseconds));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "culling.hpp"
+
+// What the renderer was asked to draw during a session: the scene it
+// uploaded, the pipeline it drew with and the camera of every frame. Written
+// by --capture and replayed by --replay, so that a workload from the field
+// can be timed again on another machine or build.
+
+struct CapturedMesh {
+    // Where the mesh was in the captured geometry heap. Objects baked these
+    // offsets, and are pointed at the mesh's new place when replayed.
+    Mesh placement;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+struct CapturedPipeline {
+    GraphicsPipeline::VertexInput vertex_input;
+    std::string fragment_shader;
+    GraphicsPipeline::Blend blend;
+};
+
+struct CapturedFrame {
+    glm::mat4 view_projection;
+    // The part of the capture's extent that was drawn to.
+    VkExtent2D render_extent;
+};
+
+struct Capture {
+    VkFormat color_format;
+    VkExtent2D extent;
+    bool occlusion_culling;
+    CapturedPipeline pipeline;
+    std::vector<CapturedMesh> meshes;
+    std::vector<CullObject> objects;
+    // What the objects' `lod_chain` refers to, and the selection threshold.
+    std::vector<LodChain> lod_chains;
+    float lod_threshold;
+    std::vector<CapturedFrame> frames;
+};
+
+// A compact binary file of the structures above in host byte order, so it
+// only replays on machines with the same endianness.
+void write_capture(std::string_view path, const Capture &capture);
+
+auto read_capture(std::string_view path) -> Capture;
+
+// Draws every frame of the capture offscreen `iterations` times, waiting for
+// each frame before recording the next, and prints GPU and CPU timings. The
+// culling visibility is reset before every iteration, so that all of them do
+// the same work.
+void run_capture_replay(const Device &device, const CommandPool &command_pool,
+                        const Capture &capture, uint32_t iterations);
@@ -0,0 +1,68 @@
+#include "command_cache.hpp"
+
+CommandCache::CommandCache(const Device &p_device,
+                           const CommandPool &p_command_pool)
+    : device(p_device), command_pool(p_command_pool), statistics{} {}
+
+CommandCache::~CommandCache() { free(); }
+
+void CommandCache::resize(uint32_t p_image_count) {
+    free();
+
+    command_buffers.reserve(p_image_count);
+    for (uint32_t i = 0; i < p_image_count; i++) {
+        command_buffers.push_back(command_pool.allocate_buffer());
+    }
+
+    recorded.assign(p_image_count, false);
+}
+
+void CommandCache::invalidate() {
+    std::fill(recorded.begin(), recorded.end(), false);
+}
+
+auto CommandCache::get(uint32_t p_image_index,
+                       const std::function<void(VkCommandBuffer)> &p_record)
+    -> VkCommandBuffer {
+    const auto command_buffer = command_buffers.at(p_image_index);
+
+    if (recorded[p_image_index]) {
+        statistics.replayed++;
+        return command_buffer;
+    }
+
+    VK_ERROR(vkResetCommandBuffer(command_buffer, 0));
+
+    // Without the one-time flag, so that it can be submitted again.
+    const VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .pInheritanceInfo = nullptr,
+    };
+
+    VK_ERROR(vkBeginCommandBuffer(command_buffer, &begin_info));
+    p_record(command_buffer);
+    VK_ERROR(vkEndCommandBuffer(command_buffer));
+
+    recorded[p_image_index] = true;
+    statistics.recorded++;
+    return command_buffer;
+}
+
+auto CommandCache::take_statistics() -> CommandCacheStatistics {
+    const auto taken = statistics;
+    statistics = {};
+    return taken;
+}
+
+void CommandCache::free() {
+    if (!command_buffers.empty()) {
+        vkFreeCommandBuffers(device.get(), command_pool.pool,
+                             static_cast<uint32_t>(command_buffers.size()),
+                             command_buffers.data());
+    }
+
+    command_buffers.clear();
+    recorded.clear();
+}
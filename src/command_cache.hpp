@@ -0,0 +1,50 @@
+#pragma once
+
+#include "devices.hpp"
+
+struct CommandCacheStatistics {
+    uint32_t recorded;
+    uint32_t replayed;
+};
+
+// Primary command buffers recorded once per swapchain image and submitted
+// again every time that image comes up. Whatever changes what a frame
+// records, like a resize, another scene or another pipeline, has to
+// `invalidate` them. Per-frame data such as the camera has to be read from
+// memory rather than recorded into them.
+class CommandCache {
+  public:
+    CommandCache(const Device &device, const CommandPool &command_pool);
+
+    NO_COPY(CommandCache);
+
+    ~CommandCache();
+
+    // Frees the command buffers and allocates one for each of `image_count`
+    // images, none of them recorded.
+    void resize(uint32_t image_count);
+
+    // Makes every image record its command buffer again the next time it is
+    // used.
+    void invalidate();
+
+    // The image's command buffer, recorded with `record` first unless it
+    // still holds a valid recording. The command buffer must not be pending.
+    auto get(uint32_t image_index,
+             const std::function<void(VkCommandBuffer)> &record)
+        -> VkCommandBuffer;
+
+    // Returns the counters accumulated since the last call and clears them.
+    auto take_statistics() -> CommandCacheStatistics;
+
+  private:
+    void free();
+
+    const Device &device;
+    const CommandPool &command_pool;
+
+    std::vector<VkCommandBuffer> command_buffers;
+    std::vector<bool> recorded;
+
+    CommandCacheStatistics statistics;
+};
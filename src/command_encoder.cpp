@@ -0,0 +1,217 @@
+#include "command_encoder.hpp"
+
+namespace {
+bool is_same_viewport(const VkViewport &p_a, const VkViewport &p_b) {
+    return p_a.x == p_b.x && p_a.y == p_b.y && p_a.width == p_b.width &&
+           p_a.height == p_b.height && p_a.minDepth == p_b.minDepth &&
+           p_a.maxDepth == p_b.maxDepth;
+}
+
+bool is_same_scissor(const VkRect2D &p_a, const VkRect2D &p_b) {
+    return p_a.offset.x == p_b.offset.x && p_a.offset.y == p_b.offset.y &&
+           p_a.extent.width == p_b.extent.width &&
+           p_a.extent.height == p_b.extent.height;
+}
+} // namespace
+
+auto EncoderStatistics::get_issued() const -> uint32_t {
+    return std::accumulate(issued.begin(), issued.end(), 0u);
+}
+
+auto EncoderStatistics::get_filtered() const -> uint32_t {
+    return std::accumulate(filtered.begin(), filtered.end(), 0u);
+}
+
+CommandEncoder::CommandEncoder(VkCommandBuffer p_command_buffer)
+    : statistics{} {
+    reset(p_command_buffer);
+}
+
+void CommandEncoder::reset(VkCommandBuffer p_command_buffer) {
+    command_buffer = p_command_buffer;
+    bind_points = {};
+    vertex_bindings = {};
+    index_buffer = VK_NULL_HANDLE;
+    index_offset = 0;
+    index_type = VK_INDEX_TYPE_MAX_ENUM;
+    push_constant_layout = VK_NULL_HANDLE;
+    push_constant_stages = 0;
+    push_constant_offset = 0;
+    push_constant_size = 0;
+    viewport.reset();
+    scissor.reset();
+}
+
+void CommandEncoder::invalidate(VkPipelineBindPoint p_bind_point) {
+    get_bind_point(p_bind_point) = {};
+    push_constant_layout = VK_NULL_HANDLE;
+}
+
+void CommandEncoder::bind_pipeline(VkPipelineBindPoint p_bind_point,
+                                   VkPipeline p_pipeline) {
+    auto &state = get_bind_point(p_bind_point);
+    if (!count(EncoderCommand::BindPipeline, state.pipeline == p_pipeline)) {
+        return;
+    }
+
+    vkCmdBindPipeline(command_buffer, p_bind_point, p_pipeline);
+    state.pipeline = p_pipeline;
+}
+
+void CommandEncoder::bind_descriptor_set(VkPipelineBindPoint p_bind_point,
+                                         VkPipelineLayout p_layout,
+                                         uint32_t p_set,
+                                         VkDescriptorSet p_descriptor_set) {
+    auto &state = get_bind_point(p_bind_point);
+
+    // Sets beyond what is shadowed are always bound.
+    if (p_set < MAX_DESCRIPTOR_SETS) {
+        auto &bound = state.sets[p_set];
+        if (!count(EncoderCommand::BindDescriptorSet,
+                   bound.layout == p_layout &&
+                       bound.set == p_descriptor_set)) {
+            return;
+        }
+
+        if (bound.layout != p_layout) {
+            std::fill(state.sets.begin() + p_set + 1, state.sets.end(),
+                      BoundSet{});
+        }
+
+        bound = BoundSet{
+            .layout = p_layout,
+            .set = p_descriptor_set,
+        };
+    } else {
+        count(EncoderCommand::BindDescriptorSet, false);
+    }
+
+    vkCmdBindDescriptorSets(command_buffer, p_bind_point, p_layout, p_set, 1,
+                            &p_descriptor_set, 0, nullptr);
+}
+
+void CommandEncoder::bind_vertex_buffer(uint32_t p_binding, VkBuffer p_buffer,
+                                        VkDeviceSize p_offset) {
+    if (p_binding < MAX_VERTEX_BINDINGS) {
+        auto &bound = vertex_bindings[p_binding];
+        if (!count(EncoderCommand::BindVertexBuffer,
+                   bound.buffer == p_buffer && bound.offset == p_offset)) {
+            return;
+        }
+
+        bound = VertexBinding{
+            .buffer = p_buffer,
+            .offset = p_offset,
+        };
+    } else {
+        count(EncoderCommand::BindVertexBuffer, false);
+    }
+
+    vkCmdBindVertexBuffers(command_buffer, p_binding, 1, &p_buffer,
+                           &p_offset);
+}
+
+void CommandEncoder::bind_index_buffer(VkBuffer p_buffer, VkDeviceSize p_offset,
+                                       VkIndexType p_index_type) {
+    if (!count(EncoderCommand::BindIndexBuffer,
+               index_buffer == p_buffer && index_offset == p_offset &&
+                   index_type == p_index_type)) {
+        return;
+    }
+
+    vkCmdBindIndexBuffer(command_buffer, p_buffer, p_offset, p_index_type);
+    index_buffer = p_buffer;
+    index_offset = p_offset;
+    index_type = p_index_type;
+}
+
+void CommandEncoder::push_constants(VkPipelineLayout p_layout,
+                                    VkShaderStageFlags p_stages,
+                                    uint32_t p_offset, uint32_t p_size,
+                                    const void *p_values) {
+    // Only a push of the same range with the same bytes as the last one is
+    // known to be redundant.
+    const auto redundant =
+        push_constant_layout == p_layout && push_constant_stages == p_stages &&
+        push_constant_offset == p_offset && push_constant_size == p_size &&
+        std::memcmp(push_constant_values.data(), p_values, p_size) == 0;
+
+    if (!count(EncoderCommand::PushConstants, redundant)) {
+        return;
+    }
+
+    vkCmdPushConstants(command_buffer, p_layout, p_stages, p_offset, p_size,
+                       p_values);
+
+    if (p_size <= MAX_PUSH_CONSTANTS_SIZE) {
+        push_constant_layout = p_layout;
+        push_constant_stages = p_stages;
+        push_constant_offset = p_offset;
+        push_constant_size = p_size;
+        std::memcpy(push_constant_values.data(), p_values, p_size);
+    } else {
+        push_constant_layout = VK_NULL_HANDLE;
+    }
+}
+
+void CommandEncoder::set_viewport(const VkViewport &p_viewport) {
+    if (!count(EncoderCommand::SetViewport,
+               viewport && is_same_viewport(*viewport, p_viewport))) {
+        return;
+    }
+
+    vkCmdSetViewport(command_buffer, 0, 1, &p_viewport);
+    viewport = p_viewport;
+}
+
+void CommandEncoder::set_scissor(const VkRect2D &p_scissor) {
+    if (!count(EncoderCommand::SetScissor,
+               scissor && is_same_scissor(*scissor, p_scissor))) {
+        return;
+    }
+
+    vkCmdSetScissor(command_buffer, 0, 1, &p_scissor);
+    scissor = p_scissor;
+}
+
+void CommandEncoder::draw_indexed(uint32_t p_index_count,
+                                  uint32_t p_instance_count,
+                                  uint32_t p_first_index,
+                                  int32_t p_vertex_offset,
+                                  uint32_t p_first_instance) {
+    count(EncoderCommand::Draw, false);
+    vkCmdDrawIndexed(command_buffer, p_index_count, p_instance_count,
+                     p_first_index, p_vertex_offset, p_first_instance);
+}
+
+void CommandEncoder::draw_indexed_indirect_count(
+    VkBuffer p_buffer, VkDeviceSize p_offset, VkBuffer p_count_buffer,
+    VkDeviceSize p_count_offset, uint32_t p_max_draw_count, uint32_t p_stride) {
+    count(EncoderCommand::Draw, false);
+    vkCmdDrawIndexedIndirectCount(command_buffer, p_buffer, p_offset,
+                                  p_count_buffer, p_count_offset,
+                                  p_max_draw_count, p_stride);
+}
+
+auto CommandEncoder::take_statistics() -> EncoderStatistics {
+    const auto taken = statistics;
+    statistics = {};
+    return taken;
+}
+
+auto CommandEncoder::count(EncoderCommand p_command, bool p_redundant)
+    -> bool {
+    const auto index = static_cast<uint32_t>(p_command);
+    if (p_redundant) {
+        statistics.filtered[index]++;
+    } else {
+        statistics.issued[index]++;
+    }
+
+    return !p_redundant;
+}
+
+auto CommandEncoder::get_bind_point(VkPipelineBindPoint p_bind_point)
+    -> BindPointState & {
+    return bind_points[p_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0];
+}
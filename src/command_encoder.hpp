@@ -0,0 +1,128 @@
+#pragma once
+
+#include "common.hpp"
+
+enum class EncoderCommand : uint32_t {
+    BindPipeline,
+    BindDescriptorSet,
+    BindVertexBuffer,
+    BindIndexBuffer,
+    PushConstants,
+    SetViewport,
+    SetScissor,
+    Draw,
+};
+
+constexpr uint32_t ENCODER_COMMAND_COUNT = 8;
+
+struct EncoderStatistics {
+    // Commands that reached the command buffer, and the ones dropped because
+    // they would not have changed anything.
+    std::array<uint32_t, ENCODER_COMMAND_COUNT> issued;
+    std::array<uint32_t, ENCODER_COMMAND_COUNT> filtered;
+
+    auto get_issued() const -> uint32_t;
+    auto get_filtered() const -> uint32_t;
+};
+
+// Records into a command buffer while shadowing the state it binds, so that
+// binding what is already bound costs nothing. Everything recorded between
+// `reset` calls has to go through the encoder, or the encoder has to be told
+// with `invalidate` which state was changed behind its back.
+class CommandEncoder {
+  public:
+    explicit CommandEncoder(VkCommandBuffer command_buffer);
+
+    NO_COPY(CommandEncoder);
+
+    inline VkCommandBuffer get() const { return command_buffer; }
+
+    // Forgets all shadowed state and records into `command_buffer` from now
+    // on, which has just begun recording.
+    void reset(VkCommandBuffer command_buffer);
+
+    // Forgets the pipeline and descriptor sets of one bind point, along with
+    // the push constants, which all bind points share.
+    void invalidate(VkPipelineBindPoint bind_point);
+
+    void bind_pipeline(VkPipelineBindPoint bind_point, VkPipeline pipeline);
+
+    // Binding a set with another layout than before disturbs the sets after
+    // it, which are then bound again even when they did not change.
+    void bind_descriptor_set(VkPipelineBindPoint bind_point,
+                             VkPipelineLayout layout, uint32_t set,
+                             VkDescriptorSet descriptor_set);
+
+    void bind_vertex_buffer(uint32_t binding, VkBuffer buffer,
+                            VkDeviceSize offset);
+    void bind_index_buffer(VkBuffer buffer, VkDeviceSize offset,
+                           VkIndexType index_type);
+
+    void push_constants(VkPipelineLayout layout, VkShaderStageFlags stages,
+                        uint32_t offset, uint32_t size, const void *values);
+
+    void set_viewport(const VkViewport &viewport);
+    void set_scissor(const VkRect2D &scissor);
+
+    // Draws are never redundant, but are counted along with everything else.
+    void draw_indexed(uint32_t index_count, uint32_t instance_count,
+                      uint32_t first_index, int32_t vertex_offset,
+                      uint32_t first_instance);
+    void draw_indexed_indirect_count(VkBuffer buffer, VkDeviceSize offset,
+                                     VkBuffer count_buffer,
+                                     VkDeviceSize count_offset,
+                                     uint32_t max_draw_count, uint32_t stride);
+
+    inline const EncoderStatistics &get_statistics() const {
+        return statistics;
+    }
+
+    // Returns the counters accumulated since the last call and clears them.
+    auto take_statistics() -> EncoderStatistics;
+
+  private:
+    static constexpr uint32_t MAX_DESCRIPTOR_SETS = 8;
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+    // The smallest maxPushConstantsSize the specification allows.
+    static constexpr uint32_t MAX_PUSH_CONSTANTS_SIZE = 128;
+
+    struct BoundSet {
+        VkPipelineLayout layout;
+        VkDescriptorSet set;
+    };
+
+    struct BindPointState {
+        VkPipeline pipeline;
+        std::array<BoundSet, MAX_DESCRIPTOR_SETS> sets;
+    };
+
+    struct VertexBinding {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+    };
+
+    // Counts the command and returns whether it has to be recorded.
+    auto count(EncoderCommand command, bool redundant) -> bool;
+
+    auto get_bind_point(VkPipelineBindPoint bind_point) -> BindPointState &;
+
+    VkCommandBuffer command_buffer;
+    EncoderStatistics statistics;
+
+    // Graphics and compute.
+    std::array<BindPointState, 2> bind_points;
+
+    std::array<VertexBinding, MAX_VERTEX_BINDINGS> vertex_bindings;
+    VkBuffer index_buffer;
+    VkDeviceSize index_offset;
+    VkIndexType index_type;
+
+    VkPipelineLayout push_constant_layout;
+    VkShaderStageFlags push_constant_stages;
+    uint32_t push_constant_offset;
+    uint32_t push_constant_size;
+    std::array<std::byte, MAX_PUSH_CONSTANTS_SIZE> push_constant_values;
+
+    std::optional<VkViewport> viewport;
+    std::optional<VkRect2D> scissor;
+};
@@ -103,6 +103,18 @@ fmt::formatter<Error>::format(Error p_result, format_context &p_ctx) const {
     case Error::FileOpenError:
         result = "Error::FileOpenError";
         break;
+    case Error::InvalidFileError:
+        result = "Error::InvalidFileError";
+        break;
+    case Error::UnsupportedFormatError:
+        result = "Error::UnsupportedFormatError";
+        break;
+    case Error::ShaderNotFoundError:
+        result = "Error::ShaderNotFoundError";
+        break;
+    case Error::OutOfMemoryError:
+        result = "Error::OutOfMemoryError";
+        break;
     }
 
     return fmt::formatter<std::string_view>::format(result, p_ctx);
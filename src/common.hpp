@@ -6,6 +6,10 @@ enum class Error {
     VulkanError,
     NoAdequatePhysicalDeviceError,
     FileOpenError,
+    InvalidFileError,
+    UnsupportedFormatError,
+    ShaderNotFoundError,
+    OutOfMemoryError,
 };
 
 template <> struct fmt::formatter<VkResult> : fmt::formatter<std::string_view> {
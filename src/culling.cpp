@@ -0,0 +1,430 @@
+#include "queries.hpp"
+
+#include "culling.hpp"
+
+namespace {
+constexpr uint32_t WORKGROUP_SIZE = 64;
+
+// Matches the std140 layout of `Camera` in cull.comp.
+struct CullUniforms {
+    glm::mat4 view_projection;
+    std::array<glm::vec4, 6> planes;
+    glm::vec2 pyramid_size;
+    uint32_t pyramid_levels;
+    uint32_t object_count;
+    uint32_t capacity;
+    uint32_t occlusion_culling;
+    glm::vec2 viewport_scale;
+    // Turns an object-space error at a view depth of one into pixels.
+    float lod_scale;
+    float lod_threshold;
+};
+
+constexpr auto storage_binding(uint32_t binding, VkShaderStageFlags stages) {
+    return VkDescriptorSetLayoutBinding{
+        .binding = binding,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = stages,
+        .pImmutableSamplers = nullptr,
+    };
+}
+
+constexpr std::array cull_bindings{
+    storage_binding(0,
+                    VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT),
+    storage_binding(1, VK_SHADER_STAGE_COMPUTE_BIT),
+    storage_binding(2, VK_SHADER_STAGE_COMPUTE_BIT),
+    storage_binding(3, VK_SHADER_STAGE_COMPUTE_BIT),
+    VkDescriptorSetLayoutBinding{
+        .binding = 4,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .pImmutableSamplers = nullptr,
+    },
+    VkDescriptorSetLayoutBinding{
+        .binding = 5,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorCount = 1,
+        // The scene's vertex shaders read the view-projection from it.
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
+        .pImmutableSamplers = nullptr,
+    },
+    storage_binding(6, VK_SHADER_STAGE_COMPUTE_BIT),
+};
+
+constexpr std::array cull_pool_sizes{
+    VkDescriptorPoolSize{
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 5,
+    },
+    VkDescriptorPoolSize{
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+    },
+    VkDescriptorPoolSize{
+        .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorCount = 1,
+    },
+};
+
+constexpr std::array cull_push_constant_ranges{
+    VkPushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(uint32_t),
+    },
+};
+
+void *map_whole(const Device &p_device, const Buffer &p_buffer) {
+    void *data;
+    VK_ERROR(vkMapMemory(p_device.get(), p_buffer.get_memory(), 0,
+                         p_buffer.get_size(), 0, &data));
+    return data;
+}
+} // namespace
+
+auto extract_frustum_planes(const glm::mat4 &p_view_projection)
+    -> std::array<glm::vec4, 6> {
+    const auto row = [&](int i) {
+        return glm::vec4{p_view_projection[0][i], p_view_projection[1][i],
+                         p_view_projection[2][i], p_view_projection[3][i]};
+    };
+
+    std::array planes{
+        row(3) + row(0), row(3) - row(0), row(3) + row(1),
+        row(3) - row(1), row(2),          row(3) - row(2),
+    };
+
+    for (auto &plane : planes) {
+        plane /= glm::length(glm::vec3{plane});
+    }
+
+    return planes;
+}
+
+auto make_object_grid(uint32_t p_count, const Mesh &p_mesh, JobSystem *p_jobs,
+                      uint32_t p_lod_chain) -> std::vector<CullObject> {
+    constexpr float SPACING = 3.0f;
+    constexpr uint32_t BATCH_SIZE = 4096;
+
+    const auto side = static_cast<uint32_t>(
+        std::ceil(std::cbrt(static_cast<double>(p_count))));
+    const auto half_extent = static_cast<float>(side) * SPACING * 0.5f;
+
+    std::vector<CullObject> objects(p_count);
+
+    const auto place = [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i < end; i++) {
+            const auto x = static_cast<float>(i % side) * SPACING - half_extent;
+            const auto y =
+                static_cast<float>((i / side) % side) * SPACING - half_extent;
+            const auto z = -static_cast<float>(i / (side * side)) * SPACING;
+
+            objects[i] = CullObject{
+                .transform =
+                    glm::translate(glm::mat4{1.0f}, glm::vec3{x, y, z}),
+                // The unit quad fits in a sphere of radius sqrt(0.5).
+                .bounding_sphere = glm::vec4{0.0f, 0.0f, 0.0f, 0.7072f},
+                .index_count = p_mesh.index_count,
+                .first_index = p_mesh.first_index,
+                .vertex_offset = p_mesh.vertex_offset,
+                .lod_chain = p_lod_chain,
+            };
+        }
+    };
+
+    if (p_jobs != nullptr) {
+        p_jobs->parallel_for(p_count, BATCH_SIZE, place);
+    } else {
+        place(0, p_count);
+    }
+
+    return objects;
+}
+
+CullingPass::CullingPass(const Device &p_device, uint32_t p_capacity)
+    : device(p_device), capacity(std::max(p_capacity, 1u)), object_count(0),
+      occlusion_culling(true), viewport_scale{1.0f},
+      lod_selection{.threshold_pixels = 0.0f, .viewport_height = 1},
+      pyramid_extent{1, 1}, pyramid_levels(1),
+      object_buffer(p_device, capacity * sizeof(CullObject),
+                    Buffer::Type::Storage),
+      // The early and late phases each get their own half of the commands.
+      draw_command_buffer(p_device,
+                          2 * capacity * sizeof(VkDrawIndexedIndirectCommand),
+                          Buffer::Type::Indirect),
+      counter_buffer(p_device, sizeof(CullStatistics), Buffer::Type::Indirect),
+      visibility_buffer(p_device, capacity * sizeof(uint32_t),
+                        Buffer::Type::Storage),
+      camera_buffer(p_device, sizeof(CullUniforms), Buffer::Type::Uniform),
+      statistics_buffer(p_device, sizeof(CullStatistics),
+                        Buffer::Type::Readback),
+      lod_chain_buffer(p_device, LOD_CHAIN_CAPACITY * sizeof(LodChain),
+                       Buffer::Type::Storage),
+      camera_data(map_whole(p_device, camera_buffer)),
+      statistics_data(map_whole(p_device, statistics_buffer)),
+      descriptor_set_layout(p_device, cull_bindings),
+      descriptor_pool(p_device, cull_pool_sizes, 1),
+      descriptor_set(descriptor_pool.allocate(descriptor_set_layout)),
+      pipeline(p_device, "cull.comp", cull_push_constant_ranges,
+               std::array{descriptor_set_layout.get()}) {
+    object_buffer.set_debug_name("Cull objects");
+    draw_command_buffer.set_debug_name("Cull draw commands");
+    counter_buffer.set_debug_name("Cull counters");
+    visibility_buffer.set_debug_name("Cull visibility");
+    camera_buffer.set_debug_name("Cull camera");
+    statistics_buffer.set_debug_name("Cull statistics");
+    lod_chain_buffer.set_debug_name("Cull LOD chains");
+    pipeline.set_debug_name("Cull");
+
+    write_storage_buffer(device, descriptor_set, 0, object_buffer);
+    write_storage_buffer(device, descriptor_set, 1, draw_command_buffer);
+    write_storage_buffer(device, descriptor_set, 2, counter_buffer);
+    write_storage_buffer(device, descriptor_set, 3, visibility_buffer);
+    write_uniform_buffer(device, descriptor_set, 5, camera_buffer);
+    write_storage_buffer(device, descriptor_set, 6, lod_chain_buffer);
+
+    std::memset(statistics_data, 0, sizeof(CullStatistics));
+}
+
+void CullingPass::upload_objects(const CommandPool &p_command_pool,
+                                 std::span<const CullObject> p_objects) {
+    object_count = static_cast<uint32_t>(
+        std::min(p_objects.size(), static_cast<size_t>(capacity)));
+
+    if (object_count == 0) {
+        return;
+    }
+
+    object_buffer.load_using_staging(p_command_pool, p_objects.data(),
+                                     object_count * sizeof(CullObject));
+
+    const auto command_buffer = p_command_pool.begin_one_time();
+    vkCmdFillBuffer(command_buffer, visibility_buffer.get(), 0, VK_WHOLE_SIZE,
+                    0);
+    p_command_pool.end_one_time(command_buffer);
+}
+
+void CullingPass::upload_lod_chains(const CommandPool &p_command_pool,
+                                    std::span<const LodChain> p_chains) {
+    if (p_chains.size() > LOD_CHAIN_CAPACITY) {
+        fmt::println("[ERROR]: {} LOD chains, the culling pass holds {}.",
+                     p_chains.size(), LOD_CHAIN_CAPACITY);
+        throw Error::OutOfMemoryError;
+    }
+
+    if (!p_chains.empty()) {
+        lod_chain_buffer.load_using_staging(p_command_pool, p_chains.data(),
+                                            p_chains.size_bytes());
+    }
+}
+
+void CullingPass::set_depth_pyramid(const DepthPyramid &p_depth_pyramid) {
+    pyramid_extent = p_depth_pyramid.get_extent();
+    pyramid_levels = p_depth_pyramid.get_mip_levels();
+
+    write_combined_image_sampler(device, descriptor_set, 4,
+                                 p_depth_pyramid.get_sampler(),
+                                 p_depth_pyramid.get_view(),
+                                 VK_IMAGE_LAYOUT_GENERAL);
+}
+
+void CullingPass::update_camera(const glm::mat4 &p_view_projection) {
+    // The view is rigid, so the length of the second row's xyz is the
+    // projection's vertical scale, whatever the camera's orientation.
+    const auto projection_scale =
+        glm::length(glm::vec3{p_view_projection[0][1], p_view_projection[1][1],
+                              p_view_projection[2][1]});
+
+    const CullUniforms uniforms{
+        .view_projection = p_view_projection,
+        .planes = extract_frustum_planes(p_view_projection),
+        .pyramid_size = glm::vec2{pyramid_extent.width, pyramid_extent.height},
+        .pyramid_levels = pyramid_levels,
+        .object_count = object_count,
+        .capacity = capacity,
+        .occlusion_culling = occlusion_culling ? 1u : 0u,
+        .viewport_scale = viewport_scale,
+        .lod_scale = projection_scale * 0.5f *
+                     static_cast<float>(lod_selection.viewport_height),
+        .lod_threshold = lod_selection.threshold_pixels,
+    };
+
+    std::memcpy(camera_data, &uniforms, sizeof(uniforms));
+}
+
+void CullingPass::record(VkCommandBuffer p_command_buffer,
+                         Phase p_phase) const {
+    const DebugLabel label{device, p_command_buffer,
+                           p_phase == Phase::Early ? "Cull (early)"
+                                                   : "Cull (late)"};
+
+    if (p_phase == Phase::Early) {
+        record_reset(p_command_buffer);
+    }
+
+    // Orders the counter reset and the previous phase's visibility reads
+    // before this phase's writes.
+    const VkMemoryBarrier before_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask =
+            VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+
+    vkCmdPipelineBarrier(p_command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &before_barrier, 0, nullptr, 0, nullptr);
+
+    record_dispatch(p_command_buffer, p_phase);
+
+    const VkMemoryBarrier cull_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask =
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+    };
+
+    vkCmdPipelineBarrier(p_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &cull_barrier, 0, nullptr, 0, nullptr);
+
+    if (p_phase == Phase::Late) {
+        record_statistics_copy(p_command_buffer);
+    }
+}
+
+void CullingPass::record_reset(VkCommandBuffer p_command_buffer) const {
+    vkCmdFillBuffer(p_command_buffer, counter_buffer.get(), 0, VK_WHOLE_SIZE,
+                    0);
+}
+
+void CullingPass::record_dispatch(VkCommandBuffer p_command_buffer,
+                                  Phase p_phase) const {
+    const auto phase = static_cast<uint32_t>(p_phase);
+
+    vkCmdBindPipeline(p_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      pipeline.get());
+    vkCmdBindDescriptorSets(p_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipeline.get_layout(), 0, 1, &descriptor_set, 0,
+                            nullptr);
+    vkCmdPushConstants(p_command_buffer, pipeline.get_layout(),
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(phase), &phase);
+    vkCmdDispatch(p_command_buffer,
+                  (object_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+}
+
+void CullingPass::record_statistics_copy(
+    VkCommandBuffer p_command_buffer) const {
+    const VkBufferCopy copy_region{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = sizeof(CullStatistics),
+    };
+
+    vkCmdCopyBuffer(p_command_buffer, counter_buffer.get(),
+                    statistics_buffer.get(), 1, &copy_region);
+}
+
+void CullingPass::draw(CommandEncoder &p_encoder, Phase p_phase) const {
+    const auto phase = static_cast<uint32_t>(p_phase);
+
+    p_encoder.draw_indexed_indirect_count(
+        draw_command_buffer.get(),
+        phase * capacity * sizeof(VkDrawIndexedIndirectCommand),
+        counter_buffer.get(), phase * sizeof(uint32_t), capacity,
+        sizeof(VkDrawIndexedIndirectCommand));
+}
+
+auto CullingPass::read_statistics() const -> CullStatistics {
+    CullStatistics statistics;
+    std::memcpy(&statistics, statistics_data, sizeof(statistics));
+    return statistics;
+}
+
+void run_culling_benchmark(const Device &p_device,
+                           const CommandPool &p_command_pool) {
+    constexpr std::array object_counts{1u << 10, 1u << 12, 1u << 14,
+                                       1u << 16, 1u << 18, 1u << 20};
+    constexpr uint32_t ITERATIONS = 16;
+
+    auto projection =
+        glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    projection[1][1] *= -1.0f;
+    const auto view = glm::lookAt(glm::vec3{0.0f, 0.0f, 5.0f},
+                                  glm::vec3{0.0f, 0.0f, 0.0f},
+                                  glm::vec3{0.0f, 1.0f, 0.0f});
+    const auto view_projection = projection * view;
+
+    // The pyramid is only cleared, so the occlusion test runs in full but
+    // rejects nothing.
+    Image depth{p_device,
+                {1280, 720},
+                DEPTH_FORMAT,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                    VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_IMAGE_ASPECT_DEPTH_BIT};
+    SamplerCache sampler_cache{p_device};
+    DepthPyramid depth_pyramid{p_device, sampler_cache};
+    depth_pyramid.create(p_command_pool, depth);
+
+    TimestampQueries queries{p_device, 3};
+
+    fmt::println("[INFO]: GPU culling benchmark ({} iterations)", ITERATIONS);
+
+    for (const auto count : object_counts) {
+        CullingPass culling{p_device, count};
+
+        // Only the bounds matter to culling, not the geometry behind them.
+        const Mesh quad{
+            .first_index = 0,
+            .index_count = 6,
+            .vertex_offset = 0,
+            .vertex_count = 4,
+        };
+        const auto objects = make_object_grid(count, quad);
+        culling.upload_objects(p_command_pool, objects);
+        culling.set_depth_pyramid(depth_pyramid);
+        culling.update_camera(view_projection);
+
+        double early_milliseconds = 0.0;
+        double late_milliseconds = 0.0;
+
+        for (uint32_t i = 0; i < ITERATIONS; i++) {
+            const auto command_buffer = p_command_pool.begin_one_time();
+
+            queries.reset(command_buffer);
+            queries.write(command_buffer, 0,
+                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+            culling.record(command_buffer, CullingPass::Phase::Early);
+            queries.write(command_buffer, 1,
+                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+            culling.record(command_buffer, CullingPass::Phase::Late);
+            queries.write(command_buffer, 2,
+                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+            p_command_pool.end_one_time(command_buffer);
+
+            const auto timestamps = queries.read(0, 3);
+            early_milliseconds +=
+                queries.to_milliseconds(timestamps[0], timestamps[1]);
+            late_milliseconds +=
+                queries.to_milliseconds(timestamps[1], timestamps[2]);
+        }
+
+        const auto statistics = culling.read_statistics();
+
+        fmt::println("[INFO]: {:>8} objects: early {:.4f} ms, late {:.4f} ms "
+                     "({} frustum culled)",
+                     count, early_milliseconds / ITERATIONS,
+                     late_milliseconds / ITERATIONS,
+                     statistics.frustum_culled);
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "buffers.hpp"
+#include "depth_pyramid.hpp"
+#include "descriptors.hpp"
+#include "geometry.hpp"
+#include "graphics.hpp"
+#include "jobs.hpp"
+#include "lod.hpp"
+
+// Per-object data read by the culling shader and the vertex shader. Matches
+// the std430 layout of `Object` in cull.comp and main.vert.
+struct CullObject {
+    glm::mat4 transform;
+    // Object-space center in xyz and radius in w.
+    glm::vec4 bounding_sphere;
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    // One more than the index of the object's chain among the culling pass's
+    // LOD chains, or zero to always draw the indices above. With a chain,
+    // `first_index` and `index_count` are the full-detail level.
+    uint32_t lod_chain;
+};
+
+// Counters written by the culling shader during a frame. Matches the layout
+// of `Counters` in cull.comp.
+struct CullStatistics {
+    // Objects drawn in the early phase because they were visible last frame.
+    uint32_t early_draws;
+    // Objects that became visible this frame, drawn in the late phase.
+    uint32_t late_draws;
+    uint32_t frustum_culled;
+    uint32_t occlusion_culled;
+    // Drawn in both phases, at the selected levels of detail.
+    uint32_t triangles;
+};
+
+// How the culling pass picks the level of detail of objects with a LOD
+// chain: the coarsest level whose error projects to at most
+// `threshold_pixels` on a viewport `viewport_height` pixels high. A threshold
+// of zero always draws full detail.
+struct LodSelection {
+    float threshold_pixels;
+    uint32_t viewport_height;
+};
+
+// Returns the six normalized planes (left, right, bottom, top, near, far) of
+// the frustum of a [0, 1] depth range view-projection matrix.
+auto extract_frustum_planes(const glm::mat4 &view_projection)
+    -> std::array<glm::vec4, 6>;
+
+// Places `count` copies of a mesh on a regular 3D grid in front of the origin,
+// looking down -Z. Spread over the job system's threads when one is given.
+// The mesh has to fit in a sphere of radius sqrt(0.5), like the unit quad.
+auto make_object_grid(uint32_t count, const Mesh &mesh,
+                      JobSystem *jobs = nullptr, uint32_t lod_chain = 0)
+    -> std::vector<CullObject>;
+
+// Culls objects on the GPU and compacts the visible ones into indirect draw
+// buffers, so the CPU cost of a frame does not depend on the number of
+// objects.
+//
+// Culling runs in two phases around a depth pyramid:
+//  - Early: objects that were visible last frame and are inside the frustum
+//    are drawn straight away.
+//  - Late: after the pyramid has been built from the early depth, every
+//    object in the frustum is tested for occlusion. Visible ones that were not
+//    drawn early are drawn now, and the result becomes next frame's
+//    visibility.
+//
+// Objects with a LOD chain are drawn at the level their distance calls for,
+// which is picked in both phases.
+class CullingPass {
+  public:
+    enum class Phase : uint32_t { Early = 0, Late = 1 };
+
+    static constexpr uint32_t LOD_CHAIN_CAPACITY = 64;
+
+    CullingPass(const Device &device, uint32_t capacity);
+
+    NO_COPY(CullingPass);
+
+    // Uploads the objects and marks all of them as not visible.
+    void upload_objects(const CommandPool &command_pool,
+                        std::span<const CullObject> objects);
+
+    // Objects refer to the chains by their position in `chains`. Throws
+    // Error::OutOfMemoryError when there are more than LOD_CHAIN_CAPACITY.
+    void upload_lod_chains(const CommandPool &command_pool,
+                           std::span<const LodChain> chains);
+
+    // Must be called again whenever the pyramid is recreated.
+    void set_depth_pyramid(const DepthPyramid &depth_pyramid);
+
+    // Only call while the GPU is not using the culling pass, e.g. after
+    // waiting for the frame fence.
+    void update_camera(const glm::mat4 &view_projection);
+
+    inline void set_occlusion_culling(bool enabled) {
+        occlusion_culling = enabled;
+    }
+
+    // The part of the depth image the scene is drawn to, as a fraction of its
+    // extent, when rendering at a lower resolution. Takes effect with the
+    // next `update_camera`.
+    inline void set_viewport_scale(glm::vec2 scale) { viewport_scale = scale; }
+
+    // Takes effect with the next `update_camera`.
+    inline void set_lod_selection(const LodSelection &selection) {
+        lod_selection = selection;
+    }
+
+    // Records the culling dispatch of a phase, together with the counter
+    // reset before the early phase, the statistics copy after the late phase
+    // and the barriers around them. Must be recorded outside of a render pass,
+    // and the late phase after the depth pyramid was built.
+    void record(VkCommandBuffer command_buffer, Phase phase) const;
+
+    // The steps of `record` without any barriers, for callers that
+    // synchronize themselves (like the render graph). `record_reset` has to
+    // come before the early phase and `record_statistics_copy` after the late
+    // one.
+    void record_reset(VkCommandBuffer command_buffer) const;
+    void record_dispatch(VkCommandBuffer command_buffer, Phase phase) const;
+    void record_statistics_copy(VkCommandBuffer command_buffer) const;
+
+    // Draws the objects that survived a phase with the currently bound
+    // graphics pipeline, vertex and index buffers.
+    void draw(CommandEncoder &encoder, Phase phase) const;
+
+    // The counters of the last frame whose late phase has completed.
+    auto read_statistics() const -> CullStatistics;
+
+    inline const DescriptorSetLayout &get_descriptor_set_layout() const {
+        return descriptor_set_layout;
+    }
+
+    inline VkDescriptorSet get_descriptor_set() const { return descriptor_set; }
+
+    inline uint32_t get_object_count() const { return object_count; }
+
+    inline const Buffer &get_object_buffer() const { return object_buffer; }
+
+    inline const Buffer &get_draw_command_buffer() const {
+        return draw_command_buffer;
+    }
+
+    inline const Buffer &get_counter_buffer() const { return counter_buffer; }
+
+    inline const Buffer &get_visibility_buffer() const {
+        return visibility_buffer;
+    }
+
+    inline const Buffer &get_statistics_buffer() const {
+        return statistics_buffer;
+    }
+
+  private:
+    const Device &device;
+
+    uint32_t capacity;
+    uint32_t object_count;
+    bool occlusion_culling;
+    glm::vec2 viewport_scale;
+    LodSelection lod_selection;
+
+    VkExtent2D pyramid_extent;
+    uint32_t pyramid_levels;
+
+    Buffer object_buffer;
+    Buffer draw_command_buffer;
+    Buffer counter_buffer;
+    Buffer visibility_buffer;
+    Buffer camera_buffer;
+    Buffer statistics_buffer;
+    Buffer lod_chain_buffer;
+
+    void *camera_data;
+    void *statistics_data;
+
+    DescriptorSetLayout descriptor_set_layout;
+    DescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_set;
+
+    ComputePipeline pipeline;
+};
+
+// Measures the GPU time of both culling phases for increasing object counts
+// and prints the results.
+void run_culling_benchmark(const Device &device,
+                           const CommandPool &command_pool);
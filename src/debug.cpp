@@ -0,0 +1,146 @@
+#include "devices.hpp"
+
+#include "debug.hpp"
+
+#ifdef JUBES_DEBUG_UTILS
+
+namespace {
+VKAPI_ATTR VkBool32 VKAPI_CALL
+debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT p_severity,
+               VkDebugUtilsMessageTypeFlagsEXT,
+               const VkDebugUtilsMessengerCallbackDataEXT *p_data, void *) {
+    const auto prefix =
+        (p_severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+            ? "[VALIDATION ERROR]"
+            : "[VALIDATION WARNING]";
+
+    fmt::println("{}: {}", prefix, p_data->pMessage);
+    return VK_FALSE;
+}
+} // namespace
+
+bool is_debug_utils_supported() {
+    uint32_t extension_count;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extension_count,
+                                           extensions.data());
+
+    for (const auto &extension : extensions) {
+        if (std::string_view{extension.extensionName} ==
+            std::string_view{VK_EXT_DEBUG_UTILS_EXTENSION_NAME}) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto debug_messenger_info() -> VkDebugUtilsMessengerCreateInfoEXT {
+    return VkDebugUtilsMessengerCreateInfoEXT{
+        .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
+        .pNext = nullptr,
+        .flags = 0,
+        .messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+        .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+                       VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                       VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+        .pfnUserCallback = debug_callback,
+        .pUserData = nullptr,
+    };
+}
+
+auto load_debug_utils(VkInstance p_instance) -> DebugUtils {
+    DebugUtils debug_utils{};
+
+    const auto create_messenger =
+        reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
+            vkGetInstanceProcAddr(p_instance,
+                                  "vkCreateDebugUtilsMessengerEXT"));
+
+    if (create_messenger != nullptr) {
+        const auto messenger_info = debug_messenger_info();
+        VK_ERROR(create_messenger(p_instance, &messenger_info, nullptr,
+                                  &debug_utils.messenger));
+    }
+
+    debug_utils.set_object_name =
+        reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(
+            vkGetInstanceProcAddr(p_instance, "vkSetDebugUtilsObjectNameEXT"));
+    debug_utils.cmd_begin_label =
+        reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(
+            vkGetInstanceProcAddr(p_instance, "vkCmdBeginDebugUtilsLabelEXT"));
+    debug_utils.cmd_end_label =
+        reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(
+            vkGetInstanceProcAddr(p_instance, "vkCmdEndDebugUtilsLabelEXT"));
+
+    return debug_utils;
+}
+
+void destroy_debug_utils(VkInstance p_instance,
+                         const DebugUtils &p_debug_utils) {
+    if (p_debug_utils.messenger == VK_NULL_HANDLE) {
+        return;
+    }
+
+    const auto destroy_messenger =
+        reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
+            vkGetInstanceProcAddr(p_instance,
+                                  "vkDestroyDebugUtilsMessengerEXT"));
+
+    if (destroy_messenger != nullptr) {
+        destroy_messenger(p_instance, p_debug_utils.messenger, nullptr);
+    }
+}
+
+void set_debug_name(const Device &p_device, VkObjectType p_type,
+                    uint64_t p_handle, std::string_view p_name) {
+    const auto &debug_utils = p_device.get_debug_utils();
+    if (debug_utils.set_object_name == nullptr) {
+        return;
+    }
+
+    const std::string name{p_name};
+
+    const VkDebugUtilsObjectNameInfoEXT name_info{
+        .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+        .pNext = nullptr,
+        .objectType = p_type,
+        .objectHandle = p_handle,
+        .pObjectName = name.c_str(),
+    };
+
+    debug_utils.set_object_name(p_device.get(), &name_info);
+}
+
+DebugLabel::DebugLabel(const Device &p_device,
+                       VkCommandBuffer p_command_buffer,
+                       std::string_view p_name)
+    : device(p_device), command_buffer(p_command_buffer) {
+    const auto &debug_utils = device.get_debug_utils();
+    if (debug_utils.cmd_begin_label == nullptr) {
+        return;
+    }
+
+    const std::string name{p_name};
+
+    const VkDebugUtilsLabelEXT label{
+        .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
+        .pNext = nullptr,
+        .pLabelName = name.c_str(),
+        .color = {0.0f, 0.0f, 0.0f, 0.0f},
+    };
+
+    debug_utils.cmd_begin_label(command_buffer, &label);
+}
+
+DebugLabel::~DebugLabel() {
+    const auto &debug_utils = device.get_debug_utils();
+    if (debug_utils.cmd_end_label != nullptr) {
+        debug_utils.cmd_end_label(command_buffer);
+    }
+}
+
+#endif
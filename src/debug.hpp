@@ -0,0 +1,77 @@
+#pragma once
+
+#include "common.hpp"
+
+class Device;
+
+// Validation, the debug messenger, object names and command buffer labels are
+// only compiled in when JUBES_DEBUG_UTILS is defined (every configuration but
+// Release and MinSizeRel by default). Without it every helper below is an
+// empty inline function and the extension is never enabled.
+#ifdef JUBES_DEBUG_UTILS
+constexpr bool DEBUG_UTILS_ENABLED = true;
+#else
+constexpr bool DEBUG_UTILS_ENABLED = false;
+#endif
+
+// Entry points of VK_EXT_debug_utils. All of them are null when the extension
+// is not available at runtime.
+struct DebugUtils {
+    VkDebugUtilsMessengerEXT messenger = VK_NULL_HANDLE;
+    PFN_vkSetDebugUtilsObjectNameEXT set_object_name = nullptr;
+    PFN_vkCmdBeginDebugUtilsLabelEXT cmd_begin_label = nullptr;
+    PFN_vkCmdEndDebugUtilsLabelEXT cmd_end_label = nullptr;
+};
+
+template <typename Handle> inline uint64_t to_debug_handle(Handle handle) {
+    if constexpr (std::is_pointer_v<Handle>) {
+        return reinterpret_cast<uint64_t>(handle);
+    } else {
+        return static_cast<uint64_t>(handle);
+    }
+}
+
+#ifdef JUBES_DEBUG_UTILS
+
+bool is_debug_utils_supported();
+
+// Routes validation warnings and errors to the log. Also chained into
+// vkCreateInstance so that instance creation itself is covered.
+auto debug_messenger_info() -> VkDebugUtilsMessengerCreateInfoEXT;
+
+auto load_debug_utils(VkInstance instance) -> DebugUtils;
+
+void destroy_debug_utils(VkInstance instance, const DebugUtils &debug_utils);
+
+void set_debug_name(const Device &device, VkObjectType type, uint64_t handle,
+                    std::string_view name);
+
+// Marks the commands recorded during its lifetime as one named region, which
+// shows up in RenderDoc, Perfetto and validation messages.
+class DebugLabel {
+  public:
+    DebugLabel(const Device &device, VkCommandBuffer command_buffer,
+               std::string_view name);
+
+    NO_COPY(DebugLabel);
+
+    ~DebugLabel();
+
+  private:
+    const Device &device;
+    VkCommandBuffer command_buffer;
+};
+
+#else
+
+inline void set_debug_name(const Device &, VkObjectType, uint64_t,
+                           std::string_view) {}
+
+class DebugLabel {
+  public:
+    inline DebugLabel(const Device &, VkCommandBuffer, std::string_view) {}
+
+    NO_COPY(DebugLabel);
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "depth_pyramid.hpp"
+
+namespace {
+constexpr uint32_t MAX_LEVELS = 16;
+constexpr uint32_t WORKGROUP_SIZE = 8;
+
+constexpr std::array pyramid_bindings{
+    VkDescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .pImmutableSamplers = nullptr,
+    },
+    VkDescriptorSetLayoutBinding{
+        .binding = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .pImmutableSamplers = nullptr,
+    },
+};
+
+constexpr std::array pyramid_pool_sizes{
+    VkDescriptorPoolSize{
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = MAX_LEVELS,
+    },
+    VkDescriptorPoolSize{
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        .descriptorCount = MAX_LEVELS,
+    },
+};
+
+uint32_t previous_power_of_two(uint32_t value) {
+    uint32_t result = 1;
+    while (result * 2 <= value) {
+        result *= 2;
+    }
+    return result;
+}
+} // namespace
+
+DepthPyramid::DepthPyramid(const Device &p_device,
+                           SamplerCache &p_sampler_cache)
+    : device(p_device),
+      sampler(p_sampler_cache.get(SamplerSettings{
+          .filter = VK_FILTER_NEAREST,
+          .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+          .address_mode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      })),
+      descriptor_set_layout(p_device, pyramid_bindings),
+      descriptor_pool(p_device, pyramid_pool_sizes, MAX_LEVELS),
+      pipeline(p_device, "depth_pyramid.comp", {},
+               std::array{descriptor_set_layout.get()}) {
+    pipeline.set_debug_name("Depth pyramid");
+}
+
+void DepthPyramid::create(const CommandPool &p_command_pool,
+                          const Image &p_depth) {
+    const VkExtent2D extent{
+        .width = previous_power_of_two(p_depth.get_extent().width),
+        .height = previous_power_of_two(p_depth.get_extent().height),
+    };
+
+    const auto levels = std::min(
+        static_cast<uint32_t>(std::bit_width(
+            std::max(extent.width, extent.height))),
+        MAX_LEVELS);
+
+    pyramid.emplace(device, extent, VK_FORMAT_R32_SFLOAT,
+                    VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                    VK_IMAGE_ASPECT_COLOR_BIT, levels);
+    pyramid->set_debug_name("Depth pyramid");
+
+    descriptor_sets.reserve(levels);
+
+    for (uint32_t level = 0; level < levels; level++) {
+        const auto set = descriptor_pool.allocate(descriptor_set_layout);
+
+        if (level == 0) {
+            write_combined_image_sampler(
+                device, set, 0, sampler, p_depth.get_view(),
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        } else {
+            write_combined_image_sampler(device, set, 0, sampler,
+                                         pyramid->get_mip_view(level - 1),
+                                         VK_IMAGE_LAYOUT_GENERAL);
+        }
+
+        write_storage_image(device, set, 1, pyramid->get_mip_view(level),
+                            VK_IMAGE_LAYOUT_GENERAL);
+
+        descriptor_sets.push_back(set);
+    }
+
+    // Until the first downsample, nothing is occluded.
+    const VkImageSubresourceRange range{
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = levels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    const auto command_buffer = p_command_pool.begin_one_time();
+
+    const VkImageMemoryBarrier to_general{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = pyramid->get(),
+        .subresourceRange = range,
+    };
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &to_general);
+
+    const VkClearColorValue far_plane{.float32 = {1.0f, 1.0f, 1.0f, 1.0f}};
+    vkCmdClearColorImage(command_buffer, pyramid->get(),
+                         VK_IMAGE_LAYOUT_GENERAL, &far_plane, 1, &range);
+
+    const VkMemoryBarrier clear_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &clear_barrier, 0, nullptr, 0, nullptr);
+
+    p_command_pool.end_one_time(command_buffer);
+}
+
+void DepthPyramid::destroy() {
+    descriptor_sets.clear();
+    descriptor_pool.reset();
+    pyramid.reset();
+}
+
+void DepthPyramid::record(VkCommandBuffer p_command_buffer) const {
+    vkCmdBindPipeline(p_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      pipeline.get());
+
+    const VkMemoryBarrier level_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+    };
+
+    for (uint32_t level = 0; level < descriptor_sets.size(); level++) {
+        const auto width = std::max(pyramid->get_extent().width >> level, 1u);
+        const auto height = std::max(pyramid->get_extent().height >> level, 1u);
+
+        vkCmdBindDescriptorSets(p_command_buffer,
+                                VK_PIPELINE_BIND_POINT_COMPUTE,
+                                pipeline.get_layout(), 0, 1,
+                                &descriptor_sets[level], 0, nullptr);
+        vkCmdDispatch(p_command_buffer,
+                      (width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                      (height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+        // Makes the level visible both to the next downsample and, after the
+        // last one, to the occlusion test.
+        vkCmdPipelineBarrier(p_command_buffer,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                             &level_barrier, 0, nullptr, 0, nullptr);
+    }
+}
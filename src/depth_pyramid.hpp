@@ -0,0 +1,56 @@
+#pragma once
+
+#include "descriptors.hpp"
+#include "graphics.hpp"
+#include "images.hpp"
+#include "textures.hpp"
+
+// A hierarchical depth buffer: every texel of a mip level holds the farthest
+// depth of the texels it covers in the level below, so a single fetch can tell
+// whether anything in a screen-space rectangle is closer than a given depth.
+class DepthPyramid {
+  public:
+    DepthPyramid(const Device &device, SamplerCache &sampler_cache);
+
+    NO_COPY(DepthPyramid);
+
+    // Creates a pyramid for the given depth image and clears it to the far
+    // plane. The depth image must be in SHADER_READ_ONLY_OPTIMAL whenever
+    // `record` runs.
+    void create(const CommandPool &command_pool, const Image &depth);
+
+    void destroy();
+
+    // Records the downsample of the depth image into every level of the
+    // pyramid. Must be recorded outside of a render pass.
+    void record(VkCommandBuffer command_buffer) const;
+
+    // The pyramid stays in VK_IMAGE_LAYOUT_GENERAL for its whole lifetime.
+    inline VkImage get_image() const { return pyramid->get(); }
+
+    inline VkImageView get_view() const { return pyramid->get_view(); }
+
+    inline VkSampler get_sampler() const { return sampler; }
+
+    inline const VkExtent2D &get_extent() const {
+        return pyramid->get_extent();
+    }
+
+    inline uint32_t get_mip_levels() const { return pyramid->get_mip_levels(); }
+
+    inline ~DepthPyramid() { destroy(); }
+
+  private:
+    const Device &device;
+
+    // Owned by the sampler cache.
+    VkSampler sampler;
+
+    DescriptorSetLayout descriptor_set_layout;
+    DescriptorPool descriptor_pool;
+    std::vector<VkDescriptorSet> descriptor_sets;
+
+    ComputePipeline pipeline;
+
+    std::optional<Image> pyramid;
+};
@@ -0,0 +1,133 @@
+#include "buffers.hpp"
+
+#include "descriptors.hpp"
+
+DescriptorSetLayout::DescriptorSetLayout(
+    const Device &p_device,
+    std::span<const VkDescriptorSetLayoutBinding> p_bindings)
+    : device(p_device) {
+    const VkDescriptorSetLayoutCreateInfo layout_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .bindingCount = static_cast<uint32_t>(p_bindings.size()),
+        .pBindings = p_bindings.data(),
+    };
+
+    VK_ERROR(vkCreateDescriptorSetLayout(device.get(), &layout_info, nullptr,
+                                         &layout));
+}
+
+DescriptorPool::DescriptorPool(const Device &p_device,
+                               std::span<const VkDescriptorPoolSize> p_sizes,
+                               uint32_t p_max_sets)
+    : device(p_device) {
+    const VkDescriptorPoolCreateInfo pool_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .maxSets = p_max_sets,
+        .poolSizeCount = static_cast<uint32_t>(p_sizes.size()),
+        .pPoolSizes = p_sizes.data(),
+    };
+
+    VK_ERROR(vkCreateDescriptorPool(device.get(), &pool_info, nullptr, &pool));
+}
+
+auto DescriptorPool::allocate(const DescriptorSetLayout &p_layout) const
+    -> VkDescriptorSet {
+    const auto layout = p_layout.get();
+
+    const VkDescriptorSetAllocateInfo alloc_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .descriptorPool = pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+
+    VkDescriptorSet set;
+    VK_ERROR(vkAllocateDescriptorSets(device.get(), &alloc_info, &set));
+    return set;
+}
+
+namespace {
+void write_buffer(const Device &p_device, VkDescriptorSet p_set,
+                  uint32_t p_binding, VkDescriptorType p_type,
+                  const Buffer &p_buffer) {
+    const VkDescriptorBufferInfo buffer_info{
+        .buffer = p_buffer.get(),
+        .offset = 0,
+        .range = VK_WHOLE_SIZE,
+    };
+
+    const VkWriteDescriptorSet write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = p_set,
+        .dstBinding = p_binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = p_type,
+        .pImageInfo = nullptr,
+        .pBufferInfo = &buffer_info,
+        .pTexelBufferView = nullptr,
+    };
+
+    vkUpdateDescriptorSets(p_device.get(), 1, &write, 0, nullptr);
+}
+
+void write_image(const Device &p_device, VkDescriptorSet p_set,
+                 uint32_t p_binding, VkDescriptorType p_type,
+                 VkSampler p_sampler, VkImageView p_view,
+                 VkImageLayout p_layout) {
+    const VkDescriptorImageInfo image_info{
+        .sampler = p_sampler,
+        .imageView = p_view,
+        .imageLayout = p_layout,
+    };
+
+    const VkWriteDescriptorSet write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = p_set,
+        .dstBinding = p_binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = p_type,
+        .pImageInfo = &image_info,
+        .pBufferInfo = nullptr,
+        .pTexelBufferView = nullptr,
+    };
+
+    vkUpdateDescriptorSets(p_device.get(), 1, &write, 0, nullptr);
+}
+} // namespace
+
+void write_storage_buffer(const Device &p_device, VkDescriptorSet p_set,
+                          uint32_t p_binding, const Buffer &p_buffer) {
+    write_buffer(p_device, p_set, p_binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                 p_buffer);
+}
+
+void write_uniform_buffer(const Device &p_device, VkDescriptorSet p_set,
+                          uint32_t p_binding, const Buffer &p_buffer) {
+    write_buffer(p_device, p_set, p_binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                 p_buffer);
+}
+
+void write_combined_image_sampler(const Device &p_device,
+                                  VkDescriptorSet p_set, uint32_t p_binding,
+                                  VkSampler p_sampler, VkImageView p_view,
+                                  VkImageLayout p_layout) {
+    write_image(p_device, p_set, p_binding,
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, p_sampler, p_view,
+                p_layout);
+}
+
+void write_storage_image(const Device &p_device, VkDescriptorSet p_set,
+                         uint32_t p_binding, VkImageView p_view,
+                         VkImageLayout p_layout) {
+    write_image(p_device, p_set, p_binding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                VK_NULL_HANDLE, p_view, p_layout);
+}
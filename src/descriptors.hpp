@@ -0,0 +1,68 @@
+#pragma once
+
+#include "devices.hpp"
+
+class Buffer;
+
+class DescriptorSetLayout {
+  public:
+    DescriptorSetLayout(
+        const Device &device,
+        std::span<const VkDescriptorSetLayoutBinding> bindings);
+
+    NO_COPY(DescriptorSetLayout);
+
+    inline VkDescriptorSetLayout get() const { return layout; }
+
+    inline ~DescriptorSetLayout() {
+        vkDestroyDescriptorSetLayout(device.get(), layout, nullptr);
+    }
+
+  private:
+    VkDescriptorSetLayout layout;
+
+    const Device &device;
+};
+
+class DescriptorPool {
+  public:
+    DescriptorPool(const Device &device,
+                   std::span<const VkDescriptorPoolSize> pool_sizes,
+                   uint32_t max_sets);
+
+    NO_COPY(DescriptorPool);
+
+    auto allocate(const DescriptorSetLayout &layout) const -> VkDescriptorSet;
+
+    // Returns every set allocated from the pool back to it.
+    inline void reset() const {
+        VK_ERROR(vkResetDescriptorPool(device.get(), pool, 0));
+    }
+
+    inline VkDescriptorPool get() const { return pool; }
+
+    inline ~DescriptorPool() {
+        vkDestroyDescriptorPool(device.get(), pool, nullptr);
+    }
+
+  private:
+    VkDescriptorPool pool;
+
+    const Device &device;
+};
+
+// Points a storage buffer binding of the set at the whole of the buffer.
+void write_storage_buffer(const Device &device, VkDescriptorSet set,
+                          uint32_t binding, const Buffer &buffer);
+
+// Points a uniform buffer binding of the set at the whole of the buffer.
+void write_uniform_buffer(const Device &device, VkDescriptorSet set,
+                          uint32_t binding, const Buffer &buffer);
+
+void write_combined_image_sampler(const Device &device, VkDescriptorSet set,
+                                  uint32_t binding, VkSampler sampler,
+                                  VkImageView view, VkImageLayout layout);
+
+void write_storage_image(const Device &device, VkDescriptorSet set,
+                         uint32_t binding, VkImageView view,
+                         VkImageLayout layout);
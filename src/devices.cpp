@@ -1,5 +1,7 @@
+#include "capabilities.hpp"
 #include "present.hpp"
 #include "sync.hpp"
+#include "trace.hpp"
 
 #include "devices.hpp"
 
@@ -8,6 +10,9 @@ struct PhysicalDevice {
     VkPhysicalDevice physical_device;
     uint32_t graphics_family;
     uint32_t present_family;
+    uint32_t compute_family;
+    uint32_t transfer_family;
+    DeviceCapabilities capabilities;
 };
 
 constexpr std::string_view VALIDATION_LAYER = "VK_LAYER_KHRONOS_validation";
@@ -28,74 +33,329 @@ bool check_validation_layers_support() {
     return false;
 }
 
-std::optional<PhysicalDevice> pick_physical_device(VkInstance p_instance,
-                                                   VkSurfaceKHR p_surface) {
+struct QueueFamilies {
+    std::optional<uint32_t> graphics;
+    std::optional<uint32_t> present;
+    std::optional<uint32_t> compute;
+    std::optional<uint32_t> transfer;
+};
+
+// Prefers a single family for graphics and presentation, a compute family
+// without graphics for async compute and a transfer-only family (the DMA
+// engine) for uploads. Anything that can not be found dedicated falls back to
+// the graphics family. Presentation support is asked of GLFW, since no surface
+// exists yet.
+QueueFamilies find_queue_families(VkInstance p_instance,
+                                  VkPhysicalDevice p_device) {
+    uint32_t queue_family_count;
+    vkGetPhysicalDeviceQueueFamilyProperties(p_device, &queue_family_count,
+                                             nullptr);
+
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(p_device, &queue_family_count,
+                                             queue_families.data());
+
+    QueueFamilies families;
+    std::optional<uint32_t> any_graphics;
+    std::optional<uint32_t> any_present;
+    std::optional<uint32_t> transfer_without_graphics;
+
+    for (uint32_t i = 0; i < queue_families.size(); i++) {
+        const auto flags = queue_families.at(i).queueFlags;
+        const auto has_graphics = (flags & VK_QUEUE_GRAPHICS_BIT) != 0;
+        const auto has_compute = (flags & VK_QUEUE_COMPUTE_BIT) != 0;
+        const auto has_transfer = (flags & VK_QUEUE_TRANSFER_BIT) != 0;
+
+        const auto supports_presentation =
+            glfwGetPhysicalDevicePresentationSupport(p_instance, p_device, i) ==
+            GLFW_TRUE;
+
+        if (has_graphics && supports_presentation &&
+            !families.graphics.has_value()) {
+            families.graphics = i;
+            families.present = i;
+        }
+
+        if (has_graphics && !any_graphics.has_value()) {
+            any_graphics = i;
+        }
+
+        if (supports_presentation && !any_present.has_value()) {
+            any_present = i;
+        }
+
+        if (has_compute && !has_graphics && !families.compute.has_value()) {
+            families.compute = i;
+        }
+
+        if (has_transfer && !has_graphics && !has_compute &&
+            !families.transfer.has_value()) {
+            families.transfer = i;
+        }
+
+        if (has_transfer && !has_graphics &&
+            !transfer_without_graphics.has_value()) {
+            transfer_without_graphics = i;
+        }
+    }
+
+    if (!families.graphics.has_value()) {
+        families.graphics = any_graphics;
+        families.present = any_present;
+    }
+
+    if (!families.transfer.has_value()) {
+        families.transfer = transfer_without_graphics;
+    }
+
+    if (!families.compute.has_value()) {
+        families.compute = families.graphics;
+    }
+
+    if (!families.transfer.has_value()) {
+        families.transfer = families.graphics;
+    }
+
+    return families;
+}
+
+bool has_swapchain_extension(VkPhysicalDevice p_device) {
+    uint32_t device_extension_count;
+    vkEnumerateDeviceExtensionProperties(p_device, nullptr,
+                                         &device_extension_count, nullptr);
+
+    std::vector<VkExtensionProperties> device_extensions(
+        device_extension_count);
+    vkEnumerateDeviceExtensionProperties(
+        p_device, nullptr, &device_extension_count, device_extensions.data());
+
+    for (const auto &extension : device_extensions) {
+        if (std::string_view{extension.extensionName} ==
+            std::string_view{VK_KHR_SWAPCHAIN_EXTENSION_NAME}) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string_view device_type_name(VkPhysicalDeviceType p_type) {
+    switch (p_type) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return "cpu";
+    default:
+        return "other";
+    }
+}
+
+struct Candidate {
+    PhysicalDevice device;
+    VkPhysicalDeviceProperties properties;
+    uint64_t score;
+    std::string reasons;
+};
+
+// Scores a suitable device, or returns nothing (with the reason) if the engine
+// can not run on it at all.
+std::optional<Candidate> rate_physical_device(VkInstance p_instance,
+                                              VkPhysicalDevice p_device,
+                                              std::string &p_rejection) {
+    const auto families = find_queue_families(p_instance, p_device);
+
+    if (!families.graphics.has_value() || !families.present.has_value()) {
+        p_rejection = "no graphics or present queue";
+        return {};
+    }
+
+    if (!has_swapchain_extension(p_device)) {
+        p_rejection = "no VK_KHR_swapchain";
+        return {};
+    }
+
+    // The GPU culling path writes its draws with vkCmdDrawIndexedIndirectCount
+    // and indexes per-object data with the instance index of each draw.
+    const auto capabilities = query_capabilities(p_device);
+    if (!meets_requirements(capabilities)) {
+        p_rejection = "missing multiDrawIndirect, drawIndirectFirstInstance "
+                      "or drawIndirectCount";
+        return {};
+    }
+
+    Candidate candidate{
+        .device =
+            PhysicalDevice{
+                .physical_device = p_device,
+                .graphics_family = families.graphics.value(),
+                .present_family = families.present.value(),
+                .compute_family = families.compute.value(),
+                .transfer_family = families.transfer.value(),
+                .capabilities = capabilities,
+            },
+        .properties = {},
+        .score = 0,
+        .reasons = {},
+    };
+
+    vkGetPhysicalDeviceProperties(p_device, &candidate.properties);
+
+    switch (candidate.properties.deviceType) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        candidate.score += 100000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        candidate.score += 50000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        candidate.score += 20000;
+        break;
+    default:
+        break;
+    }
+
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(p_device, &memory_properties);
+
+    VkDeviceSize device_local_memory = 0;
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++) {
+        const auto &heap = memory_properties.memoryHeaps[i];
+        if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            device_local_memory += heap.size;
+        }
+    }
+
+    const auto device_local_mib = device_local_memory / (1024 * 1024);
+    // One point per 16 MiB, so memory only breaks ties between device types.
+    candidate.score += device_local_mib / 16;
+
+    candidate.reasons = fmt::format("{}, {} MiB device-local",
+                                    device_type_name(
+                                        candidate.properties.deviceType),
+                                    device_local_mib);
+
+    const auto &device = candidate.device;
+
+    if (device.graphics_family == device.present_family) {
+        candidate.score += 500;
+        candidate.reasons += ", shared graphics+present queue";
+    }
+
+    if (device.compute_family != device.graphics_family) {
+        candidate.score += 250;
+        candidate.reasons += ", async compute queue";
+    }
+
+    if (device.transfer_family != device.graphics_family) {
+        candidate.score += 250;
+        candidate.reasons += ", dedicated transfer queue";
+    }
+
+    // Fast paths are worth less than a better device type or queue layout,
+    // but still break ties between otherwise equal devices.
+    if (capabilities.synchronization2 && capabilities.dynamic_rendering) {
+        candidate.score += 100;
+        candidate.reasons += ", synchronization2 + dynamic rendering";
+    }
+
+    if (capabilities.buffer_device_address) {
+        candidate.score += 50;
+        candidate.reasons += ", buffer device address";
+    }
+
+    return candidate;
+}
+
+// Matches a device override either as an index into the list of physical
+// devices or as a case-insensitive part of the device name.
+bool matches_override(std::string_view p_override, uint32_t p_index,
+                      std::string_view p_name) {
+    const auto is_index =
+        !p_override.empty() &&
+        std::all_of(p_override.begin(), p_override.end(),
+                    [](char c) { return c >= '0' && c <= '9'; });
+
+    if (is_index) {
+        return std::to_string(p_index) == p_override;
+    }
+
+    const auto lower = [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    };
+
+    return std::search(p_name.begin(), p_name.end(), p_override.begin(),
+                       p_override.end(), [&](char a, char b) {
+                           return lower(a) == lower(b);
+                       }) != p_name.end();
+}
+
+std::optional<PhysicalDevice>
+pick_physical_device(VkInstance p_instance, std::string_view p_override) {
     uint32_t device_count;
     vkEnumeratePhysicalDevices(p_instance, &device_count, nullptr);
 
     std::vector<VkPhysicalDevice> devices(device_count);
     vkEnumeratePhysicalDevices(p_instance, &device_count, devices.data());
 
-    for (const auto device : devices) {
-        std::optional<uint32_t> graphics_family;
-        std::optional<uint32_t> present_family;
-
-        uint32_t queue_family_count;
-        vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count,
-                                                 nullptr);
-
-        std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-        vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count,
-                                                 queue_families.data());
-
-        for (uint32_t i = 0; i < queue_families.size(); i++) {
-            if (queue_families.at(i).queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-                graphics_family = i;
-            }
-
-            VkBool32 supports_presentation;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, p_surface,
-                                                 &supports_presentation);
-            if (supports_presentation) {
-                present_family = i;
-            }
-
-            // No point in continuing if the two things have already been found.
-            if (graphics_family.has_value() && present_family.has_value()) {
-                break;
-            }
-        }
+    std::optional<Candidate> best;
+    std::optional<Candidate> overridden;
 
-        uint32_t device_extension_count;
-        vkEnumerateDeviceExtensionProperties(device, nullptr,
-                                             &device_extension_count, nullptr);
+    for (uint32_t i = 0; i < devices.size(); i++) {
+        std::string rejection;
+        auto candidate =
+            rate_physical_device(p_instance, devices.at(i), rejection);
 
-        std::vector<VkExtensionProperties> device_extensions(
-            device_extension_count);
-        vkEnumerateDeviceExtensionProperties(
-            device, nullptr, &device_extension_count, device_extensions.data());
+        if (!candidate.has_value()) {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(devices.at(i), &properties);
+            fmt::println("[INFO]: Physical device {} ({}) is unsuitable: {}.",
+                         i, properties.deviceName, rejection);
+            continue;
+        }
 
-        bool has_swapchain_support = false;
+        fmt::println("[INFO]: Physical device {} ({}) scored {}: {}.", i,
+                     candidate->properties.deviceName, candidate->score,
+                     candidate->reasons);
 
-        for (const auto &extension : device_extensions) {
-            if (std::string_view{extension.extensionName} ==
-                std::string_view{VK_KHR_SWAPCHAIN_EXTENSION_NAME}) {
-                has_swapchain_support = true;
-            }
+        if (!p_override.empty() && !overridden.has_value() &&
+            matches_override(p_override, i,
+                             candidate->properties.deviceName)) {
+            overridden = candidate;
         }
 
-        if (graphics_family.has_value() && present_family.has_value() &&
-            has_swapchain_support) {
-            return PhysicalDevice{device, graphics_family.value(),
-                                  present_family.value()};
+        if (!best.has_value() || candidate->score > best->score) {
+            best = std::move(candidate);
         }
     }
 
-    return {};
+    if (overridden.has_value()) {
+        fmt::println("[INFO]: Using {} because it matches the device override "
+                     "'{}'.",
+                     overridden->properties.deviceName, p_override);
+        return overridden->device;
+    }
+
+    if (!p_override.empty()) {
+        fmt::println("[WARNING]: No suitable physical device matches the "
+                     "device override '{}'.",
+                     p_override);
+    }
+
+    if (!best.has_value()) {
+        return {};
+    }
+
+    fmt::println("[INFO]: Using {} because it has the highest score.",
+                 best->properties.deviceName);
+    return best->device;
 }
 } // namespace
 
-Device::Device(GLFWwindow *const p_window, bool p_enable_validation) {
+Device::Device(bool p_enable_validation, std::string_view p_device_override) {
     VkApplicationInfo app_info{
         .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
         .pNext = nullptr,
@@ -116,16 +376,36 @@ Device::Device(GLFWwindow *const p_window, bool p_enable_validation) {
     const char **glfwExtensions =
         glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
+    std::vector<const char *> instance_extensions(
+        glfwExtensions, glfwExtensions + glfwExtensionCount);
+
+    const void *instance_next = nullptr;
+    bool enable_debug_utils = false;
+
+#ifdef JUBES_DEBUG_UTILS
+    const auto messenger_info = debug_messenger_info();
+
+    enable_debug_utils = is_debug_utils_supported();
+    if (enable_debug_utils) {
+        instance_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+
+        if (p_enable_validation) {
+            instance_next = &messenger_info;
+        }
+    }
+#endif
+
     VkInstanceCreateInfo instance_info{
         .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-        .pNext = nullptr,
+        .pNext = instance_next,
         .flags = 0,
         .pApplicationInfo = &app_info,
         .enabledLayerCount = p_enable_validation ? (uint32_t)1 : (uint32_t)0,
         .ppEnabledLayerNames =
             p_enable_validation ? &validation_layer : nullptr,
-        .enabledExtensionCount = glfwExtensionCount,
-        .ppEnabledExtensionNames = glfwExtensions,
+        .enabledExtensionCount =
+            static_cast<uint32_t>(instance_extensions.size()),
+        .ppEnabledExtensionNames = instance_extensions.data(),
     };
 
     auto result = vkCreateInstance(&instance_info, nullptr, &instance);
@@ -134,81 +414,83 @@ Device::Device(GLFWwindow *const p_window, bool p_enable_validation) {
         throw Error::VulkanError;
     }
 
-    result = glfwCreateWindowSurface(instance, p_window, nullptr, &surface);
-    if (result != VK_SUCCESS) {
-        fmt::println("[ERROR]: Failed to create the window surface: {}",
-                     result);
-        throw Error::VulkanError;
+#ifdef JUBES_DEBUG_UTILS
+    if (enable_debug_utils) {
+        debug_utils = load_debug_utils(instance);
     }
+#endif
 
-    const auto physical_device_stuff = pick_physical_device(instance, surface);
+    fmt::println("[INFO]: Validation {}, debug utils {}.",
+                 p_enable_validation ? "enabled" : "disabled",
+                 enable_debug_utils ? "enabled" : "disabled");
+
+    const auto physical_device_stuff =
+        pick_physical_device(instance, p_device_override);
     if (!physical_device_stuff.has_value()) {
         fmt::println("[ERROR]: Could not find an adequate physical device.");
         throw Error::NoAdequatePhysicalDeviceError;
     }
 
-    const auto [physical_device, graphics_family, present_family] =
+    const auto [physical_device, graphics_family, present_family,
+                compute_family, transfer_family, capabilities] =
         physical_device_stuff.value();
 
     VkPhysicalDeviceProperties physical_device_properties;
     vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
-    fmt::println("[INFO]: Selected {} as the physical device.",
-                 physical_device_properties.deviceName);
+    fmt::println("[INFO]: Selected {} as the physical device (graphics queue "
+                 "family {}, present {}, compute {}, transfer {}).",
+                 physical_device_properties.deviceName, graphics_family,
+                 present_family, compute_family, transfer_family);
 
     this->physical_device = physical_device;
     this->graphics_family = graphics_family;
     this->present_family = present_family;
+    this->compute_family = compute_family;
+    this->transfer_family = transfer_family;
+    this->capabilities = capabilities;
+    memory_tracker =
+        std::make_unique<MemoryTracker>(physical_device, capabilities);
+
+    log_capabilities(capabilities);
+
+    std::array families{graphics_family, present_family, compute_family,
+                        transfer_family};
+    std::sort(families.begin(), families.end());
+    const auto unique_end = std::unique(families.begin(), families.end());
 
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-    queue_create_infos.reserve(2);
+    queue_create_infos.reserve(families.size());
 
     float queue_priority = 1.0f;
 
-    if (graphics_family == present_family) {
+    for (auto family = families.begin(); family != unique_end; family++) {
         queue_create_infos.push_back({
             .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0,
-            .queueFamilyIndex = graphics_family,
-            .queueCount = 1,
-            .pQueuePriorities = &queue_priority,
-        });
-    } else {
-        queue_create_infos.push_back({
-            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .queueFamilyIndex = graphics_family,
-            .queueCount = 1,
-            .pQueuePriorities = &queue_priority,
-        });
-
-        queue_create_infos.push_back({
-            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .queueFamilyIndex = present_family,
+            .queueFamilyIndex = *family,
             .queueCount = 1,
             .pQueuePriorities = &queue_priority,
         });
     }
 
-    const VkPhysicalDeviceFeatures device_features{};
-
-    const std::array extensions{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // Everything supported is enabled, so the capabilities double as the
+    // list of enabled features.
+    DeviceFeatureChain features{capabilities};
+    const auto extensions = required_device_extensions(capabilities);
 
     const VkDeviceCreateInfo device_info{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext = nullptr,
+        .pNext = features.get(),
         .flags = 0,
         .queueCreateInfoCount =
             static_cast<uint32_t>(queue_create_infos.size()),
         .pQueueCreateInfos = queue_create_infos.data(),
         .enabledLayerCount = 0,
         .ppEnabledLayerNames = nullptr,
-        .enabledExtensionCount = extensions.size(),
+        .enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
         .ppEnabledExtensionNames = extensions.data(),
-        .pEnabledFeatures = &device_features,
+        .pEnabledFeatures = nullptr,
     };
 
     result = vkCreateDevice(physical_device, &device_info, nullptr, &device);
@@ -219,25 +501,44 @@ Device::Device(GLFWwindow *const p_window, bool p_enable_validation) {
 
     vkGetDeviceQueue(device, graphics_family, 0, &graphics_queue);
     vkGetDeviceQueue(device, present_family, 0, &present_queue);
+    vkGetDeviceQueue(device, compute_family, 0, &compute_queue);
+    vkGetDeviceQueue(device, transfer_family, 0, &transfer_queue);
 }
 
 void Device::submit_to_graphics(VkCommandBuffer command_buffer,
                                 const Semaphore &wait_semaphore,
                                 const Semaphore &signal_semaphore,
                                 const Fence &fence) const {
-
     const auto wait_semaphore_raw = wait_semaphore.get();
+    submit_to_graphics(command_buffer, std::span{&wait_semaphore_raw, 1},
+                       signal_semaphore, fence);
+}
+
+void Device::submit_to_graphics(VkCommandBuffer command_buffer,
+                                std::span<const VkSemaphore> wait_semaphores,
+                                const Semaphore &signal_semaphore,
+                                const Fence &fence) const {
+    TRACE_SCOPE("Device::submit_to_graphics");
+
     const auto signal_semaphore_raw = signal_semaphore.get();
 
-    const VkPipelineStageFlags wait_stage =
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    // Swapchain images are first written either as attachments or by
+    // transfers.
+    std::array<VkPipelineStageFlags, MAX_BATCHED_PRESENTS> wait_stages;
+    if (wait_semaphores.size() > wait_stages.size()) {
+        fmt::println("[ERROR]: A submit can wait for at most {} semaphores.",
+                     wait_stages.size());
+        throw Error::VulkanError;
+    }
+    wait_stages.fill(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                     VK_PIPELINE_STAGE_TRANSFER_BIT);
 
     const VkSubmitInfo submit_info{
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
         .pNext = nullptr,
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &wait_semaphore_raw,
-        .pWaitDstStageMask = &wait_stage,
+        .waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size()),
+        .pWaitSemaphores = wait_semaphores.data(),
+        .pWaitDstStageMask = wait_stages.data(),
         .commandBufferCount = 1,
         .pCommandBuffers = &command_buffer,
         .signalSemaphoreCount = 1,
@@ -248,52 +549,114 @@ void Device::submit_to_graphics(VkCommandBuffer command_buffer,
 }
 
 bool Device::present(const Swapchain &swapchain,
-                     const Semaphore &wait_semaphore,
-                     uint32_t image_index) const {
+                     const Semaphore &wait_semaphore, uint32_t image_index,
+                     uint64_t present_id) const {
+    SwapchainPresent swapchain_present{
+        .swapchain = &swapchain,
+        .image_index = image_index,
+        .present_id = present_id,
+        .should_recreate = false,
+    };
+    present(std::span{&swapchain_present, 1}, wait_semaphore);
+
+    return swapchain_present.should_recreate;
+}
+
+void Device::present(std::span<SwapchainPresent> presents,
+                     const Semaphore &wait_semaphore) const {
+    TRACE_SCOPE("Device::present");
+
+    if (presents.size() > MAX_BATCHED_PRESENTS) {
+        fmt::println("[ERROR]: A present can batch at most {} swapchains.",
+                     MAX_BATCHED_PRESENTS);
+        throw Error::VulkanError;
+    }
 
     const auto wait_semaphore_raw = wait_semaphore.get();
-    const auto swapchain_raw = swapchain.get();
+    const auto count = static_cast<uint32_t>(presents.size());
+
+    std::array<VkSwapchainKHR, MAX_BATCHED_PRESENTS> swapchains;
+    std::array<uint32_t, MAX_BATCHED_PRESENTS> image_indices;
+    std::array<uint64_t, MAX_BATCHED_PRESENTS> present_ids;
+    std::array<VkResult, MAX_BATCHED_PRESENTS> results;
+    bool has_present_id = false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        swapchains[i] = presents[i].swapchain->get();
+        image_indices[i] = presents[i].image_index;
+        present_ids[i] = presents[i].present_id;
+        has_present_id = has_present_id || presents[i].present_id != 0;
+    }
+
+    const VkPresentIdKHR present_id_info{
+        .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+        .pNext = nullptr,
+        .swapchainCount = count,
+        .pPresentIds = present_ids.data(),
+    };
+
+    has_present_id = has_present_id && capabilities.present_id;
 
     const VkPresentInfoKHR present_info{
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-        .pNext = nullptr,
+        .pNext = has_present_id ? &present_id_info : nullptr,
         .waitSemaphoreCount = 1,
         .pWaitSemaphores = &wait_semaphore_raw,
-        .swapchainCount = 1,
-        .pSwapchains = &swapchain_raw,
-        .pImageIndices = &image_index,
-        .pResults = nullptr,
+        .swapchainCount = count,
+        .pSwapchains = swapchains.data(),
+        .pImageIndices = image_indices.data(),
+        .pResults = results.data(),
     };
 
-    const auto result = vkQueuePresentKHR(present_queue, &present_info);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        return true;
-    } else if (result != VK_SUCCESS) {
-        fmt::println("[ERROR]: Failed to present to the screen: {}", result);
-        throw Error::VulkanError;
-    } else {
-        return false;
+    // Each swapchain gets its own result, which is only missing when the
+    // whole batch failed.
+    results.fill(VK_RESULT_MAX_ENUM);
+    const auto batch_result = vkQueuePresentKHR(present_queue, &present_info);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const auto result =
+            results[i] != VK_RESULT_MAX_ENUM ? results[i] : batch_result;
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            presents[i].should_recreate = true;
+        } else if (result != VK_SUCCESS) {
+            fmt::println("[ERROR]: Failed to present to the screen: {}",
+                         result);
+            throw Error::VulkanError;
+        } else {
+            presents[i].should_recreate = false;
+        }
     }
 }
 
 Device &Device::operator=(Device &&rhs) noexcept {
     instance = rhs.instance;
-    surface = rhs.surface;
     physical_device = rhs.physical_device;
     device = rhs.device;
     graphics_family = rhs.graphics_family;
     present_family = rhs.present_family;
+    compute_family = rhs.compute_family;
+    transfer_family = rhs.transfer_family;
     graphics_queue = rhs.graphics_queue;
     present_queue = rhs.present_queue;
+    compute_queue = rhs.compute_queue;
+    transfer_queue = rhs.transfer_queue;
+    debug_utils = rhs.debug_utils;
+    capabilities = rhs.capabilities;
+    memory_tracker = std::move(rhs.memory_tracker);
 
     rhs.instance = 0;
-    rhs.surface = 0;
     rhs.physical_device = 0;
     rhs.device = 0;
     rhs.graphics_family = 0;
     rhs.present_family = 0;
+    rhs.compute_family = 0;
+    rhs.transfer_family = 0;
     rhs.graphics_queue = 0;
     rhs.present_queue = 0;
+    rhs.compute_queue = 0;
+    rhs.transfer_queue = 0;
+    rhs.debug_utils = {};
+    rhs.capabilities = {};
 
     return *this;
 }
@@ -301,7 +664,9 @@ Device &Device::operator=(Device &&rhs) noexcept {
 Device::~Device() {
     if (device != VK_NULL_HANDLE) {
         vkDestroyDevice(device, nullptr);
-        vkDestroySurfaceKHR(instance, surface, nullptr);
+#ifdef JUBES_DEBUG_UTILS
+        destroy_debug_utils(instance, debug_utils);
+#endif
         vkDestroyInstance(instance, nullptr);
     }
 }
@@ -317,12 +682,13 @@ CommandPool::CommandPool(const Device &device) : device(device) {
     VK_ERROR(vkCreateCommandPool(device.get(), &pool_info, nullptr, &pool));
 }
 
-auto CommandPool::allocate_buffer() const -> VkCommandBuffer {
+auto CommandPool::allocate_buffer(VkCommandBufferLevel p_level) const
+    -> VkCommandBuffer {
     VkCommandBufferAllocateInfo alloc_info{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .pNext = nullptr,
         .commandPool = pool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .level = p_level,
         .commandBufferCount = 1,
     };
 
@@ -330,3 +696,39 @@ auto CommandPool::allocate_buffer() const -> VkCommandBuffer {
     VK_ERROR(vkAllocateCommandBuffers(device.get(), &alloc_info, &buffer));
     return buffer;
 }
+
+auto CommandPool::begin_one_time() const -> VkCommandBuffer {
+    const auto command_buffer = allocate_buffer();
+
+    const VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr,
+    };
+
+    VK_ERROR(vkBeginCommandBuffer(command_buffer, &begin_info));
+    return command_buffer;
+}
+
+void CommandPool::end_one_time(VkCommandBuffer command_buffer) const {
+    VK_ERROR(vkEndCommandBuffer(command_buffer));
+
+    const VkSubmitInfo submit_info{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &command_buffer,
+        .signalSemaphoreCount = 0,
+        .pSignalSemaphores = nullptr,
+    };
+
+    VK_ERROR(vkQueueSubmit(device.get_graphics_queue(), 1, &submit_info,
+                           VK_NULL_HANDLE));
+    VK_ERROR(vkQueueWaitIdle(device.get_graphics_queue()));
+
+    vkFreeCommandBuffers(device.get(), pool, 1, &command_buffer);
+}
@@ -2,15 +2,37 @@
 
 #include <GLFW/glfw3.h>
 
+#include "capabilities.hpp"
 #include "common.hpp"
+#include "debug.hpp"
+#include "memory_tracker.hpp"
 
 class Swapchain;
 struct Semaphore;
 struct Fence;
 
+// What one swapchain presents in a batched Device::present.
+struct SwapchainPresent {
+    const Swapchain *swapchain;
+    uint32_t image_index;
+    // Tags the present for vkWaitForPresentKHR. Zero leaves it untagged.
+    uint64_t present_id;
+    // Set by the present: whether the swapchain should be recreated.
+    bool should_recreate;
+};
+
 class Device {
   public:
-    Device(GLFWwindow *const window, bool enable_validation);
+    // The most swapchains a single present can batch.
+    static constexpr uint32_t MAX_BATCHED_PRESENTS = 8;
+
+    // Windows are not needed to create the device: the present family is
+    // picked with GLFW's presentation support query, and every window then
+    // gets its own Surface. GLFW has to be initialized first.
+    //
+    // `device_override` selects the physical device by index or by part of its
+    // name instead of by score. Empty means no override.
+    Device(bool enable_validation, std::string_view device_override = {});
     Device &operator=(Device &&rhs) noexcept;
 
     NO_COPY(Device);
@@ -19,36 +41,77 @@ class Device {
 
     inline VkPhysicalDevice get_physical() const { return physical_device; }
 
-    inline VkSurfaceKHR get_surface() const { return surface; }
+    inline VkInstance get_instance() const { return instance; }
 
     inline uint32_t get_graphics_family() const { return graphics_family; }
 
     inline uint32_t get_present_family() const { return present_family; }
 
+    // Equal to the graphics family when there is no separate compute family.
+    inline uint32_t get_compute_family() const { return compute_family; }
+
+    // Equal to the graphics family when there is no separate transfer family.
+    inline uint32_t get_transfer_family() const { return transfer_family; }
+
     inline VkQueue get_graphics_queue() const { return graphics_queue; }
 
     inline VkQueue get_present_queue() const { return present_queue; }
 
+    inline VkQueue get_compute_queue() const { return compute_queue; }
+
+    inline VkQueue get_transfer_queue() const { return transfer_queue; }
+
+    inline const DebugUtils &get_debug_utils() const { return debug_utils; }
+
+    // What was negotiated with the physical device. All of it is enabled.
+    inline const DeviceCapabilities &get_capabilities() const {
+        return capabilities;
+    }
+
+    // Every VkDeviceMemory of the device is allocated and freed through it.
+    inline MemoryTracker &get_memory_tracker() const { return *memory_tracker; }
+
     void submit_to_graphics(VkCommandBuffer command_buffer,
                             const Semaphore &wait_semaphore,
                             const Semaphore &signal_semaphore,
                             const Fence &fence) const;
 
+    // Waits for all of `wait_semaphores`, e.g. one image acquisition per
+    // swapchain the command buffer renders to.
+    void submit_to_graphics(VkCommandBuffer command_buffer,
+                            std::span<const VkSemaphore> wait_semaphores,
+                            const Semaphore &signal_semaphore,
+                            const Fence &fence) const;
+
     // returns - whether you should recreate the swapchain or not.
+    // `present_id` tags the present for vkWaitForPresentKHR. It is ignored
+    // when zero or when the device has no VK_KHR_present_id.
     bool present(const Swapchain &swapchain, const Semaphore &wait_semaphore,
-                 uint32_t image_index) const;
+                 uint32_t image_index, uint64_t present_id = 0) const;
+
+    // Presents to every swapchain with a single vkQueuePresentKHR once
+    // `wait_semaphore` is signalled, and sets `should_recreate` on each.
+    // Present ids are ignored without VK_KHR_present_id.
+    void present(std::span<SwapchainPresent> presents,
+                 const Semaphore &wait_semaphore) const;
 
     ~Device();
 
   private:
     VkInstance instance;
-    VkSurfaceKHR surface;
     VkPhysicalDevice physical_device;
     VkDevice device;
     uint32_t graphics_family;
     uint32_t present_family;
+    uint32_t compute_family;
+    uint32_t transfer_family;
     VkQueue graphics_queue;
     VkQueue present_queue;
+    VkQueue compute_queue;
+    VkQueue transfer_queue;
+    DebugUtils debug_utils;
+    DeviceCapabilities capabilities;
+    std::unique_ptr<MemoryTracker> memory_tracker;
 };
 
 struct CommandPool {
@@ -59,7 +122,16 @@ struct CommandPool {
 
     NO_COPY(CommandPool);
 
-    auto allocate_buffer() const -> VkCommandBuffer;
+    auto allocate_buffer(
+        VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) const
+        -> VkCommandBuffer;
+
+    // Allocates a command buffer and begins recording it for a single submit.
+    auto begin_one_time() const -> VkCommandBuffer;
+
+    // Ends and submits a command buffer from begin_one_time, waits for the
+    // graphics queue to go idle and then frees it.
+    void end_one_time(VkCommandBuffer command_buffer) const;
 
     inline ~CommandPool() { vkDestroyCommandPool(device.get(), pool, nullptr); }
 };
@@ -0,0 +1,366 @@
+#include "draw_list.hpp"
+
+#include "buffers.hpp"
+#include "culling.hpp"
+#include "descriptors.hpp"
+
+namespace {
+constexpr uint32_t PASS_BITS = 4;
+constexpr uint32_t PIPELINE_BITS = 10;
+constexpr uint32_t MATERIAL_BITS = 14;
+constexpr uint32_t MESH_BITS = 16;
+constexpr uint32_t DEPTH_BITS = 20;
+
+static_assert(PASS_BITS + PIPELINE_BITS + MATERIAL_BITS + MESH_BITS +
+                  DEPTH_BITS ==
+              64);
+
+constexpr uint32_t MESH_SHIFT = DEPTH_BITS;
+constexpr uint32_t MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+constexpr uint32_t PIPELINE_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+constexpr uint32_t PASS_SHIFT = PIPELINE_SHIFT + PIPELINE_BITS;
+
+constexpr uint64_t mask(uint32_t p_bits) { return (uint64_t{1} << p_bits) - 1; }
+
+auto field(uint64_t p_key, uint32_t p_shift, uint32_t p_bits) -> uint32_t {
+    return static_cast<uint32_t>((p_key >> p_shift) & mask(p_bits));
+}
+
+void radix_sort(std::span<DrawRecord> p_records,
+                std::span<DrawRecord> p_scratch) {
+    std::array<std::array<uint32_t, 256>, 8> histograms{};
+
+    for (const auto &record : p_records) {
+        for (uint32_t byte = 0; byte < 8; byte++) {
+            histograms[byte][(record.key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    auto source = p_records;
+    auto destination = p_scratch;
+
+    for (uint32_t byte = 0; byte < 8; byte++) {
+        auto &histogram = histograms[byte];
+
+        // Every key has the same value in this byte, so the pass would not
+        // change the order.
+        if (histogram[(source[0].key >> (byte * 8)) & 0xFF] == source.size()) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (auto &bucket : histogram) {
+            const auto bucket_size = bucket;
+            bucket = offset;
+            offset += bucket_size;
+        }
+
+        for (const auto &record : source) {
+            destination[histogram[(record.key >> (byte * 8)) & 0xFF]++] =
+                record;
+        }
+
+        std::swap(source, destination);
+    }
+
+    if (source.data() != p_records.data()) {
+        std::copy(source.begin(), source.end(), p_records.begin());
+    }
+}
+
+double milliseconds_since(std::chrono::steady_clock::time_point p_start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - p_start)
+        .count();
+}
+} // namespace
+
+auto make_sort_key(const DrawKeyFields &p_fields) -> uint64_t {
+    const auto depth = static_cast<uint64_t>(
+        std::clamp(p_fields.depth, 0.0f, 1.0f) *
+        static_cast<float>(mask(DEPTH_BITS)));
+
+    return ((p_fields.pass & mask(PASS_BITS)) << PASS_SHIFT) |
+           ((p_fields.pipeline & mask(PIPELINE_BITS)) << PIPELINE_SHIFT) |
+           ((p_fields.material & mask(MATERIAL_BITS)) << MATERIAL_SHIFT) |
+           ((p_fields.mesh & mask(MESH_BITS)) << MESH_SHIFT) | depth;
+}
+
+auto get_sort_key_pass(uint64_t p_key) -> uint32_t {
+    return field(p_key, PASS_SHIFT, PASS_BITS);
+}
+
+auto get_sort_key_pipeline(uint64_t p_key) -> uint32_t {
+    return field(p_key, PIPELINE_SHIFT, PIPELINE_BITS);
+}
+
+auto get_sort_key_material(uint64_t p_key) -> uint32_t {
+    return field(p_key, MATERIAL_SHIFT, MATERIAL_BITS);
+}
+
+auto get_sort_key_mesh(uint64_t p_key) -> uint32_t {
+    return field(p_key, MESH_SHIFT, MESH_BITS);
+}
+
+DrawList::DrawList(FrameArena &p_arena, uint32_t p_capacity)
+    : arena(p_arena),
+      records(p_arena.allocate<DrawRecord>(std::max(p_capacity, 1u))),
+      count(0) {}
+
+void DrawList::push(uint64_t p_key, uint32_t p_object) {
+    // The old records stay in the arena until it is reset.
+    if (count == records.size()) {
+        const auto grown = arena.allocate<DrawRecord>(records.size() * 2);
+        std::copy(records.begin(), records.end(), grown.begin());
+        records = grown;
+    }
+
+    records[count++] = DrawRecord{
+        .key = p_key,
+        .object = p_object,
+        .padding = 0,
+    };
+}
+
+void DrawList::sort() {
+    if (count < 2) {
+        return;
+    }
+
+    radix_sort(records.first(count), arena.allocate<DrawRecord>(count));
+}
+
+auto DrawList::get_pass(uint32_t p_pass) const
+    -> std::span<const DrawRecord> {
+    const auto all = get_records();
+
+    const auto first = std::partition_point(
+        all.begin(), all.end(), [&](const DrawRecord &record) {
+            return get_sort_key_pass(record.key) < p_pass;
+        });
+    const auto last =
+        std::partition_point(first, all.end(), [&](const DrawRecord &record) {
+            return get_sort_key_pass(record.key) == p_pass;
+        });
+
+    return {first, last};
+}
+
+auto record_draw_list(CommandEncoder &p_encoder,
+                      std::span<const DrawRecord> p_records,
+                      const DrawBindings &p_bindings) -> DrawListStatistics {
+    const auto before = p_encoder.get_statistics();
+
+    for (const auto &record : p_records) {
+        p_encoder.bind_pipeline(
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            p_bindings.pipelines[get_sort_key_pipeline(record.key)]);
+        p_encoder.bind_descriptor_set(
+            VK_PIPELINE_BIND_POINT_GRAPHICS, p_bindings.layout, 0,
+            p_bindings.materials[get_sort_key_material(record.key)]);
+
+        const auto &mesh = p_bindings.meshes[get_sort_key_mesh(record.key)];
+        p_encoder.draw_indexed(mesh.index_count, 1, mesh.first_index,
+                               mesh.vertex_offset, record.object);
+    }
+
+    const auto &after = p_encoder.get_statistics();
+    const auto issued = [&](EncoderCommand command) {
+        const auto index = static_cast<uint32_t>(command);
+        return after.issued[index] - before.issued[index];
+    };
+
+    return DrawListStatistics{
+        .draw_count = static_cast<uint32_t>(p_records.size()),
+        .pipeline_binds = issued(EncoderCommand::BindPipeline),
+        .descriptor_set_binds = issued(EncoderCommand::BindDescriptorSet),
+    };
+}
+
+void run_draw_list_benchmark(const Device &p_device,
+                             const CommandPool &p_command_pool,
+                             const RenderPass &p_render_pass,
+                             const GeometryHeap &p_geometry,
+                             const Mesh &p_mesh) {
+    constexpr uint32_t DRAW_COUNT = 100000;
+    constexpr uint32_t PIPELINE_COUNT = 16;
+    constexpr uint32_t MATERIAL_COUNT = 256;
+    constexpr uint32_t MESH_COUNT = 64;
+    constexpr uint32_t ITERATIONS = 16;
+
+    // Every material points set 0 at the same object and camera buffers,
+    // which the vertex shader reads.
+    const std::array material_bindings{
+        VkDescriptorSetLayoutBinding{
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        VkDescriptorSetLayoutBinding{
+            .binding = 5,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    const std::array material_pool_sizes{
+        VkDescriptorPoolSize{
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = MATERIAL_COUNT,
+        },
+        VkDescriptorPoolSize{
+            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = MATERIAL_COUNT,
+        },
+    };
+
+    const DescriptorSetLayout material_layout{p_device, material_bindings};
+    const DescriptorPool material_pool{p_device, material_pool_sizes,
+                                       MATERIAL_COUNT};
+    const Buffer objects{p_device, DRAW_COUNT * sizeof(CullObject),
+                         Buffer::Type::Storage};
+    const Buffer camera{p_device, sizeof(glm::mat4), Buffer::Type::Uniform};
+
+    std::vector<VkDescriptorSet> materials;
+    materials.reserve(MATERIAL_COUNT);
+    for (uint32_t i = 0; i < MATERIAL_COUNT; i++) {
+        materials.push_back(material_pool.allocate(material_layout));
+        write_storage_buffer(p_device, materials.back(), 0, objects);
+        write_uniform_buffer(p_device, materials.back(), 5, camera);
+    }
+
+    const std::array set_layouts{material_layout.get()};
+
+    std::vector<std::unique_ptr<GraphicsPipeline>> pipeline_objects;
+    std::vector<VkPipeline> pipelines;
+    for (uint32_t i = 0; i < PIPELINE_COUNT; i++) {
+        pipeline_objects.push_back(std::make_unique<GraphicsPipeline>(
+            p_device, p_render_pass, "main.vert", "main.frag", {}, set_layouts));
+        pipelines.push_back(pipeline_objects.back()->get());
+    }
+
+    const std::vector<Mesh> meshes(MESH_COUNT, p_mesh);
+
+    const DrawBindings bindings{
+        .layout = pipeline_objects.front()->get_layout(),
+        .pipelines = pipelines,
+        .materials = materials,
+        .meshes = meshes,
+    };
+
+    // Draws arrive in the order their objects were created, which has
+    // nothing to do with the state they need.
+    std::mt19937 random{1234};
+    std::uniform_int_distribution<uint32_t> pipeline_distribution{
+        0, PIPELINE_COUNT - 1};
+    std::uniform_int_distribution<uint32_t> material_distribution{
+        0, MATERIAL_COUNT - 1};
+    std::uniform_int_distribution<uint32_t> mesh_distribution{0,
+                                                             MESH_COUNT - 1};
+    std::uniform_real_distribution<float> depth_distribution{0.0f, 1.0f};
+
+    std::vector<uint64_t> keys;
+    keys.reserve(DRAW_COUNT);
+    for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+        keys.push_back(make_sort_key(DrawKeyFields{
+            .pass = 0,
+            .pipeline = pipeline_distribution(random),
+            .material = material_distribution(random),
+            .mesh = mesh_distribution(random),
+            .depth = depth_distribution(random),
+        }));
+    }
+
+    // Draws can only be recorded within a render pass, which a secondary
+    // command buffer inherits without needing a framebuffer.
+    const auto command_buffer =
+        p_command_pool.allocate_buffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+    const VkCommandBufferInheritanceInfo inheritance_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = nullptr,
+        .renderPass = p_render_pass.get(),
+        .subpass = 0,
+        .framebuffer = VK_NULL_HANDLE,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags = 0,
+        .pipelineStatistics = 0,
+    };
+
+    const VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritance_info,
+    };
+
+    const auto record = [&](std::span<const DrawRecord> records) {
+        VK_ERROR(vkResetCommandBuffer(command_buffer, 0));
+        VK_ERROR(vkBeginCommandBuffer(command_buffer, &begin_info));
+
+        CommandEncoder encoder{command_buffer};
+        p_geometry.bind(encoder);
+
+        const auto statistics = record_draw_list(encoder, records, bindings);
+
+        VK_ERROR(vkEndCommandBuffer(command_buffer));
+        return statistics;
+    };
+
+    FrameArena arena;
+
+    double push_milliseconds = 0.0;
+    double sort_milliseconds = 0.0;
+    double sorted_record_milliseconds = 0.0;
+    double unsorted_record_milliseconds = 0.0;
+    DrawListStatistics sorted_statistics{};
+    DrawListStatistics unsorted_statistics{};
+
+    for (uint32_t iteration = 0; iteration < ITERATIONS; iteration++) {
+        arena.reset();
+
+        auto start = std::chrono::steady_clock::now();
+        DrawList draws{arena, DRAW_COUNT};
+        for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+            draws.push(keys[i], i);
+        }
+        push_milliseconds += milliseconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        unsorted_statistics = record(draws.get_records());
+        unsorted_record_milliseconds += milliseconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        draws.sort();
+        sort_milliseconds += milliseconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        sorted_statistics = record(draws.get_pass(0));
+        sorted_record_milliseconds += milliseconds_since(start);
+    }
+
+    vkFreeCommandBuffers(p_device.get(), p_command_pool.pool, 1,
+                         &command_buffer);
+
+    fmt::println("[INFO]: Draw list benchmark: {} draws over {} pipelines, {} "
+                 "materials and {} meshes ({} iterations)",
+                 DRAW_COUNT, PIPELINE_COUNT, MATERIAL_COUNT, MESH_COUNT,
+                 ITERATIONS);
+    fmt::println("[INFO]: Push {:.3f} ms, radix sort {:.3f} ms, {} KiB of "
+                 "arena",
+                 push_milliseconds / ITERATIONS, sort_milliseconds / ITERATIONS,
+                 arena.get_used_bytes() / 1024);
+    fmt::println("[INFO]: Unsorted: record {:.3f} ms, {} pipeline binds, {} "
+                 "descriptor set binds",
+                 unsorted_record_milliseconds / ITERATIONS,
+                 unsorted_statistics.pipeline_binds,
+                 unsorted_statistics.descriptor_set_binds);
+    fmt::println("[INFO]: Sorted: sort + record {:.3f} ms, {} pipeline binds, "
+                 "{} descriptor set binds",
+                 (sort_milliseconds + sorted_record_milliseconds) / ITERATIONS,
+                 sorted_statistics.pipeline_binds,
+                 sorted_statistics.descriptor_set_binds);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "arena.hpp"
+#include "command_encoder.hpp"
+#include "geometry.hpp"
+#include "graphics.hpp"
+
+// What a draw's 64-bit sort key is made of. Sorting by key groups draws by
+// pass, then pipeline, material and mesh, so that recording them in order
+// switches state as rarely as possible. Within a group they are sorted front
+// to back.
+struct DrawKeyFields {
+    uint32_t pass;
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+    // View depth in [0, 1]. Quantized to 20 bits.
+    float depth;
+};
+
+// Bits, from most to least significant: pass (4), pipeline (10), material
+// (14), mesh (16), depth (20). Fields are truncated to their widths.
+auto make_sort_key(const DrawKeyFields &fields) -> uint64_t;
+
+auto get_sort_key_pass(uint64_t key) -> uint32_t;
+auto get_sort_key_pipeline(uint64_t key) -> uint32_t;
+auto get_sort_key_material(uint64_t key) -> uint32_t;
+auto get_sort_key_mesh(uint64_t key) -> uint32_t;
+
+struct DrawRecord {
+    uint64_t key;
+    // Becomes the first instance of the draw, which the vertex shader uses to
+    // find its object.
+    uint32_t object;
+    uint32_t padding;
+};
+
+// Draws pushed by any number of producers during a frame, sorted by key
+// before they are recorded. Records live in a frame arena, so the list has
+// to be rebuilt after the arena is reset.
+class DrawList {
+  public:
+    DrawList(FrameArena &arena, uint32_t capacity);
+
+    NO_COPY(DrawList);
+
+    void push(uint64_t key, uint32_t object);
+
+    // An LSD radix sort over the bytes of the key, skipping bytes that are
+    // the same in every key.
+    void sort();
+
+    inline auto get_records() const -> std::span<const DrawRecord> {
+        return records.first(count);
+    }
+
+    // The draws of one pass. Only valid after `sort`.
+    auto get_pass(uint32_t pass) const -> std::span<const DrawRecord>;
+
+  private:
+    FrameArena &arena;
+
+    std::span<DrawRecord> records;
+    uint32_t count;
+};
+
+// What the indices in sort keys refer to.
+struct DrawBindings {
+    VkPipelineLayout layout;
+    std::span<const VkPipeline> pipelines;
+    // Bound to set 0.
+    std::span<const VkDescriptorSet> materials;
+    std::span<const Mesh> meshes;
+};
+
+struct DrawListStatistics {
+    uint32_t draw_count;
+    uint32_t pipeline_binds;
+    uint32_t descriptor_set_binds;
+};
+
+// Records draws in order. The encoder drops the pipeline and material binds
+// that repeat the previous draw's. The geometry heap has to be bound already.
+auto record_draw_list(CommandEncoder &encoder,
+                      std::span<const DrawRecord> records,
+                      const DrawBindings &bindings) -> DrawListStatistics;
+
+// Pushes, sorts and records 100k draws over many pipelines, materials and
+// meshes, and compares with recording them unsorted.
+void run_draw_list_benchmark(const Device &device,
+                             const CommandPool &command_pool,
+                             const RenderPass &render_pass,
+                             const GeometryHeap &geometry, const Mesh &mesh);
@@ -0,0 +1,449 @@
+#include "geometry.hpp"
+
+namespace {
+constexpr std::array GEOMETRY_BINDINGS{
+    VkDescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .pImmutableSamplers = nullptr,
+    },
+};
+
+constexpr std::array GEOMETRY_POOL_SIZES{
+    VkDescriptorPoolSize{
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+    },
+};
+
+auto align_up(VkDeviceSize p_value, VkDeviceSize p_alignment) -> VkDeviceSize {
+    return (p_value + p_alignment - 1) / p_alignment * p_alignment;
+}
+
+// The memory a buffer of the given size and usage would need on its own.
+auto buffer_memory_size(const Device &p_device, VkDeviceSize p_size,
+                        VkBufferUsageFlags p_usage) -> VkDeviceSize {
+    const VkBufferCreateInfo create_info{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .size = p_size,
+        .usage = p_usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+    };
+
+    VkBuffer buffer;
+    VK_ERROR(vkCreateBuffer(p_device.get(), &create_info, nullptr, &buffer));
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(p_device.get(), buffer, &requirements);
+    vkDestroyBuffer(p_device.get(), buffer, nullptr);
+
+    return align_up(requirements.size, requirements.alignment);
+}
+
+double milliseconds_since(std::chrono::steady_clock::time_point p_start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - p_start)
+        .count();
+}
+
+void log_heap_statistics(std::string_view p_label,
+                         const GeometryHeapStatistics &p_statistics) {
+    fmt::println("[INFO]: {}: {} meshes, vertices {}/{} in {} free ranges "
+                 "(largest {}), indices {}/{} in {} free ranges (largest {})",
+                 p_label, p_statistics.mesh_count, p_statistics.vertices_used,
+                 p_statistics.vertex_capacity, p_statistics.vertex_free_ranges,
+                 p_statistics.largest_free_vertices, p_statistics.indices_used,
+                 p_statistics.index_capacity, p_statistics.index_free_ranges,
+                 p_statistics.largest_free_indices);
+}
+} // namespace
+
+GeometryHeap::GeometryHeap(const Device &p_device, uint32_t p_vertex_capacity,
+                           uint32_t p_index_capacity)
+    : device(p_device),
+      access(p_device.get_capabilities().buffer_device_address
+                 ? Access::DeviceAddress
+                 : Access::StorageBuffer),
+      vertex_allocator(p_vertex_capacity), index_allocator(p_index_capacity),
+      // Keeps the indices aligned to their own size whatever the vertex size.
+      index_offset(align_up(static_cast<VkDeviceSize>(p_vertex_capacity) *
+                                sizeof(Vertex),
+                            sizeof(uint32_t))),
+      buffer(p_device,
+             index_offset +
+                 static_cast<VkDeviceSize>(p_index_capacity) * sizeof(uint32_t),
+             Buffer::Type::Geometry),
+      vertex_address(access == Access::DeviceAddress
+                         ? buffer.get_device_address()
+                         : 0),
+      descriptor_set_layout(p_device, GEOMETRY_BINDINGS),
+      descriptor_pool(p_device, GEOMETRY_POOL_SIZES, 1),
+      descriptor_set(descriptor_pool.allocate(descriptor_set_layout)),
+      pulled_set_layouts{descriptor_set_layout.get()} {
+    write_storage_buffer(p_device, descriptor_set, 0, buffer);
+
+    buffer.set_debug_name("Geometry heap");
+
+    fmt::println("[INFO]: Geometry heap of {} vertices and {} indices ({} "
+                 "KiB), vertex pulling through {}.",
+                 p_vertex_capacity, p_index_capacity, buffer.get_size() / 1024,
+                 access == Access::DeviceAddress ? "buffer device address"
+                                                 : "a storage buffer");
+}
+
+auto GeometryHeap::try_allocate(uint32_t p_vertex_count,
+                                uint32_t p_index_count) -> std::optional<Mesh> {
+    const auto vertex_offset = vertex_allocator.allocate(p_vertex_count);
+    if (!vertex_offset.has_value()) {
+        return {};
+    }
+
+    const auto first_index = index_allocator.allocate(p_index_count);
+    if (!first_index.has_value()) {
+        vertex_allocator.free(vertex_offset.value());
+        return {};
+    }
+
+    return Mesh{
+        .first_index = first_index.value(),
+        .index_count = p_index_count,
+        .vertex_offset = static_cast<int32_t>(vertex_offset.value()),
+        .vertex_count = p_vertex_count,
+    };
+}
+
+auto GeometryHeap::allocate_mesh(uint32_t p_vertex_count,
+                                 uint32_t p_index_count) -> MeshId {
+    if (p_vertex_count == 0 || p_index_count == 0) {
+        fmt::println("[ERROR]: Meshes need at least one vertex and index.");
+        throw Error::InvalidFileError;
+    }
+
+    const auto mesh = try_allocate(p_vertex_count, p_index_count);
+    if (!mesh.has_value()) {
+        fmt::println("[ERROR]: The geometry heap is full.");
+        throw Error::OutOfMemoryError;
+    }
+
+    if (!free_ids.empty()) {
+        const auto id = free_ids.back();
+        free_ids.pop_back();
+        meshes.at(id) = mesh;
+        return id;
+    }
+
+    meshes.push_back(mesh);
+    return static_cast<MeshId>(meshes.size() - 1);
+}
+
+auto GeometryHeap::add_mesh(const CommandPool &p_command_pool,
+                            std::span<const Vertex> p_vertices,
+                            std::span<const uint32_t> p_indices) -> MeshId {
+    const auto id =
+        allocate_mesh(static_cast<uint32_t>(p_vertices.size()),
+                      static_cast<uint32_t>(p_indices.size()));
+    const auto &mesh = get_mesh(id);
+
+    buffer.load_using_staging(
+        p_command_pool, p_vertices.data(), p_vertices.size_bytes(),
+        static_cast<VkDeviceSize>(mesh.vertex_offset) * sizeof(Vertex));
+    buffer.load_using_staging(
+        p_command_pool, p_indices.data(), p_indices.size_bytes(),
+        index_offset +
+            static_cast<VkDeviceSize>(mesh.first_index) * sizeof(uint32_t));
+
+    return id;
+}
+
+void GeometryHeap::remove_mesh(MeshId p_id) {
+    auto &mesh = meshes.at(p_id);
+    if (!mesh.has_value()) {
+        fmt::println("[WARNING]: Removing mesh {}, which is not in the heap.",
+                     p_id);
+        return;
+    }
+
+    vertex_allocator.free(static_cast<uint32_t>(mesh->vertex_offset));
+    index_allocator.free(mesh->first_index);
+
+    mesh.reset();
+    free_ids.push_back(p_id);
+}
+
+void GeometryHeap::compact(const CommandPool &p_command_pool) {
+    // Source and destination ranges may overlap within the heap, so the live
+    // ranges are first packed into a scratch buffer and then copied back in
+    // two pieces.
+    Buffer scratch{device, buffer.get_size(), Buffer::Type::Geometry};
+
+    vertex_allocator.reset();
+    index_allocator.reset();
+
+    std::vector<VkBufferCopy> regions;
+    regions.reserve(meshes.size() * 2);
+
+    for (auto &mesh : meshes) {
+        if (!mesh.has_value()) {
+            continue;
+        }
+
+        // A fresh allocator has a single free range, so this packs the meshes
+        // one after another.
+        const auto packed =
+            try_allocate(mesh->vertex_count, mesh->index_count).value();
+
+        regions.push_back(VkBufferCopy{
+            .srcOffset =
+                static_cast<VkDeviceSize>(mesh->vertex_offset) * sizeof(Vertex),
+            .dstOffset =
+                static_cast<VkDeviceSize>(packed.vertex_offset) * sizeof(Vertex),
+            .size = static_cast<VkDeviceSize>(mesh->vertex_count) *
+                    sizeof(Vertex),
+        });
+        regions.push_back(VkBufferCopy{
+            .srcOffset = index_offset + static_cast<VkDeviceSize>(
+                                            mesh->first_index) *
+                                            sizeof(uint32_t),
+            .dstOffset = index_offset + static_cast<VkDeviceSize>(
+                                            packed.first_index) *
+                                            sizeof(uint32_t),
+            .size = static_cast<VkDeviceSize>(mesh->index_count) *
+                    sizeof(uint32_t),
+        });
+
+        mesh = packed;
+    }
+
+    if (regions.empty()) {
+        return;
+    }
+
+    const auto command_buffer = p_command_pool.begin_one_time();
+
+    vkCmdCopyBuffer(command_buffer, buffer.get(), scratch.get(),
+                    static_cast<uint32_t>(regions.size()), regions.data());
+
+    const VkMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+    };
+
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+
+    const std::array packed_regions{
+        VkBufferCopy{
+            .srcOffset = 0,
+            .dstOffset = 0,
+            .size = static_cast<VkDeviceSize>(vertex_allocator.get_used()) *
+                    sizeof(Vertex),
+        },
+        VkBufferCopy{
+            .srcOffset = index_offset,
+            .dstOffset = index_offset,
+            .size = static_cast<VkDeviceSize>(index_allocator.get_used()) *
+                    sizeof(uint32_t),
+        },
+    };
+
+    vkCmdCopyBuffer(command_buffer, scratch.get(), buffer.get(),
+                    static_cast<uint32_t>(packed_regions.size()),
+                    packed_regions.data());
+
+    p_command_pool.end_one_time(command_buffer);
+}
+
+auto GeometryHeap::get_statistics() const -> GeometryHeapStatistics {
+    return GeometryHeapStatistics{
+        .mesh_count = static_cast<uint32_t>(meshes.size() - free_ids.size()),
+        .vertices_used = vertex_allocator.get_used(),
+        .vertex_capacity = vertex_allocator.get_capacity(),
+        .largest_free_vertices = vertex_allocator.get_largest_free(),
+        .vertex_free_ranges = vertex_allocator.get_free_range_count(),
+        .indices_used = index_allocator.get_used(),
+        .index_capacity = index_allocator.get_capacity(),
+        .largest_free_indices = index_allocator.get_largest_free(),
+        .index_free_ranges = index_allocator.get_free_range_count(),
+    };
+}
+
+void GeometryHeap::bind(CommandEncoder &p_encoder) const {
+    p_encoder.bind_vertex_buffer(0, buffer.get(), 0);
+    p_encoder.bind_index_buffer(buffer.get(), index_offset,
+                                VK_INDEX_TYPE_UINT32);
+}
+
+void GeometryHeap::bind_pulled(CommandEncoder &p_encoder,
+                               VkPipelineLayout p_pipeline_layout) const {
+    p_encoder.bind_index_buffer(buffer.get(), index_offset,
+                                VK_INDEX_TYPE_UINT32);
+
+    const PushConstants push_constants{
+        .vertices = vertex_address,
+    };
+
+    p_encoder.push_constants(p_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                             sizeof(push_constants), &push_constants);
+
+    if (access == Access::StorageBuffer) {
+        p_encoder.bind_descriptor_set(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                      p_pipeline_layout, 1, descriptor_set);
+    }
+}
+
+auto GeometryHeap::get_pulled_vertex_shader() const -> std::string_view {
+    return access == Access::DeviceAddress ? "main_pulled_bda.vert"
+                                           : "main_pulled.vert";
+}
+
+auto GeometryHeap::get_descriptor_set_layouts() const
+    -> std::span<const VkDescriptorSetLayout> {
+    if (access == Access::DeviceAddress) {
+        return {};
+    }
+
+    return pulled_set_layouts;
+}
+
+void run_mesh_pool_benchmark(const Device &p_device,
+                             const CommandPool &p_command_pool) {
+    constexpr uint32_t MESH_COUNT = 10000;
+
+    // Meshes of 24 to 2048 vertices, drawn as quads.
+    std::mt19937 random{1234};
+    std::uniform_int_distribution<uint32_t> quad_counts{6, 512};
+
+    std::vector<std::pair<uint32_t, uint32_t>> sizes;
+    sizes.reserve(MESH_COUNT);
+
+    uint64_t total_vertices = 0;
+    uint64_t total_indices = 0;
+
+    for (uint32_t i = 0; i < MESH_COUNT; i++) {
+        const auto quads = quad_counts(random);
+        sizes.emplace_back(quads * 4, quads * 6);
+        total_vertices += quads * 4;
+        total_indices += quads * 6;
+    }
+
+    const auto raw_bytes = total_vertices * sizeof(Vertex) +
+                           total_indices * sizeof(uint32_t);
+
+    // One vertex and one index buffer per mesh. Only the memory requirements
+    // are queried, as the allocations alone could exceed the device's limit.
+    VkDeviceSize separate_bytes = 0;
+    for (const auto &[vertex_count, index_count] : sizes) {
+        separate_bytes += buffer_memory_size(
+            p_device, static_cast<VkDeviceSize>(vertex_count) * sizeof(Vertex),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        separate_bytes += buffer_memory_size(
+            p_device,
+            static_cast<VkDeviceSize>(index_count) * sizeof(uint32_t),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(p_device.get_physical(), &properties);
+
+    // 25% headroom for the fragmentation test below.
+    GeometryHeap heap{p_device,
+                      static_cast<uint32_t>(total_vertices + total_vertices / 4),
+                      static_cast<uint32_t>(total_indices + total_indices / 4)};
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<MeshId> ids;
+    ids.reserve(MESH_COUNT);
+    for (const auto &[vertex_count, index_count] : sizes) {
+        ids.push_back(heap.allocate_mesh(vertex_count, index_count));
+    }
+
+    const auto allocate_milliseconds = milliseconds_since(start);
+
+    // Binds the heap before every mesh's draw, as if each mesh had its own
+    // buffers, and counts the binds the encoder actually records.
+    const auto command_buffer = p_command_pool.begin_one_time();
+    CommandEncoder encoder{command_buffer};
+    for (size_t i = 0; i < ids.size(); i++) {
+        heap.bind(encoder);
+    }
+    p_command_pool.end_one_time(command_buffer);
+
+    const auto &binds = encoder.get_statistics();
+    const auto buffer_binds = [&](const auto &counts) {
+        return counts[static_cast<uint32_t>(EncoderCommand::BindVertexBuffer)] +
+               counts[static_cast<uint32_t>(EncoderCommand::BindIndexBuffer)];
+    };
+
+    const auto used_bytes =
+        static_cast<VkDeviceSize>(heap.get_statistics().vertices_used) *
+            sizeof(Vertex) +
+        static_cast<VkDeviceSize>(heap.get_statistics().indices_used) *
+            sizeof(uint32_t);
+
+    fmt::println("[INFO]: {} meshes, {} vertices, {} indices, {:.1f} MiB of "
+                 "geometry.",
+                 MESH_COUNT, total_vertices, total_indices,
+                 static_cast<double>(raw_bytes) / (1024.0 * 1024.0));
+    // The separate buffers are never created, so their binds are not
+    // recorded: each mesh would need its own vertex and index bind.
+    fmt::println("[INFO]: Separate buffers: {} allocations (device limit {}), "
+                 "{} buffer binds per frame (theoretical), {:.1f} MiB ({} "
+                 "KiB lost to alignment).",
+                 MESH_COUNT * 2, properties.limits.maxMemoryAllocationCount,
+                 MESH_COUNT * 2,
+                 static_cast<double>(separate_bytes) / (1024.0 * 1024.0),
+                 (separate_bytes - raw_bytes) / 1024);
+    fmt::println("[INFO]: Geometry heap: 1 allocation, {} buffer binds per "
+                 "frame ({} filtered), {:.1f} MiB used of {:.1f} MiB ({} KiB "
+                 "lost to alignment), {:.3f} ms to place every mesh.",
+                 buffer_binds(binds.issued), buffer_binds(binds.filtered),
+                 static_cast<double>(used_bytes) / (1024.0 * 1024.0),
+                 static_cast<double>(heap.get_buffer().get_size()) /
+                     (1024.0 * 1024.0),
+                 (used_bytes - raw_bytes) / 1024, allocate_milliseconds);
+
+    // Free every third mesh and refill the holes with new random meshes.
+    for (uint32_t i = 0; i < ids.size(); i += 3) {
+        heap.remove_mesh(ids.at(i));
+    }
+
+    log_heap_statistics("After freeing a third", heap.get_statistics());
+
+    start = std::chrono::steady_clock::now();
+
+    uint32_t refilled = 0;
+    for (uint32_t i = 0; i < ids.size(); i += 3) {
+        const auto quads = quad_counts(random);
+        try {
+            heap.allocate_mesh(quads * 4, quads * 6);
+            refilled++;
+        } catch (Error error) {
+            if (error != Error::OutOfMemoryError) {
+                throw;
+            }
+            break;
+        }
+    }
+
+    fmt::println("[INFO]: Refilled {} meshes in {:.3f} ms.", refilled,
+                 milliseconds_since(start));
+    log_heap_statistics("After refilling", heap.get_statistics());
+
+    start = std::chrono::steady_clock::now();
+    heap.compact(p_command_pool);
+
+    fmt::println("[INFO]: Compacted in {:.3f} ms.", milliseconds_since(start));
+    log_heap_statistics("After compacting", heap.get_statistics());
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "buffers.hpp"
+#include "command_encoder.hpp"
+#include "descriptors.hpp"
+#include "graphics.hpp"
+#include "offset_allocator.hpp"
+
+// Where a mesh lives inside a GeometryHeap. Maps directly onto the
+// firstIndex/vertexOffset/indexCount of an indexed draw.
+struct Mesh {
+    uint32_t first_index;
+    uint32_t index_count;
+    int32_t vertex_offset;
+    uint32_t vertex_count;
+};
+
+// Identifies a mesh in a GeometryHeap. Stays valid across compaction, unlike
+// the offsets in `Mesh`.
+using MeshId = uint32_t;
+
+struct GeometryHeapStatistics {
+    uint32_t mesh_count;
+    uint32_t vertices_used;
+    uint32_t vertex_capacity;
+    uint32_t largest_free_vertices;
+    uint32_t vertex_free_ranges;
+    uint32_t indices_used;
+    uint32_t index_capacity;
+    uint32_t largest_free_indices;
+    uint32_t index_free_ranges;
+};
+
+// Every mesh in one buffer: vertices at the front and 32-bit indices after
+// them, each region sub-allocated with an OffsetAllocator. Draws pick their
+// mesh with firstIndex and vertexOffset, so the whole heap is bound once per
+// pass no matter how many meshes are drawn.
+//
+// Besides the fixed-function vertex input, vertex shaders can pull vertices
+// themselves. That goes through the buffer's device address when the device
+// has buffer device address, and through a storage buffer descriptor (set 1)
+// otherwise.
+class GeometryHeap {
+  public:
+    enum class Access { DeviceAddress, StorageBuffer };
+
+    // Push constants of the vertex pulling shaders. Matches `Geometry` in
+    // main_pulled_bda.vert.
+    struct PushConstants {
+        // Zero with Access::StorageBuffer.
+        VkDeviceAddress vertices;
+    };
+
+    GeometryHeap(const Device &device, uint32_t vertex_capacity,
+                 uint32_t index_capacity);
+
+    NO_COPY(GeometryHeap);
+
+    // Reserves room for a mesh without uploading anything. Throws
+    // Error::OutOfMemoryError when either region has no large enough free
+    // range, in which case compacting may help if the heap is fragmented.
+    auto allocate_mesh(uint32_t vertex_count, uint32_t index_count) -> MeshId;
+
+    // Reserves room for a mesh and uploads it.
+    auto add_mesh(const CommandPool &command_pool,
+                  std::span<const Vertex> vertices,
+                  std::span<const uint32_t> indices) -> MeshId;
+
+    // Returns the mesh's ranges to the heap. The GPU must be done with it.
+    void remove_mesh(MeshId id);
+
+    // Moves every mesh to the front of its region, so that all free space
+    // forms a single range. Waits for the copies, and the GPU must not be
+    // using the heap. Offsets of meshes change, so anything that baked them
+    // (like culling objects) has to be rebuilt afterwards.
+    void compact(const CommandPool &command_pool);
+
+    inline const Mesh &get_mesh(MeshId id) const {
+        return meshes.at(id).value();
+    }
+
+    auto get_statistics() const -> GeometryHeapStatistics;
+
+    // Binds the heap as vertex buffer 0 and as the index buffer.
+    void bind(CommandEncoder &encoder) const;
+
+    // Binds the index buffer and whatever the vertex pulling shader reads the
+    // vertices through. The pipeline must have been created with
+    // `get_pulled_vertex_shader` and `get_descriptor_set_layouts`.
+    void bind_pulled(CommandEncoder &encoder,
+                     VkPipelineLayout pipeline_layout) const;
+
+    auto get_pulled_vertex_shader() const -> std::string_view;
+
+    // The set layouts to append to the pipeline's own for vertex pulling.
+    // Empty with Access::DeviceAddress.
+    auto get_descriptor_set_layouts() const
+        -> std::span<const VkDescriptorSetLayout>;
+
+    inline Access get_access() const { return access; }
+
+    inline const Buffer &get_buffer() const { return buffer; }
+
+    inline VkDeviceSize get_index_offset() const { return index_offset; }
+
+  private:
+    auto try_allocate(uint32_t vertex_count, uint32_t index_count)
+        -> std::optional<Mesh>;
+
+    const Device &device;
+
+    Access access;
+
+    OffsetAllocator vertex_allocator;
+    OffsetAllocator index_allocator;
+    VkDeviceSize index_offset;
+
+    // Indexed by MeshId. Removed meshes leave an empty slot that is reused.
+    std::vector<std::optional<Mesh>> meshes;
+    std::vector<MeshId> free_ids;
+
+    Buffer buffer;
+    // Zero with Access::StorageBuffer.
+    VkDeviceAddress vertex_address;
+
+    DescriptorSetLayout descriptor_set_layout;
+    DescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_set;
+    std::array<VkDescriptorSetLayout, 1> pulled_set_layouts;
+};
+
+// Places 10,000 meshes of random sizes in a geometry heap and compares that
+// with giving every mesh its own vertex and index buffer: allocations,
+// memory lost to alignment and buffer binds per frame, which are counted
+// from a recording for the heap and derived for separate buffers. Then frees
+// a third of the meshes, refills the holes and compacts the heap.
+void run_mesh_pool_benchmark(const Device &device,
+                             const CommandPool &command_pool);
@@ -1,19 +1,43 @@
 #include "graphics.hpp"
 #include "present.hpp"
+#include "shaders.hpp"
+#include "trace.hpp"
 #include <vulkan/vulkan_core.h>
 
-RenderPass::RenderPass(const Device &p_device, const Swapchain &p_swapchain)
+RenderPass::RenderPass(const Device &p_device, VkFormat p_color_format,
+                       Type p_type)
     : device(p_device) {
-    VkAttachmentDescription color_attachment{
-        .flags = 0,
-        .format = p_swapchain.get_format(),
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+    // A Clear pass starts the frame and a Load pass continues from what was
+    // drawn before. Attachments stay in their attachment layouts before and
+    // after the pass; the render graph transitions them and synchronizes with
+    // the passes around it.
+    const auto is_clear = p_type == Type::Clear;
+
+    const std::array attachments{
+        VkAttachmentDescription{
+            .flags = 0,
+            .format = p_color_format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = is_clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                               : VK_ATTACHMENT_LOAD_OP_LOAD,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        },
+        VkAttachmentDescription{
+            .flags = 0,
+            .format = DEPTH_FORMAT,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = is_clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                               : VK_ATTACHMENT_LOAD_OP_LOAD,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        },
     };
 
     VkAttachmentReference color_attachment_ref{
@@ -21,6 +45,11 @@ RenderPass::RenderPass(const Device &p_device, const Swapchain &p_swapchain)
         .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
     };
 
+    VkAttachmentReference depth_attachment_ref{
+        .attachment = 1,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    };
+
     VkSubpassDescription subpass{
         .flags = 0,
         .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -29,31 +58,21 @@ RenderPass::RenderPass(const Device &p_device, const Swapchain &p_swapchain)
         .colorAttachmentCount = 1,
         .pColorAttachments = &color_attachment_ref,
         .pResolveAttachments = nullptr,
-        .pDepthStencilAttachment = nullptr,
+        .pDepthStencilAttachment = &depth_attachment_ref,
         .preserveAttachmentCount = 0,
         .pPreserveAttachments = nullptr,
     };
 
-    VkSubpassDependency dependency{
-        .srcSubpass = VK_SUBPASS_EXTERNAL,
-        .dstSubpass = 0,
-        .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        .dependencyFlags = 0,
-    };
-
     VkRenderPassCreateInfo render_pass_info{
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .attachmentCount = 1,
-        .pAttachments = &color_attachment,
+        .attachmentCount = static_cast<uint32_t>(attachments.size()),
+        .pAttachments = attachments.data(),
         .subpassCount = 1,
         .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency,
+        .dependencyCount = 0,
+        .pDependencies = nullptr,
     };
 
     const auto result = vkCreateRenderPass(device.get(), &render_pass_info,
@@ -66,20 +85,29 @@ RenderPass::RenderPass(const Device &p_device, const Swapchain &p_swapchain)
 }
 
 void RenderPass::begin(VkCommandBuffer command_buffer,
-                       const Swapchain &swapchain, VkFramebuffer framebuffer,
+                       VkFramebuffer framebuffer, VkExtent2D render_area,
                        glm::vec4 clear_color) const {
 
-    const VkClearValue clear_value{
-        .color =
-            {
-                .float32 =
-                    {
-                        clear_color.r,
-                        clear_color.g,
-                        clear_color.b,
-                        clear_color.a,
-                    },
-            },
+    const std::array clear_values{
+        VkClearValue{
+            .color =
+                {
+                    .float32 =
+                        {
+                            clear_color.r,
+                            clear_color.g,
+                            clear_color.b,
+                            clear_color.a,
+                        },
+                },
+        },
+        VkClearValue{
+            .depthStencil =
+                {
+                    .depth = 1.0f,
+                    .stencil = 0,
+                },
+        },
     };
 
     const VkRenderPassBeginInfo render_pass_begin_info{
@@ -94,30 +122,34 @@ void RenderPass::begin(VkCommandBuffer command_buffer,
                         .x = 0,
                         .y = 0,
                     },
-                .extent = swapchain.get_extent(),
+                .extent = render_area,
             },
-        .clearValueCount = 1,
-        .pClearValues = &clear_value,
+        .clearValueCount = static_cast<uint32_t>(clear_values.size()),
+        .pClearValues = clear_values.data(),
     };
 
     vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info,
                          VK_SUBPASS_CONTENTS_INLINE);
 }
 
-void Framebuffers::create(const Device &p_device, const Swapchain &p_swapchain,
-                          const RenderPass &p_render_pass) {
-    framebuffers.reserve(p_swapchain.get_image_views().size());
+void Framebuffers::create(const Device &p_device,
+                          const RenderPass &p_render_pass,
+                          std::span<const VkImageView> p_color_views,
+                          VkImageView p_depth_view, VkExtent2D p_extent) {
+    framebuffers.reserve(p_color_views.size());
+
+    for (const auto image_view : p_color_views) {
+        const std::array attachments{image_view, p_depth_view};
 
-    for (const auto image_view : p_swapchain.get_image_views()) {
         const VkFramebufferCreateInfo fb_info{
             .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0,
             .renderPass = p_render_pass.get(),
-            .attachmentCount = 1,
-            .pAttachments = &image_view,
-            .width = p_swapchain.get_extent().width,
-            .height = p_swapchain.get_extent().height,
+            .attachmentCount = static_cast<uint32_t>(attachments.size()),
+            .pAttachments = attachments.data(),
+            .width = p_extent.width,
+            .height = p_extent.height,
             .layers = 1,
         };
 
@@ -135,11 +167,14 @@ void Framebuffers::create(const Device &p_device, const Swapchain &p_swapchain,
 
 GraphicsPipeline::GraphicsPipeline(
     const Device &p_device, const RenderPass &p_render_pass,
-    std::string_view p_vertex_shader_path,
-    std::string_view p_fragment_shader_path,
+    std::string_view p_vertex_shader_name,
+    std::string_view p_fragment_shader_name,
     std::span<const VkPushConstantRange> push_constant_ranges,
-    std::span<const VkDescriptorSetLayout> p_descriptor_set_layouts)
+    std::span<const VkDescriptorSetLayout> p_descriptor_set_layouts,
+    VertexInput p_vertex_input, Blend p_blend)
     : render_pass(p_render_pass), device(p_device) {
+    TRACE_SCOPE("GraphicsPipeline");
+
     const VkPipelineLayoutCreateInfo pipeline_layout_create_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext = nullptr,
@@ -161,15 +196,15 @@ GraphicsPipeline::GraphicsPipeline(
         throw Error::VulkanError;
     }
 
-    const auto vertex_shader_code = read_as_bytes(p_vertex_shader_path);
-    const auto fragment_shader_code = read_as_bytes(p_fragment_shader_path);
+    const auto vertex_shader_code = find_shader(p_vertex_shader_name);
+    const auto fragment_shader_code = find_shader(p_fragment_shader_name);
 
     const VkShaderModuleCreateInfo vertex_shader_module_create_info{
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .codeSize = vertex_shader_code.size(),
-        .pCode = reinterpret_cast<const uint32_t *>(vertex_shader_code.data()),
+        .codeSize = vertex_shader_code.size_bytes(),
+        .pCode = vertex_shader_code.data(),
     };
 
     VkShaderModule vertex_shader_module;
@@ -179,7 +214,7 @@ GraphicsPipeline::GraphicsPipeline(
 
     if (result != VK_SUCCESS) {
         fmt::println("[ERROR]: Failed to create the shader module for {}: {}",
-                     p_vertex_shader_path, result);
+                     p_vertex_shader_name, result);
         throw Error::VulkanError;
     }
 
@@ -187,9 +222,8 @@ GraphicsPipeline::GraphicsPipeline(
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .codeSize = fragment_shader_code.size(),
-        .pCode =
-            reinterpret_cast<const uint32_t *>(fragment_shader_code.data()),
+        .codeSize = fragment_shader_code.size_bytes(),
+        .pCode = fragment_shader_code.data(),
     };
 
     VkShaderModule fragment_shader_module;
@@ -199,7 +233,7 @@ GraphicsPipeline::GraphicsPipeline(
 
     if (result != VK_SUCCESS) {
         fmt::println("[ERROR]: Failed to create the shader module for {}: {}",
-                     p_fragment_shader_path, result);
+                     p_fragment_shader_name, result);
         throw Error::VulkanError;
     }
 
@@ -223,14 +257,21 @@ GraphicsPipeline::GraphicsPipeline(
         },
     };
 
+    const auto has_attributes = p_vertex_input == VertexInput::Attributes;
+
     const VkPipelineVertexInputStateCreateInfo vertex_input_state_create_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .vertexBindingDescriptionCount = 1,
-        .pVertexBindingDescriptions = &vertex_input_binding_description,
-        .vertexAttributeDescriptionCount = vertex_attribute_descriptions.size(),
-        .pVertexAttributeDescriptions = vertex_attribute_descriptions.data(),
+        .vertexBindingDescriptionCount = has_attributes ? 1u : 0u,
+        .pVertexBindingDescriptions =
+            has_attributes ? &vertex_input_binding_description : nullptr,
+        .vertexAttributeDescriptionCount =
+            has_attributes ? static_cast<uint32_t>(
+                                 vertex_attribute_descriptions.size())
+                           : 0u,
+        .pVertexAttributeDescriptions =
+            has_attributes ? vertex_attribute_descriptions.data() : nullptr,
     };
 
     const VkPipelineInputAssemblyStateCreateInfo input_assembly_state{
@@ -293,13 +334,17 @@ GraphicsPipeline::GraphicsPipeline(
         .maxDepthBounds = 0.0f,
     };
 
+    const auto additive = p_blend == Blend::Additive;
+    const auto blend_factor =
+        additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ZERO;
+
     const VkPipelineColorBlendAttachmentState color_blend_attachment{
-        .blendEnable = VK_FALSE,
-        .srcColorBlendFactor = VK_BLEND_FACTOR_ZERO,
-        .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .blendEnable = additive ? VK_TRUE : VK_FALSE,
+        .srcColorBlendFactor = blend_factor,
+        .dstColorBlendFactor = blend_factor,
         .colorBlendOp = VK_BLEND_OP_ADD,
-        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .srcAlphaBlendFactor = blend_factor,
+        .dstAlphaBlendFactor = blend_factor,
         .alphaBlendOp = VK_BLEND_OP_ADD,
         .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
                           VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
@@ -370,3 +415,84 @@ GraphicsPipeline::GraphicsPipeline(
     vkDestroyShaderModule(p_device.get(), vertex_shader_module, nullptr);
     vkDestroyShaderModule(p_device.get(), fragment_shader_module, nullptr);
 }
+
+ComputePipeline::ComputePipeline(
+    const Device &p_device, std::string_view p_compute_shader_name,
+    std::span<const VkPushConstantRange> p_push_constant_ranges,
+    std::span<const VkDescriptorSetLayout> p_descriptor_set_layouts)
+    : device(p_device) {
+    TRACE_SCOPE("ComputePipeline");
+
+    const VkPipelineLayoutCreateInfo pipeline_layout_create_info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .setLayoutCount =
+            static_cast<uint32_t>(p_descriptor_set_layouts.size()),
+        .pSetLayouts = p_descriptor_set_layouts.data(),
+        .pushConstantRangeCount =
+            static_cast<uint32_t>(p_push_constant_ranges.size()),
+        .pPushConstantRanges = p_push_constant_ranges.data(),
+    };
+
+    auto result = vkCreatePipelineLayout(
+        p_device.get(), &pipeline_layout_create_info, nullptr, &layout);
+
+    if (result != VK_SUCCESS) {
+        fmt::println("[ERROR]: Failed to create the Vulkan pipeline layout: {}",
+                     result);
+        throw Error::VulkanError;
+    }
+
+    const auto compute_shader_code = find_shader(p_compute_shader_name);
+
+    const VkShaderModuleCreateInfo compute_shader_module_create_info{
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .codeSize = compute_shader_code.size_bytes(),
+        .pCode = compute_shader_code.data(),
+    };
+
+    VkShaderModule compute_shader_module;
+    result =
+        vkCreateShaderModule(p_device.get(), &compute_shader_module_create_info,
+                             nullptr, &compute_shader_module);
+
+    if (result != VK_SUCCESS) {
+        fmt::println("[ERROR]: Failed to create the shader module for {}: {}",
+                     p_compute_shader_name, result);
+        throw Error::VulkanError;
+    }
+
+    const VkComputePipelineCreateInfo pipeline_create_info{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .stage =
+            VkPipelineShaderStageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = compute_shader_module,
+                .pName = "main",
+                .pSpecializationInfo = nullptr,
+            },
+        .layout = layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+
+    result =
+        vkCreateComputePipelines(p_device.get(), VK_NULL_HANDLE, 1,
+                                 &pipeline_create_info, nullptr, &pipeline);
+
+    if (result != VK_SUCCESS) {
+        fmt::println("[ERROR]: Failed to create the Vulkan compute pipeline: {}",
+                     result);
+        throw Error::VulkanError;
+    }
+
+    vkDestroyShaderModule(p_device.get(), compute_shader_module, nullptr);
+}
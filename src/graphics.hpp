@@ -3,15 +3,29 @@
 #include "devices.hpp"
 #include "present.hpp"
 
+constexpr VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+
 class RenderPass {
   public:
-    explicit RenderPass(const Device &device, const Swapchain &swapchain);
+    // Clear starts a frame; Load continues drawing on top of an earlier pass.
+    // Both are compatible with the same framebuffers and pipelines.
+    enum class Type { Clear, Load };
+
+    inline RenderPass(const Device &device, const Swapchain &swapchain,
+                      Type type)
+        : RenderPass(device, swapchain.get_format(), type) {}
+
+    // For drawing to images that are not presented, e.g. when replaying.
+    RenderPass(const Device &device, VkFormat color_format, Type type);
 
     NO_COPY(RenderPass);
 
     inline VkRenderPass get() const { return render_pass; }
 
-    void begin(VkCommandBuffer command_buffer, const Swapchain& swapchain, VkFramebuffer framebuffer, glm::vec4 clear_color) const;
+    // Only `render_area`, from the framebuffer's top left corner, is drawn
+    // to and cleared.
+    void begin(VkCommandBuffer command_buffer, VkFramebuffer framebuffer,
+               VkExtent2D render_area, glm::vec4 clear_color) const;
 
     inline ~RenderPass() {
         vkDestroyRenderPass(device.get(), render_pass, nullptr);
@@ -25,12 +39,20 @@ class RenderPass {
 
 struct Framebuffers {
   public:
-    Framebuffers(const Device &device, const Swapchain &swapchain,
-                 const RenderPass &render_pass): device(device) {
-        create(device, swapchain, render_pass);
+    // Empty until `create` is called.
+    explicit Framebuffers(const Device &device) : device(device) {}
+
+    Framebuffers(const Device &device, const RenderPass &render_pass,
+                 std::span<const VkImageView> color_views,
+                 VkImageView depth_view, VkExtent2D extent)
+        : device(device) {
+        create(device, render_pass, color_views, depth_view, extent);
     }
 
-    void create(const Device &device, const Swapchain &swapchain, const RenderPass &render_pass);
+    // One framebuffer per color view, all sharing the depth view.
+    void create(const Device &device, const RenderPass &render_pass,
+                std::span<const VkImageView> color_views,
+                VkImageView depth_view, VkExtent2D extent);
 
     inline VkFramebuffer get(size_t i) const { return framebuffers.at(i); }
 
@@ -56,17 +78,42 @@ struct Framebuffers {
 
 class GraphicsPipeline {
   public:
+    enum class VertexInput {
+        // Vertices come from vertex buffer 0, laid out as `Vertex`.
+        Attributes,
+        // The vertex shader fetches its own vertices by gl_VertexIndex.
+        Pulled
+    };
+
+    enum class Blend {
+        // Fragments replace what is under them.
+        Opaque,
+        // Fragments are added to what is under them, e.g. to count overdraw.
+        Additive
+    };
+
     GraphicsPipeline(
         const Device &device, const RenderPass &p_render_pass,
-        std::string_view vertex_shader_path,
-        std::string_view fragment_shader_path,
+        std::string_view vertex_shader_name,
+        std::string_view fragment_shader_name,
         std::span<const VkPushConstantRange> push_constant_ranges,
-        std::span<const VkDescriptorSetLayout> descriptor_set_layouts);
+        std::span<const VkDescriptorSetLayout> descriptor_set_layouts,
+        VertexInput vertex_input = VertexInput::Attributes,
+        Blend blend = Blend::Opaque);
 
     NO_COPY(GraphicsPipeline);
 
     inline VkPipeline get() const { return pipeline; }
 
+    inline VkPipelineLayout get_layout() const { return layout; }
+
+    inline void set_debug_name(std::string_view name) const {
+        ::set_debug_name(device, VK_OBJECT_TYPE_PIPELINE,
+                         to_debug_handle(pipeline), name);
+        ::set_debug_name(device, VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                         to_debug_handle(layout), name);
+    }
+
     inline ~GraphicsPipeline() {
         vkDestroyPipelineLayout(device.get(), layout, nullptr);
         vkDestroyPipeline(device.get(), pipeline, nullptr);
@@ -81,6 +128,38 @@ class GraphicsPipeline {
     const Device &device;
 };
 
+class ComputePipeline {
+  public:
+    ComputePipeline(
+        const Device &device, std::string_view compute_shader_name,
+        std::span<const VkPushConstantRange> push_constant_ranges,
+        std::span<const VkDescriptorSetLayout> descriptor_set_layouts);
+
+    NO_COPY(ComputePipeline);
+
+    inline VkPipeline get() const { return pipeline; }
+
+    inline VkPipelineLayout get_layout() const { return layout; }
+
+    inline void set_debug_name(std::string_view name) const {
+        ::set_debug_name(device, VK_OBJECT_TYPE_PIPELINE,
+                         to_debug_handle(pipeline), name);
+        ::set_debug_name(device, VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                         to_debug_handle(layout), name);
+    }
+
+    inline ~ComputePipeline() {
+        vkDestroyPipelineLayout(device.get(), layout, nullptr);
+        vkDestroyPipeline(device.get(), pipeline, nullptr);
+    }
+
+  private:
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+
+    const Device &device;
+};
+
 struct Vertex {
     glm::vec3 position;
 };
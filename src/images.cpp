@@ -0,0 +1,161 @@
+#include "images.hpp"
+
+namespace {
+VkImageView create_view(const Device &p_device, VkImage p_image,
+                        VkFormat p_format, VkImageAspectFlags p_aspect,
+                        uint32_t p_base_level, uint32_t p_level_count) {
+    const VkImageViewCreateInfo view_info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .image = p_image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = p_format,
+        .components =
+            {
+                .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .a = VK_COMPONENT_SWIZZLE_IDENTITY,
+            },
+        .subresourceRange =
+            {
+                .aspectMask = p_aspect,
+                .baseMipLevel = p_base_level,
+                .levelCount = p_level_count,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+
+    VkImageView view;
+    VK_ERROR(vkCreateImageView(p_device.get(), &view_info, nullptr, &view));
+    return view;
+}
+} // namespace
+
+Image::Image(const Device &p_device, VkExtent2D p_extent, VkFormat p_format,
+             VkImageUsageFlags p_usage, VkImageAspectFlags p_aspect,
+             uint32_t p_mip_levels, Memory p_memory)
+    : memory(VK_NULL_HANDLE), view(VK_NULL_HANDLE), format(p_format),
+      extent(p_extent), mip_levels(p_mip_levels), aspect(p_aspect),
+      owns_memory(p_memory == Memory::Owned), device(p_device) {
+    const VkImageCreateInfo image_info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent =
+            {
+                .width = extent.width,
+                .height = extent.height,
+                .depth = 1,
+            },
+        .mipLevels = mip_levels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = p_usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    auto result = vkCreateImage(device.get(), &image_info, nullptr, &image);
+    if (result != VK_SUCCESS) {
+        fmt::println("[ERROR]: Failed to create an image: {}", result);
+        throw Error::VulkanError;
+    }
+
+    if (!owns_memory) {
+        return;
+    }
+
+    const auto memory_requirements = get_memory_requirements();
+
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(device.get_physical(),
+                                        &memory_properties);
+
+    std::optional<uint32_t> memory_type_index;
+
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+        const auto property_flags =
+            memory_properties.memoryTypes[i].propertyFlags;
+
+        const auto has_type_bit =
+            (memory_requirements.memoryTypeBits & (1 << i)) != 0;
+
+        const auto is_device_local =
+            (property_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+
+        if (has_type_bit && is_device_local) {
+            memory_type_index = i;
+            break;
+        }
+    }
+
+    if (!memory_type_index.has_value()) {
+        fmt::println("[ERROR]: No device local memory type for an image.");
+        vkDestroyImage(device.get(), image, nullptr);
+        throw Error::OutOfMemoryError;
+    }
+
+    const VkMemoryAllocateInfo memory_allocate_info{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .allocationSize = memory_requirements.size,
+        .memoryTypeIndex = memory_type_index.value(),
+    };
+
+    const auto is_texture =
+        (p_usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                    VK_IMAGE_USAGE_STORAGE_BIT)) == 0;
+
+    memory = device.get_memory_tracker().allocate(
+        device.get(), memory_allocate_info,
+        is_texture ? MemoryCategory::Texture : MemoryCategory::Attachment);
+    VK_ERROR(vkBindImageMemory(device.get(), image, memory, 0));
+
+    create_views();
+}
+
+auto Image::get_memory_requirements() const -> VkMemoryRequirements {
+    VkMemoryRequirements memory_requirements;
+    vkGetImageMemoryRequirements(device.get(), image, &memory_requirements);
+    return memory_requirements;
+}
+
+void Image::bind_memory(VkDeviceMemory p_memory, VkDeviceSize p_offset) {
+    VK_ERROR(vkBindImageMemory(device.get(), image, p_memory, p_offset));
+    create_views();
+}
+
+void Image::create_views() {
+    view = create_view(device, image, format, aspect, 0, mip_levels);
+
+    if (mip_levels > 1) {
+        mip_views.reserve(mip_levels);
+
+        for (uint32_t level = 0; level < mip_levels; level++) {
+            mip_views.push_back(
+                create_view(device, image, format, aspect, level, 1));
+        }
+    }
+}
+
+Image::~Image() {
+    for (const auto mip_view : mip_views) {
+        vkDestroyImageView(device.get(), mip_view, nullptr);
+    }
+
+    vkDestroyImageView(device.get(), view, nullptr);
+    vkDestroyImage(device.get(), image, nullptr);
+
+    if (owns_memory) {
+        device.get_memory_tracker().free(device.get(), memory);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "devices.hpp"
+
+class Image {
+  public:
+    enum class Memory {
+        // The image allocates and frees its own device-local memory.
+        Owned,
+        // The image is bound to memory owned by someone else, possibly shared
+        // with other images, with `bind_memory`. There are no views before
+        // that.
+        External
+    };
+
+    Image(const Device &device, VkExtent2D extent, VkFormat format,
+          VkImageUsageFlags usage, VkImageAspectFlags aspect,
+          uint32_t mip_levels = 1, Memory memory = Memory::Owned);
+
+    NO_COPY(Image);
+
+    auto get_memory_requirements() const -> VkMemoryRequirements;
+
+    // Binds an image created with Memory::External and creates its views.
+    void bind_memory(VkDeviceMemory memory, VkDeviceSize offset);
+
+    inline VkImage get() const { return image; }
+
+    // A view over every mip level of the image.
+    inline VkImageView get_view() const { return view; }
+
+    // A view over a single mip level. Only available for images with more
+    // than one mip level.
+    inline VkImageView get_mip_view(uint32_t level) const {
+        return mip_views.at(level);
+    }
+
+    inline VkFormat get_format() const { return format; }
+
+    inline const VkExtent2D &get_extent() const { return extent; }
+
+    inline uint32_t get_mip_levels() const { return mip_levels; }
+
+    inline VkImageAspectFlags get_aspect() const { return aspect; }
+
+    inline void set_debug_name(std::string_view name) const {
+        ::set_debug_name(device, VK_OBJECT_TYPE_IMAGE, to_debug_handle(image),
+                         name);
+        ::set_debug_name(device, VK_OBJECT_TYPE_IMAGE_VIEW,
+                         to_debug_handle(view), name);
+    }
+
+    ~Image();
+
+  private:
+    void create_views();
+
+    VkImage image;
+    VkDeviceMemory memory;
+    VkImageView view;
+    std::vector<VkImageView> mip_views;
+
+    VkFormat format;
+    VkExtent2D extent;
+    uint32_t mip_levels;
+    VkImageAspectFlags aspect;
+    bool owns_memory;
+
+    const Device &device;
+};
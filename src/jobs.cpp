@@ -0,0 +1,240 @@
+#include "jobs.hpp"
+
+namespace {
+// The deque of the current thread, if it has one.
+thread_local const JobSystem *current_system = nullptr;
+thread_local uint32_t current_queue = 0;
+
+// Failed attempts to find a job before a worker goes to sleep.
+constexpr uint32_t IDLE_SPINS = 64;
+
+auto elapsed_nanoseconds(std::chrono::steady_clock::time_point p_start)
+    -> double {
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - p_start)
+        .count();
+}
+} // namespace
+
+JobSystem::JobSystem(uint32_t p_worker_count) {
+    auto worker_count = p_worker_count;
+    if (worker_count == 0) {
+        worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    for (uint32_t i = 0; i <= worker_count; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    current_system = this;
+    current_queue = 0;
+
+    workers.reserve(worker_count);
+    for (uint32_t i = 1; i <= worker_count; i++) {
+        workers.emplace_back([this, i]() { worker_main(i); });
+    }
+
+    fmt::println("[INFO]: Started {} job worker threads.", worker_count);
+}
+
+void JobSystem::run(JobCounter &p_counter, Job p_job) {
+    p_counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    auto &queue = *queues[get_queue_index()];
+    {
+        const std::lock_guard lock{queue.mutex};
+        queue.jobs.push_back(QueuedJob{std::move(p_job), &p_counter});
+    }
+
+    queued_jobs.fetch_add(1);
+    if (sleeping_workers.load() > 0) {
+        const std::lock_guard lock{sleep_mutex};
+        wake.notify_one();
+    }
+}
+
+void JobSystem::wait(const JobCounter &p_counter) {
+    const auto index = get_queue_index();
+
+    while (!p_counter.is_done()) {
+        if (!run_one(index)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallel_for(
+    uint32_t p_count, uint32_t p_batch_size,
+    const std::function<void(uint32_t, uint32_t)> &p_function) {
+    if (p_count == 0) {
+        return;
+    }
+
+    JobCounter counter;
+    split(counter, 0, p_count, std::max(p_batch_size, 1u), p_function);
+    wait(counter);
+}
+
+void JobSystem::split(
+    JobCounter &p_counter, uint32_t p_begin, uint32_t p_end,
+    uint32_t p_batch_size,
+    const std::function<void(uint32_t, uint32_t)> &p_function) {
+    // The upper half goes to the deque, where thieves find it, and this
+    // thread carries on with the lower half.
+    while (p_end - p_begin > p_batch_size) {
+        const auto middle = p_begin + (p_end - p_begin) / 2;
+        run(p_counter, [this, &p_counter, middle, p_end, p_batch_size,
+                        &p_function]() {
+            split(p_counter, middle, p_end, p_batch_size, p_function);
+        });
+        p_end = middle;
+    }
+
+    p_function(p_begin, p_end);
+}
+
+bool JobSystem::run_one(uint32_t p_index) {
+    std::optional<QueuedJob> job;
+
+    {
+        auto &own = *queues[p_index];
+        const std::lock_guard lock{own.mutex};
+        if (!own.jobs.empty()) {
+            job.emplace(std::move(own.jobs.back()));
+            own.jobs.pop_back();
+        }
+    }
+
+    for (uint32_t i = 1; !job.has_value() && i < queues.size(); i++) {
+        auto &victim = *queues[(p_index + i) % queues.size()];
+        const std::lock_guard lock{victim.mutex};
+        if (!victim.jobs.empty()) {
+            job.emplace(std::move(victim.jobs.front()));
+            victim.jobs.pop_front();
+        }
+    }
+
+    if (!job.has_value()) {
+        return false;
+    }
+
+    queued_jobs.fetch_sub(1);
+    job->job();
+    job->counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::worker_main(uint32_t p_index) {
+    current_system = this;
+    current_queue = p_index;
+
+    uint32_t idle_spins = 0;
+
+    while (!stopping.load()) {
+        if (run_one(p_index)) {
+            idle_spins = 0;
+            continue;
+        }
+
+        if (++idle_spins < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock lock{sleep_mutex};
+        sleeping_workers.fetch_add(1);
+        wake.wait(lock, [this]() {
+            return queued_jobs.load() > 0 || stopping.load();
+        });
+        sleeping_workers.fetch_sub(1);
+        idle_spins = 0;
+    }
+}
+
+auto JobSystem::get_queue_index() -> uint32_t {
+    if (current_system == this) {
+        return current_queue;
+    }
+
+    return next_external_queue.fetch_add(1, std::memory_order_relaxed) %
+           static_cast<uint32_t>(queues.size());
+}
+
+JobSystem::~JobSystem() {
+    {
+        const std::lock_guard lock{sleep_mutex};
+        stopping.store(true);
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (current_system == this) {
+        current_system = nullptr;
+    }
+}
+
+void run_job_benchmark(JobSystem &p_jobs) {
+    constexpr uint32_t JOB_COUNT = 1 << 20;
+    constexpr uint32_t ITEM_COUNT = 1 << 24;
+    constexpr std::array batch_sizes{1u << 6, 1u << 10, 1u << 14, 1u << 18};
+
+    fmt::println("[INFO]: Job system benchmark ({} threads)",
+                 p_jobs.get_thread_count());
+
+    // Empty jobs, so that only the scheduling is measured.
+    std::atomic<uint32_t> executed{0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < JOB_COUNT; i++) {
+        const JobSystem::Job job = [&executed]() {
+            executed.fetch_add(1, std::memory_order_relaxed);
+        };
+        job();
+    }
+    const auto inline_nanoseconds = elapsed_nanoseconds(start);
+
+    JobCounter counter;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < JOB_COUNT; i++) {
+        p_jobs.run(counter, [&executed]() {
+            executed.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    p_jobs.wait(counter);
+    const auto job_nanoseconds = elapsed_nanoseconds(start);
+
+    fmt::println("[INFO]: {} empty jobs: {:.1f} ns per job, {:.1f} ns per "
+                 "inline call",
+                 JOB_COUNT, job_nanoseconds / JOB_COUNT,
+                 inline_nanoseconds / JOB_COUNT);
+
+    // A light per-item workload, where the batch size decides whether
+    // scheduling or the work dominates.
+    std::vector<float> values(ITEM_COUNT);
+    const auto work = [&values](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i < end; i++) {
+            values[i] = std::sqrt(static_cast<float>(i));
+        }
+    };
+
+    start = std::chrono::steady_clock::now();
+    work(0, ITEM_COUNT);
+    const auto serial_milliseconds = elapsed_nanoseconds(start) / 1e6;
+
+    fmt::println("[INFO]: {} items serially: {:.3f} ms", ITEM_COUNT,
+                 serial_milliseconds);
+
+    for (const auto batch_size : batch_sizes) {
+        start = std::chrono::steady_clock::now();
+        p_jobs.parallel_for(ITEM_COUNT, batch_size, work);
+        const auto milliseconds = elapsed_nanoseconds(start) / 1e6;
+
+        fmt::println("[INFO]: {} items in batches of {}: {:.3f} ms "
+                     "({:.2f}x serial)",
+                     ITEM_COUNT, batch_size, milliseconds,
+                     serial_milliseconds / milliseconds);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "common.hpp"
+
+// Counts the jobs started with it that have not finished yet. Jobs started
+// with a counter from within a job that uses the same counter act as its
+// children: waiting on the counter waits for them as well.
+class JobCounter {
+  public:
+    JobCounter() = default;
+
+    NO_COPY(JobCounter);
+
+    inline bool is_done() const {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+  private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending{0};
+};
+
+// A work-stealing scheduler. Every worker thread, and the thread that created
+// the system, owns a deque: it pushes and pops its own jobs at the back, and
+// idle workers steal from the front of the others'. Waiting on a counter runs
+// other jobs instead of blocking, so jobs may wait on their children.
+class JobSystem {
+  public:
+    using Job = std::function<void()>;
+
+    // Zero starts one worker per hardware thread besides the calling one.
+    explicit JobSystem(uint32_t worker_count = 0);
+
+    NO_COPY(JobSystem);
+
+    // Queues `job` on the calling thread's deque.
+    void run(JobCounter &counter, Job job);
+
+    // Runs queued jobs until every job started with `counter` has finished.
+    void wait(const JobCounter &counter);
+
+    // Calls `function` over [0, count) in ranges of at most `batch_size`
+    // items, splitting the range in halves so that idle workers steal large
+    // pieces first. Returns once every range is done.
+    void parallel_for(uint32_t count, uint32_t batch_size,
+                      const std::function<void(uint32_t begin, uint32_t end)>
+                          &function);
+
+    // Workers plus the thread that created the system.
+    inline uint32_t get_thread_count() const {
+        return static_cast<uint32_t>(queues.size());
+    }
+
+    ~JobSystem();
+
+  private:
+    struct QueuedJob {
+        Job job;
+        JobCounter *counter;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<QueuedJob> jobs;
+    };
+
+    void worker_main(uint32_t index);
+
+    // Pops from the thread's own deque, or steals from another. Returns
+    // whether a job ran.
+    bool run_one(uint32_t index);
+
+    auto get_queue_index() -> uint32_t;
+
+    void split(JobCounter &counter, uint32_t begin, uint32_t end,
+               uint32_t batch_size,
+               const std::function<void(uint32_t, uint32_t)> &function);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    // Sleeping workers wake up when a job is queued or on shutdown.
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<uint32_t> queued_jobs{0};
+    std::atomic<uint32_t> sleeping_workers{0};
+    std::atomic<bool> stopping{false};
+
+    // Threads without their own deque spread their jobs over the others.
+    std::atomic<uint32_t> next_external_queue{0};
+};
+
+// Measures the cost of starting and finishing jobs, alone and through
+// parallel_for at several batch sizes.
+void run_job_benchmark(JobSystem &jobs);
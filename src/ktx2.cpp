@@ -0,0 +1,121 @@
+#include "ktx2.hpp"
+
+namespace {
+constexpr std::array<uint8_t, 12> KTX2_IDENTIFIER{
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n',
+};
+
+struct Ktx2Header {
+    std::array<uint8_t, 12> identifier;
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+    uint64_t sgd_byte_offset;
+    uint64_t sgd_byte_length;
+};
+
+static_assert(sizeof(Ktx2Header) == 80);
+
+struct Ktx2LevelIndex {
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+
+[[noreturn]] void invalid(std::string_view p_path, std::string_view p_reason) {
+    fmt::println("[ERROR]: Invalid KTX2 file '{}': {}", p_path, p_reason);
+    throw Error::InvalidFileError;
+}
+} // namespace
+
+auto load_ktx2(std::string_view p_path) -> TextureData {
+    auto bytes = read_as_bytes(p_path);
+
+    Ktx2Header header;
+    if (bytes.size() < sizeof(header)) {
+        invalid(p_path, "truncated header");
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    if (header.identifier != KTX2_IDENTIFIER) {
+        invalid(p_path, "not a KTX2 file");
+    }
+
+    if (header.supercompression_scheme != 0) {
+        invalid(p_path, "supercompression is not supported");
+    }
+
+    if (header.pixel_width == 0 || header.pixel_height == 0 ||
+        header.pixel_depth > 1 || header.layer_count > 1 ||
+        header.face_count != 1) {
+        invalid(p_path, "only single 2D images are supported");
+    }
+
+    const auto format = static_cast<VkFormat>(header.vk_format);
+    const auto block = get_format_block(format);
+    if (!block.has_value()) {
+        fmt::println("[ERROR]: '{}' uses unsupported format {}.", p_path,
+                     header.vk_format);
+        throw Error::UnsupportedFormatError;
+    }
+
+    const VkExtent2D extent{
+        .width = header.pixel_width,
+        .height = header.pixel_height,
+    };
+
+    const auto level_count = std::max(header.level_count, 1u);
+    if (level_count > std::bit_width(std::max(extent.width, extent.height))) {
+        invalid(p_path, "more levels than the image has");
+    }
+
+    const auto level_index_end =
+        sizeof(header) + level_count * sizeof(Ktx2LevelIndex);
+    if (bytes.size() < level_index_end) {
+        invalid(p_path, "truncated level index");
+    }
+
+    std::vector<TextureLevel> levels;
+    levels.reserve(level_count);
+
+    for (uint32_t level = 0; level < level_count; level++) {
+        Ktx2LevelIndex index;
+        std::memcpy(&index,
+                    bytes.data() + sizeof(header) +
+                        level * sizeof(Ktx2LevelIndex),
+                    sizeof(index));
+
+        // Compared without adding, which could overflow.
+        if (index.byte_offset > bytes.size() ||
+            index.byte_length > bytes.size() - index.byte_offset) {
+            invalid(p_path, "level data past the end of the file");
+        }
+
+        if (index.byte_length != get_level_size(*block, extent, level)) {
+            invalid(p_path, "level size does not match its extent");
+        }
+
+        levels.push_back(TextureLevel{
+            .offset = index.byte_offset,
+            .size = index.byte_length,
+        });
+    }
+
+    return TextureData{
+        .format = format,
+        .extent = extent,
+        .bytes = std::move(bytes),
+        .levels = std::move(levels),
+        .generate_mips = header.level_count == 0,
+    };
+}
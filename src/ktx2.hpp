@@ -0,0 +1,8 @@
+#pragma once
+
+#include "textures.hpp"
+
+// Reads a KTX2 file holding a single 2D image. Supercompressed files, arrays,
+// cube maps and 3D images are rejected with Error::InvalidFileError. A level
+// count of zero asks for the mip chain to be generated.
+auto load_ktx2(std::string_view path) -> TextureData;
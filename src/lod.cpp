@@ -0,0 +1,188 @@
+#include "lod.hpp"
+
+namespace {
+// Cells along the longest axis of the mesh's bounds for the first simplified
+// level.
+constexpr uint32_t BASE_GRID_SIZE = 64;
+
+struct Clusters {
+    // Indexed by vertex.
+    std::vector<uint32_t> cluster_of;
+    // Indexed by cluster.
+    std::vector<uint32_t> representative;
+};
+
+auto cluster_vertices(std::span<const Vertex> p_vertices, glm::vec3 p_min,
+                      float p_cell_size, uint32_t p_grid_size) -> Clusters {
+    Clusters clusters;
+    clusters.cluster_of.resize(p_vertices.size());
+
+    std::unordered_map<uint64_t, uint32_t> cluster_of_cell;
+    std::vector<glm::vec3> centers;
+    std::vector<uint32_t> counts;
+
+    for (size_t i = 0; i < p_vertices.size(); i++) {
+        const auto cell = glm::min(
+            glm::uvec3{(p_vertices[i].position - p_min) / p_cell_size},
+            glm::uvec3{p_grid_size - 1});
+        const auto key =
+            cell.x + static_cast<uint64_t>(p_grid_size) *
+                         (cell.y + static_cast<uint64_t>(p_grid_size) * cell.z);
+
+        const auto [entry, inserted] = cluster_of_cell.try_emplace(
+            key, static_cast<uint32_t>(centers.size()));
+        if (inserted) {
+            centers.emplace_back(0.0f);
+            counts.push_back(0);
+        }
+
+        clusters.cluster_of[i] = entry->second;
+        centers[entry->second] += p_vertices[i].position;
+        counts[entry->second]++;
+    }
+
+    for (size_t i = 0; i < centers.size(); i++) {
+        centers[i] /= static_cast<float>(counts[i]);
+    }
+
+    clusters.representative.assign(centers.size(), 0);
+    std::vector<float> nearest(centers.size(),
+                               std::numeric_limits<float>::max());
+    for (size_t i = 0; i < p_vertices.size(); i++) {
+        const auto cluster = clusters.cluster_of[i];
+        const auto distance =
+            glm::length(p_vertices[i].position - centers[cluster]);
+        if (distance < nearest[cluster]) {
+            nearest[cluster] = distance;
+            clusters.representative[cluster] = static_cast<uint32_t>(i);
+        }
+    }
+
+    return clusters;
+}
+} // namespace
+
+auto build_lod_chain(std::span<const Vertex> p_vertices,
+                     std::span<const uint32_t> p_indices) -> LodMesh {
+    LodMesh mesh{};
+    mesh.indices.assign(p_indices.begin(), p_indices.end());
+    mesh.chain.level_count = 1;
+    mesh.chain.levels[0] = MeshLod{
+        .first_index = 0,
+        .index_count = static_cast<uint32_t>(p_indices.size()),
+        .error = 0.0f,
+        .padding = 0,
+    };
+
+    if (p_vertices.empty()) {
+        return mesh;
+    }
+
+    auto min = p_vertices[0].position;
+    auto max = p_vertices[0].position;
+    for (const auto &vertex : p_vertices) {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    const auto bounds = max - min;
+    const auto size = std::max(std::max(bounds.x, bounds.y), bounds.z);
+    if (size <= 0.0f) {
+        return mesh;
+    }
+
+    auto previous_count = p_indices.size();
+    float error = 0.0f;
+
+    for (auto grid_size = BASE_GRID_SIZE;
+         grid_size > 0 && mesh.chain.level_count < MAX_LOD_LEVELS;
+         grid_size /= 2) {
+        const auto clusters = cluster_vertices(
+            p_vertices, min, size / static_cast<float>(grid_size), grid_size);
+
+        std::vector<uint32_t> indices;
+        for (size_t i = 0; i + 2 < p_indices.size(); i += 3) {
+            const auto remap = [&](uint32_t p_index) {
+                return clusters
+                    .representative[clusters.cluster_of.at(p_index)];
+            };
+
+            const auto a = remap(p_indices[i]);
+            const auto b = remap(p_indices[i + 1]);
+            const auto c = remap(p_indices[i + 2]);
+
+            // Triangles whose corners merged have no area left.
+            if (a != b && b != c && a != c) {
+                indices.insert(indices.end(), {a, b, c});
+            }
+        }
+
+        if (indices.empty()) {
+            break;
+        }
+
+        if (indices.size() * 4 > previous_count * 3) {
+            continue;
+        }
+
+        for (size_t i = 0; i < p_vertices.size(); i++) {
+            const auto &representative =
+                p_vertices[clusters.representative[clusters.cluster_of[i]]];
+            error = std::max(error, glm::length(p_vertices[i].position -
+                                                representative.position));
+        }
+
+        mesh.chain.levels[mesh.chain.level_count++] = MeshLod{
+            .first_index = static_cast<uint32_t>(mesh.indices.size()),
+            .index_count = static_cast<uint32_t>(indices.size()),
+            .error = error,
+            .padding = 0,
+        };
+        mesh.indices.insert(mesh.indices.end(), indices.begin(),
+                            indices.end());
+        previous_count = indices.size();
+    }
+
+    return mesh;
+}
+
+auto make_sphere(float p_radius, uint32_t p_rings, uint32_t p_segments)
+    -> MeshData {
+    const auto rings = std::max(p_rings, 2u);
+    const auto segments = std::max(p_segments, 3u);
+
+    MeshData mesh;
+    mesh.vertices.reserve(static_cast<size_t>(rings + 1) * (segments + 1));
+    mesh.indices.reserve(static_cast<size_t>(rings) * segments * 6);
+
+    // The seam and the poles repeat vertices, which the LOD chain merges.
+    for (uint32_t ring = 0; ring <= rings; ring++) {
+        const auto theta = glm::pi<float>() * static_cast<float>(ring) /
+                           static_cast<float>(rings);
+
+        for (uint32_t segment = 0; segment <= segments; segment++) {
+            const auto phi = glm::two_pi<float>() *
+                             static_cast<float>(segment) /
+                             static_cast<float>(segments);
+
+            mesh.vertices.push_back(Vertex{
+                p_radius * glm::vec3{std::sin(theta) * std::cos(phi),
+                                     std::cos(theta),
+                                     std::sin(theta) * std::sin(phi)},
+            });
+        }
+    }
+
+    for (uint32_t ring = 0; ring < rings; ring++) {
+        for (uint32_t segment = 0; segment < segments; segment++) {
+            const auto first = ring * (segments + 1) + segment;
+            const auto second = first + segments + 1;
+
+            mesh.indices.insert(mesh.indices.end(),
+                                {first, second, first + 1, second, second + 1,
+                                 first + 1});
+        }
+    }
+
+    return mesh;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "graphics.hpp"
+
+constexpr uint32_t MAX_LOD_LEVELS = 8;
+
+// One level of detail of a mesh. Matches `Lod` in cull.comp.
+struct MeshLod {
+    // Relative to the first index of the mesh, so that the chain stays valid
+    // when the mesh moves within the geometry heap.
+    uint32_t first_index;
+    uint32_t index_count;
+    // How far, in object space, the level may deviate from the full mesh.
+    float error;
+    uint32_t padding;
+};
+
+// Levels of detail of a mesh from full detail down, with growing errors.
+// Matches `LodChain` in cull.comp.
+struct LodChain {
+    uint32_t level_count;
+    std::array<uint32_t, 3> padding;
+    std::array<MeshLod, MAX_LOD_LEVELS> levels;
+};
+
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+struct LodMesh {
+    // The full mesh's indices, followed by those of every simplified level.
+    // Uploaded as the mesh's indices, so that all levels live in the same
+    // buffer and share its vertices.
+    std::vector<uint32_t> indices;
+    LodChain chain;
+};
+
+// Simplifies a mesh by clustering its vertices on grids that get twice as
+// coarse every level, and replacing each cluster with the vertex nearest to
+// its center. Levels that remove less than a quarter of the previous level's
+// triangles are skipped. The error of a level is the farthest any vertex was
+// moved.
+auto build_lod_chain(std::span<const Vertex> vertices,
+                     std::span<const uint32_t> indices) -> LodMesh;
+
+// A UV sphere around the origin, tessellated finely enough that its LOD
+// chain matters.
+auto make_sphere(float radius, uint32_t rings, uint32_t segments) -> MeshData;
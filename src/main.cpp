@@ -3,15 +3,232 @@
 #include <vulkan/vulkan_core.h>
 
 #include "buffers.hpp"
+#include "capture.hpp"
+#include "command_cache.hpp"
+#include "command_encoder.hpp"
+#include "culling.hpp"
+#include "depth_pyramid.hpp"
+#include "draw_list.hpp"
 #include "devices.hpp"
+#include "geometry.hpp"
 #include "graphics.hpp"
+#include "images.hpp"
+#include "jobs.hpp"
+#include "ktx2.hpp"
+#include "lod.hpp"
+#include "options.hpp"
+#include "pacing.hpp"
 #include "present.hpp"
+#include "queries.hpp"
+#include "readback.hpp"
+#include "render_graph.hpp"
+#include "resolution.hpp"
+#include "startup.hpp"
 #include "sync.hpp"
+#include "textures.hpp"
+#include "trace.hpp"
+#include "triple_buffer.hpp"
 
 constexpr auto WINDOW_WIDTH = 1280;
 constexpr auto WINDOW_HEIGHT = 720;
 
-int main() try {
+constexpr uint32_t GEOMETRY_VERTEX_CAPACITY = 1 << 20;
+constexpr uint32_t GEOMETRY_INDEX_CAPACITY = 1 << 22;
+
+// Seconds between memory summaries. M dumps the full report at any time.
+constexpr double MEMORY_LOG_INTERVAL = 10.0;
+
+// Tessellation of the --lod sphere, about 16k triangles at full detail.
+constexpr uint32_t LOD_SPHERE_RINGS = 64;
+constexpr uint32_t LOD_SPHERE_SEGMENTS = 128;
+
+// Frames that can be waiting for the GPU or the readback consumer at once.
+constexpr uint32_t READBACK_SLOTS = 4;
+
+namespace {
+// What the simulation hands to the render thread for one frame.
+struct RenderSnapshot {
+    glm::mat4 view;
+    VkExtent2D framebuffer_extent;
+    double simulation_milliseconds;
+    // Connects the simulation of the snapshot to its frame in the trace.
+    uint64_t sequence;
+};
+
+auto get_framebuffer_extent(GLFWwindow *p_window) -> VkExtent2D {
+    int width, height;
+    glfwGetFramebufferSize(p_window, &width, &height);
+    return VkExtent2D{
+        .width = static_cast<uint32_t>(width),
+        .height = static_cast<uint32_t>(height),
+    };
+}
+
+struct WindowDeleter {
+    void operator()(GLFWwindow *p_window) const { glfwDestroyWindow(p_window); }
+};
+
+// A further window that shows the main window's frame scaled to its own size,
+// through its own surface and swapchain on the shared device. Mirrors can not
+// be resized.
+struct MirrorWindow {
+    std::unique_ptr<GLFWwindow, WindowDeleter> window;
+    VkExtent2D framebuffer_extent;
+    Surface surface;
+    Swapchain swapchain;
+    Semaphore image_acquired_semaphore;
+
+    // Whether an image was acquired for the current frame, and which one.
+    bool acquired;
+    uint32_t image_index;
+
+    MirrorWindow(const Device &p_device, GLFWwindow *p_window,
+                 const SwapchainSettings &p_settings)
+        : window(p_window),
+          framebuffer_extent(get_framebuffer_extent(p_window)),
+          surface(p_device, p_window), swapchain(p_device, surface, p_settings),
+          image_acquired_semaphore(p_device), acquired(false), image_index(0) {}
+
+    NO_COPY(MirrorWindow);
+};
+
+// Scales the main window's image into a mirror's. Both images are in the
+// present layout before and after, and the mirror's old contents are dropped.
+void record_mirror_blit(VkCommandBuffer p_command_buffer, VkImage p_source,
+                        VkExtent2D p_source_extent, VkImage p_target,
+                        VkExtent2D p_target_extent, VkFilter p_filter) {
+    constexpr VkImageSubresourceRange color_range{
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = 1,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    const auto barrier = [&](VkImage p_image, VkAccessFlags p_src_access,
+                             VkAccessFlags p_dst_access,
+                             VkImageLayout p_old_layout,
+                             VkImageLayout p_new_layout) {
+        return VkImageMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = p_src_access,
+            .dstAccessMask = p_dst_access,
+            .oldLayout = p_old_layout,
+            .newLayout = p_new_layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = p_image,
+            .subresourceRange = color_range,
+        };
+    };
+
+    const std::array to_transfer{
+        barrier(p_source, VK_ACCESS_MEMORY_WRITE_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+        barrier(p_target, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+    };
+    vkCmdPipelineBarrier(p_command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, static_cast<uint32_t>(to_transfer.size()),
+                         to_transfer.data());
+
+    const VkImageSubresourceLayers layers{
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .mipLevel = 0,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+    const VkImageBlit region{
+        .srcSubresource = layers,
+        .srcOffsets = {{0, 0, 0},
+                       {static_cast<int32_t>(p_source_extent.width),
+                        static_cast<int32_t>(p_source_extent.height), 1}},
+        .dstSubresource = layers,
+        .dstOffsets = {{0, 0, 0},
+                       {static_cast<int32_t>(p_target_extent.width),
+                        static_cast<int32_t>(p_target_extent.height), 1}},
+    };
+    vkCmdBlitImage(p_command_buffer, p_source,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, p_target,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, p_filter);
+
+    const std::array to_present{
+        barrier(p_source, VK_ACCESS_TRANSFER_READ_BIT, 0,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR),
+        barrier(p_target, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR),
+    };
+    vkCmdPipelineBarrier(p_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         0, nullptr, static_cast<uint32_t>(to_present.size()),
+                         to_present.data());
+}
+
+// One line per pass that did any vertex, fragment or compute work in the
+// frame the queries were last written in.
+void log_pass_statistics(const RenderGraph &p_graph,
+                         const PipelineStatisticsQueries &p_queries,
+                         VkExtent2D p_render_extent) {
+    const auto pixels =
+        std::max(p_render_extent.width * p_render_extent.height, 1u);
+
+    for (uint32_t i = 0; i < p_graph.get_pass_count(); i++) {
+        if (p_graph.is_pass_culled(i)) {
+            continue;
+        }
+
+        const auto statistics = p_queries.read(i);
+        if (statistics.input_vertices > 0) {
+            fmt::println("[INFO]: {}: {} vertices, {} vertex invocations, {} "
+                         "primitives clipped to {}, {} fragment invocations "
+                         "({:.2f} per pixel)",
+                         p_graph.get_pass_name(i), statistics.input_vertices,
+                         statistics.vertex_invocations,
+                         statistics.clipping_invocations,
+                         statistics.clipping_primitives,
+                         statistics.fragment_invocations,
+                         static_cast<double>(statistics.fragment_invocations) /
+                             pixels);
+        } else if (statistics.compute_invocations > 0) {
+            fmt::println("[INFO]: {}: {} compute invocations",
+                         p_graph.get_pass_name(i),
+                         statistics.compute_invocations);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char **argv) try {
+    // Everything up to the first present, including the work below that runs
+    // on jobs while the main thread brings up something else.
+    StartupTimeline startup;
+
+    const auto options = parse_options(argc, argv);
+
+    JobSystem jobs{options.job_workers};
+
+    if (options.job_benchmark) {
+        run_job_benchmark(jobs);
+        return 0;
+    }
+
+    // Reading and transcoding the texture only needs the file, so it overlaps
+    // the window and device setup.
+    std::optional<TextureData> texture_data;
+    std::optional<StartupTask> texture_task;
+    if (!options.texture.empty()) {
+        texture_task.emplace(jobs, startup, "Texture load", [&]() {
+            texture_data.emplace(load_ktx2(options.texture));
+        });
+    }
+
+    StartupTimeline::Phase window_phase{startup, "Window"};
     if (!glfwInit()) {
         fmt::println("Failed to initialize GLFW.");
         return EXIT_FAILURE;
@@ -23,6 +240,10 @@ int main() try {
 
     // glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    // A replay draws offscreen and never shows the window.
+    if (!options.replay.empty()) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
     const auto window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Jubes",
                                          nullptr, nullptr);
@@ -31,129 +252,983 @@ int main() try {
         fmt::println("Failed to create the GLFW window.");
         return EXIT_FAILURE;
     }
+    window_phase.end();
 
-    Device device{window, true};
+    StartupTimeline::Phase device_phase{startup, "Device"};
+    // Validation is never enabled in builds without JUBES_DEBUG_UTILS.
+    Device device{DEBUG_UTILS_ENABLED && options.validation, options.device};
     CommandPool command_pool{device};
-    Swapchain swapchain{device, window};
+    device_phase.end();
 
-    RenderPass render_pass{device, swapchain};
-    Framebuffers framebuffers{device, swapchain, render_pass};
-    GraphicsPipeline pipeline{
-        device, render_pass, "shaders/main.vert.spv", "shaders/main.frag.spv",
-        {},     {},
+    if (options.cull_benchmark || options.mesh_benchmark) {
+        if (options.cull_benchmark) {
+            run_culling_benchmark(device, command_pool);
+        }
+
+        if (options.mesh_benchmark) {
+            run_mesh_pool_benchmark(device, command_pool);
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    if (!options.replay.empty()) {
+        run_capture_replay(device, command_pool, read_capture(options.replay),
+                           options.replay_iterations);
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    // Only the depth pyramid uses the sampler cache during startup, so it
+    // does not need to be thread-safe.
+    SamplerCache sampler_cache{device};
+
+    // Creating the compute pipelines overlaps the swapchain setup.
+    std::optional<DepthPyramid> depth_pyramid_storage;
+    std::optional<CullingPass> culling_storage;
+    StartupTask culling_task{
+        jobs, startup, "Culling pipelines", [&]() {
+            depth_pyramid_storage.emplace(device, sampler_cache);
+            culling_storage.emplace(device, options.object_count);
+        }};
+
+    StartupTimeline::Phase swapchain_phase{startup, "Swapchain"};
+    const SwapchainSettings swapchain_settings{
+        .present_mode = options.present_mode,
+        .image_count = options.swapchain_images,
     };
+    Surface surface{device, window};
+    Swapchain swapchain{device, surface, swapchain_settings};
+    FramePacer pacer{device, options.frame_pacing};
+
+    // Mirrors copy from the main window's images, and every window presents
+    // in the same batch.
+    std::deque<MirrorWindow> mirrors;
+    if (options.windows > 1) {
+        const auto window_count =
+            std::min(options.windows, Device::MAX_BATCHED_PRESENTS);
+        if (window_count < options.windows) {
+            fmt::println("[WARNING]: Opening {} windows, the most that can "
+                         "present together.",
+                         window_count);
+        }
+
+        if ((swapchain.get_usage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0) {
+            fmt::println("[WARNING]: Swapchain images can not be copied from, "
+                         "so no further windows are opened.");
+        } else {
+            glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+            for (uint32_t i = 1; i < window_count; i++) {
+                const auto title = fmt::format("Jubes ({})", i + 1);
+                const auto mirror_window =
+                    glfwCreateWindow(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2,
+                                     title.c_str(), nullptr, nullptr);
+                if (mirror_window == nullptr) {
+                    fmt::println("[WARNING]: Failed to create window {}.",
+                                 i + 1);
+                    break;
+                }
+
+                mirrors.emplace_back(device, mirror_window, swapchain_settings);
+            }
+            glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+        }
+    }
+    swapchain_phase.end();
+
+    GeometryHeap geometry{device, GEOMETRY_VERTEX_CAPACITY,
+                          GEOMETRY_INDEX_CAPACITY};
+
+    culling_task.wait();
+    auto &depth_pyramid = *depth_pyramid_storage;
+    auto &culling = *culling_storage;
+    culling.set_occlusion_culling(options.occlusion_culling);
+
+    // The camera comes from the culling pass's uniform buffer, so only
+    // vertex pulling pushes anything.
+    const std::array pulling_push_constant_ranges{
+        VkPushConstantRange{
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .offset = 0,
+            .size = sizeof(GeometryHeap::PushConstants),
+        },
+    };
+
+    std::vector<VkDescriptorSetLayout> descriptor_set_layouts{
+        culling.get_descriptor_set_layout().get()};
+    if (options.vertex_pulling) {
+        const auto geometry_layouts = geometry.get_descriptor_set_layouts();
+        descriptor_set_layouts.insert(descriptor_set_layouts.end(),
+                                      geometry_layouts.begin(),
+                                      geometry_layouts.end());
+    }
+
+    RenderPass early_render_pass{device, swapchain, RenderPass::Type::Clear};
+    RenderPass late_render_pass{device, swapchain, RenderPass::Type::Load};
+    Framebuffers framebuffers{device};
+
+    // Also what a capture records of the pipeline.
+    const auto vertex_input = options.vertex_pulling
+                                  ? GraphicsPipeline::VertexInput::Pulled
+                                  : GraphicsPipeline::VertexInput::Attributes;
+    const std::string_view fragment_shader =
+        options.overdraw ? "overdraw.frag" : "main.frag";
+    const auto blend = options.overdraw ? GraphicsPipeline::Blend::Additive
+                                        : GraphicsPipeline::Blend::Opaque;
+
+    // Creating the main pipeline overlaps the scene uploads.
+    std::optional<GraphicsPipeline> pipeline_storage;
+    StartupTask pipeline_task{
+        jobs, startup, "Main pipeline", [&]() {
+            pipeline_storage.emplace(
+                device, early_render_pass,
+                options.vertex_pulling ? geometry.get_pulled_vertex_shader()
+                                       : "main.vert",
+                fragment_shader,
+                std::span{pulling_push_constant_ranges}.first(
+                    options.vertex_pulling ? 1 : 0),
+                descriptor_set_layouts, vertex_input, blend);
+            pipeline_storage->set_debug_name("Main");
+        }};
 
     Fence frame_fence{device, true};
     Semaphore image_acquired_semaphore{device};
     Semaphore rendering_done_semaphore{device};
 
-    std::array vertices = {
-        Vertex{{0.5, -0.5, 0.0}},
-        Vertex{{0.5, 0.5, 0.0}},
-        Vertex{{-0.5, 0.5, 0.0}},
-        Vertex{{-0.5, -0.5, 0.0}},
+    MeshData scene_mesh{
+        .vertices =
+            {
+                Vertex{{0.5, -0.5, 0.0}},
+                Vertex{{0.5, 0.5, 0.0}},
+                Vertex{{-0.5, 0.5, 0.0}},
+                Vertex{{-0.5, -0.5, 0.0}},
+            },
+        .indices = {0, 1, 2, 0, 2, 3},
     };
 
-    std::array<uint16_t, 6> indices{
-        0, 1, 2, 0, 2, 3,
-    };
+    // With --lod, a sphere detailed enough that drawing every copy at full
+    // detail would dominate the frame. Its simplified levels are uploaded
+    // along with it, after its own indices.
+    std::vector<LodChain> lod_chains;
+    if (options.lod) {
+        scene_mesh = make_sphere(0.5f, LOD_SPHERE_RINGS, LOD_SPHERE_SEGMENTS);
 
-    Buffer vertex_buffer{device, vertices.size() * sizeof(vertices[0]),
-                         Buffer::Type::Vertex};
-    vertex_buffer.load_using_staging(command_pool, vertices.data(),
-                                     vertices.size() * sizeof(vertices[0]));
+        auto lod_mesh =
+            build_lod_chain(scene_mesh.vertices, scene_mesh.indices);
+        scene_mesh.indices = std::move(lod_mesh.indices);
+        lod_chains.push_back(lod_mesh.chain);
 
-    Buffer index_buffer{device, indices.size() * sizeof(vertices[0]),
-                        Buffer::Type::Index};
-    index_buffer.load_using_staging(command_pool, indices.data(),
-                                    indices.size() * sizeof(indices[0]));
+        std::string levels;
+        for (uint32_t i = 0; i < lod_mesh.chain.level_count; i++) {
+            const auto &level = lod_mesh.chain.levels[i];
+            levels += fmt::format("{}{} ({:.4f})", i == 0 ? "" : ", ",
+                                  level.index_count / 3, level.error);
+        }
+        fmt::println("[INFO]: LOD chain triangles (error): {}", levels);
+    }
 
-    const auto command_buffer = command_pool.allocate_buffer();
+    StartupTimeline::Phase upload_phase{startup, "Scene upload"};
+    const auto scene_mesh_id = geometry.add_mesh(
+        command_pool, scene_mesh.vertices, scene_mesh.indices);
 
-    while (!glfwWindowShouldClose(window)) {
-        const VkFence frame_fence_raw = frame_fence.get();
-        vkWaitForFences(device.get(), 1, &frame_fence_raw, VK_TRUE, UINT64_MAX);
-        vkResetFences(device.get(), 1, &frame_fence_raw);
+    // Objects point at the full-detail level, and the culling pass picks
+    // another one from their chain.
+    auto object_mesh = geometry.get_mesh(scene_mesh_id);
+    if (!lod_chains.empty()) {
+        object_mesh.index_count = lod_chains[0].levels[0].index_count;
+    }
 
-        auto [image_index, should_recreate] =
-            swapchain.acquire_image(image_acquired_semaphore);
-        if (should_recreate) {
-            vkDeviceWaitIdle(device.get());
-            framebuffers.destroy();
-            swapchain.destroy();
-            swapchain.create(device, window);
-            framebuffers.create(device, swapchain, render_pass);
+    // Needs a render pass to record into, so it runs once the scene's own is
+    // created.
+    if (options.draw_benchmark) {
+        run_draw_list_benchmark(device, command_pool, early_render_pass,
+                                geometry, object_mesh);
 
-            continue;
-        }
+        // Mirrors own GLFW windows, which have to go before GLFW does.
+        mirrors.clear();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
 
-        vkResetCommandBuffer(command_buffer, 0);
+    const auto objects =
+        make_object_grid(options.object_count, object_mesh, &jobs,
+                         lod_chains.empty() ? 0 : 1);
+    culling.upload_objects(command_pool, objects);
+    culling.upload_lod_chains(command_pool, lod_chains);
 
-        const VkCommandBufferBeginInfo begin_info{
-            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .pInheritanceInfo = nullptr,
-        };
+    // Nothing in the scene is textured yet, so this only exercises the
+    // upload path.
+    std::optional<Texture> texture;
+    if (texture_task.has_value()) {
+        texture_task->wait();
+        texture.emplace(device, command_pool, *texture_data);
+        texture->set_debug_name(options.texture);
+
+        const auto &image = texture->get_image();
+        fmt::println("[INFO]: Loaded '{}': {}x{}, {} mip levels",
+                     options.texture, image.get_extent().width,
+                     image.get_extent().height, image.get_mip_levels());
+    }
+    upload_phase.end();
 
-        VK_ERROR(vkBeginCommandBuffer(command_buffer, &begin_info));
+    // Filled by the first frames with --capture, then written and dropped.
+    std::optional<Capture> capture;
+    if (!options.capture.empty()) {
+        capture.emplace(Capture{
+            .color_format = swapchain.get_format(),
+            .extent = swapchain.get_extent(),
+            .occlusion_culling = options.occlusion_culling,
+            .pipeline =
+                CapturedPipeline{
+                    .vertex_input = vertex_input,
+                    .fragment_shader = std::string{fragment_shader},
+                    .blend = blend,
+                },
+            .meshes = {CapturedMesh{
+                .placement = geometry.get_mesh(scene_mesh_id),
+                .vertices = scene_mesh.vertices,
+                .indices = scene_mesh.indices,
+            }},
+            .objects = objects,
+            .lod_chains = lod_chains,
+            .lod_threshold = options.lod_threshold,
+            .frames = {},
+        });
+    }
+
+    pipeline_task.wait();
+    auto &pipeline = *pipeline_storage;
+
+    // One command buffer per swapchain image. Unless they are cached, every
+    // frame records its image's command buffer again.
+    CommandCache command_cache{device, command_pool};
+    // Shadows what the frame has bound so far, so that the late phase only
+    // records what differs from the early one.
+    CommandEncoder encoder{VK_NULL_HANDLE};
+
+    // The start and end of every frame on the GPU, which the resolution
+    // scaler works from.
+    TimestampQueries frame_timestamps{device, 2};
+    bool frame_timestamps_written = false;
+
+    // One query per render graph pass, created once the graph is built.
+    std::optional<PipelineStatisticsQueries> pass_statistics;
+    bool pass_statistics_written = false;
+
+    // Copies of the presented frames, created once the swapchain exists.
+    // Declared after the file its consumer writes to, so that it stops first.
+    std::ofstream readback_hash_file;
+    std::optional<ReadbackRing> readback;
 
-        render_pass.begin(command_buffer, swapchain,
-                          framebuffers.get(image_index), {1.0, 0.5, 0.5, 1.0});
+    // Stays at full resolution without --dynamic-resolution.
+    ResolutionScaler resolution_scaler{ResolutionSettings{
+        .budget_milliseconds = options.frame_budget,
+        .min_scale = 0.5f,
+        .max_scale = 1.0f,
+    }};
+    VkFilter upscale_filter = VK_FILTER_LINEAR;
 
-        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          pipeline.get());
+    // Written every frame before the graph executes, and read by the passes.
+    // The scene is drawn to the top left `render_extent` of its images, which
+    // are as large as the swapchain's.
+    uint32_t image_index = 0;
+    VkExtent2D extent{};
+    VkExtent2D render_extent{};
+
+    const auto draw_phase = [&](const RenderPass &render_pass,
+                                CullingPass::Phase phase) {
+        // Overdraw adds up from black.
+        render_pass.begin(encoder.get(), framebuffers.get(0), render_extent,
+                          options.overdraw ? glm::vec4{0.0, 0.0, 0.0, 1.0}
+                                           : glm::vec4{1.0, 0.5, 0.5, 1.0});
+
+        encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.get());
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
         const VkViewport viewport{
             .x = 0,
             .y = 0,
-            .width = static_cast<float>(width),
-            .height = static_cast<float>(height),
+            .width = static_cast<float>(render_extent.width),
+            .height = static_cast<float>(render_extent.height),
             .minDepth = 0,
             .maxDepth = 1,
         };
-        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        encoder.set_viewport(viewport);
 
         const VkRect2D scissor{.offset =
                                    {
                                        .x = 0,
                                        .y = 0,
                                    },
-                               .extent = {
-                                   .width = static_cast<uint32_t>(width),
-                                   .height = static_cast<uint32_t>(height),
-                               }};
-        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
-
-        const std::array buffers{vertex_buffer.get()};
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers.data(), &offset);
-        vkCmdBindIndexBuffer(command_buffer, index_buffer.get(), offset, VK_INDEX_TYPE_UINT16);
-        vkCmdDrawIndexed(command_buffer, 6, 1, 0, 0, 0);
-
-        vkCmdEndRenderPass(command_buffer);
-
-        vkEndCommandBuffer(command_buffer);
-
-        device.submit_to_graphics(command_buffer, image_acquired_semaphore,
-                                  rendering_done_semaphore, frame_fence);
-        should_recreate =
-            device.present(swapchain, rendering_done_semaphore, image_index);
-        if (should_recreate) {
-            vkDeviceWaitIdle(device.get());
-            framebuffers.destroy();
-            swapchain.destroy();
-            swapchain.create(device, window);
-            framebuffers.create(device, swapchain, render_pass);
+                               .extent = render_extent};
+        encoder.set_scissor(scissor);
+
+        encoder.bind_descriptor_set(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                    pipeline.get_layout(), 0,
+                                    culling.get_descriptor_set());
+
+        // One bind of the geometry heap serves every mesh in the scene.
+        if (options.vertex_pulling) {
+            geometry.bind_pulled(encoder, pipeline.get_layout());
+        } else {
+            geometry.bind(encoder);
+        }
+
+        culling.draw(encoder, phase);
+
+        vkCmdEndRenderPass(encoder.get());
+    };
+
+    RenderGraph graph{device};
+    ResourceId swapchain_image = 0;
+
+    // Draw what was visible last frame, build the depth pyramid from it, then
+    // draw whatever turns out to be visible on top of that, and scale the
+    // result to the swapchain image. The imported resources start every
+    // frame the way the previous frame left them.
+    const auto build_graph = [&]() {
+        const auto scene_color = graph.create_image(
+            "Scene color",
+            TransientImageInfo{
+                .extent = swapchain.get_extent(),
+                .format = swapchain.get_format(),
+                .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                         VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+            });
+        const auto depth = graph.create_image(
+            "Depth", TransientImageInfo{
+                         .extent = swapchain.get_extent(),
+                         .format = DEPTH_FORMAT,
+                         .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                                  VK_IMAGE_USAGE_SAMPLED_BIT,
+                         .aspect = VK_IMAGE_ASPECT_DEPTH_BIT,
+                     });
+        swapchain_image = graph.import_image(
+            "Swapchain image", VK_NULL_HANDLE, VK_IMAGE_ASPECT_COLOR_BIT,
+            ResourceUsage::SwapchainAcquire);
+        const auto pyramid = graph.import_image(
+            "Depth pyramid", VK_NULL_HANDLE, VK_IMAGE_ASPECT_COLOR_BIT,
+            ResourceUsage::ComputeWrite);
+
+        const auto object_buffer =
+            graph.import_buffer("Objects", culling.get_object_buffer().get(),
+                                ResourceUsage::ComputeRead);
+        const auto visibility_buffer = graph.import_buffer(
+            "Visibility", culling.get_visibility_buffer().get(),
+            ResourceUsage::ComputeWrite);
+        const auto draw_command_buffer = graph.import_buffer(
+            "Draw commands", culling.get_draw_command_buffer().get(),
+            ResourceUsage::IndirectRead);
+        const auto counter_buffer = graph.import_buffer(
+            "Draw counts", culling.get_counter_buffer().get(),
+            ResourceUsage::TransferRead);
+        const auto statistics_buffer = graph.import_buffer(
+            "Cull statistics", culling.get_statistics_buffer().get(),
+            ResourceUsage::HostRead);
+
+        graph.add_pass(
+            "Reset cull counters",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(counter_buffer, ResourceUsage::TransferWrite);
+            },
+            [&](VkCommandBuffer p_command_buffer) {
+                culling.record_reset(p_command_buffer);
+            });
+
+        graph.add_pass(
+            "Cull (early)",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(object_buffer, ResourceUsage::ComputeRead);
+                pass.use(visibility_buffer, ResourceUsage::ComputeRead);
+                pass.use(draw_command_buffer, ResourceUsage::ComputeWrite);
+                pass.use(counter_buffer, ResourceUsage::ComputeWrite);
+            },
+            [&](VkCommandBuffer p_command_buffer) {
+                culling.record_dispatch(p_command_buffer,
+                                        CullingPass::Phase::Early);
+                encoder.invalidate(VK_PIPELINE_BIND_POINT_COMPUTE);
+            });
+
+        graph.add_pass(
+            "Draw (early)",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(draw_command_buffer, ResourceUsage::IndirectRead);
+                pass.use(counter_buffer, ResourceUsage::IndirectRead);
+                pass.use(object_buffer, ResourceUsage::VertexShaderRead);
+                pass.use(scene_color, ResourceUsage::ColorAttachmentClear);
+                pass.use(depth, ResourceUsage::DepthAttachmentClear);
+            },
+            [&](VkCommandBuffer) {
+                draw_phase(early_render_pass, CullingPass::Phase::Early);
+            });
+
+        graph.add_pass(
+            "Depth pyramid",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(depth, ResourceUsage::ComputeSampled);
+                pass.use(pyramid, ResourceUsage::ComputeWrite);
+            },
+            [&](VkCommandBuffer p_command_buffer) {
+                depth_pyramid.record(p_command_buffer);
+                encoder.invalidate(VK_PIPELINE_BIND_POINT_COMPUTE);
+            });
+
+        graph.add_pass(
+            "Cull (late)",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(pyramid, ResourceUsage::ComputeRead);
+                pass.use(object_buffer, ResourceUsage::ComputeRead);
+                pass.use(visibility_buffer, ResourceUsage::ComputeWrite);
+                pass.use(draw_command_buffer, ResourceUsage::ComputeWrite);
+                pass.use(counter_buffer, ResourceUsage::ComputeWrite);
+            },
+            [&](VkCommandBuffer p_command_buffer) {
+                culling.record_dispatch(p_command_buffer,
+                                        CullingPass::Phase::Late);
+                encoder.invalidate(VK_PIPELINE_BIND_POINT_COMPUTE);
+            });
+
+        graph.add_pass(
+            "Draw (late)",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(draw_command_buffer, ResourceUsage::IndirectRead);
+                pass.use(counter_buffer, ResourceUsage::IndirectRead);
+                pass.use(object_buffer, ResourceUsage::VertexShaderRead);
+                pass.use(scene_color, ResourceUsage::ColorAttachment);
+                pass.use(depth, ResourceUsage::DepthAttachment);
+            },
+            [&](VkCommandBuffer) {
+                draw_phase(late_render_pass, CullingPass::Phase::Late);
+            });
+
+        graph.add_pass(
+            "Upscale",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(scene_color, ResourceUsage::TransferRead);
+                pass.use(swapchain_image, ResourceUsage::TransferWrite);
+            },
+            [&, scene_color](VkCommandBuffer p_command_buffer) {
+                record_upscale(p_command_buffer,
+                               graph.get_image(scene_color).get(),
+                               render_extent,
+                               swapchain.get_images()[image_index], extent,
+                               upscale_filter);
+            });
+
+        graph.add_pass(
+            "Copy cull statistics",
+            [&](RenderGraph::PassBuilder &pass) {
+                pass.use(counter_buffer, ResourceUsage::TransferRead);
+                pass.use(statistics_buffer, ResourceUsage::TransferWrite);
+            },
+            [&](VkCommandBuffer p_command_buffer) {
+                culling.record_statistics_copy(p_command_buffer);
+            });
+
+        graph.set_output(swapchain_image, ResourceUsage::Present);
+        graph.set_output(statistics_buffer, ResourceUsage::HostRead);
+        graph.compile();
+
+        // The depth image only exists once the graph is compiled.
+        const auto &depth_image = graph.get_image(depth);
+        depth_pyramid.create(command_pool, depth_image);
+        culling.set_depth_pyramid(depth_pyramid);
+        graph.set_image(pyramid, depth_pyramid.get_image());
+        const std::array color_views{graph.get_image(scene_color).get_view()};
+        framebuffers.create(device, early_render_pass, color_views,
+                            depth_image.get_view(), swapchain.get_extent());
+
+        VkFormatProperties format_properties;
+        vkGetPhysicalDeviceFormatProperties(device.get_physical(),
+                                            swapchain.get_format(),
+                                            &format_properties);
+        const auto linear_filtering =
+            (format_properties.optimalTilingFeatures &
+             VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+        upscale_filter = linear_filtering ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+    };
+
+    StartupTimeline::Phase graph_phase{startup, "Render graph"};
+    build_graph();
+    command_cache.resize(static_cast<uint32_t>(swapchain.get_images().size()));
+    graph_phase.end();
+
+    // Rebuilding the graph keeps its passes, so the queries are only created
+    // once.
+    if (options.pipeline_statistics) {
+        if (device.get_capabilities().pipeline_statistics_query) {
+            pass_statistics.emplace(device, graph.get_pass_count());
+        } else {
+            fmt::println("[WARNING]: Pipeline statistics queries are not "
+                         "supported by the device.");
+        }
+    }
+
+    if (!options.readback_hashes.empty() || !options.readback_frames.empty()) {
+        if ((swapchain.get_usage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0) {
+            fmt::println("[WARNING]: Swapchain images can not be copied from, "
+                         "readback is disabled.");
+        } else {
+            if (!options.readback_hashes.empty()) {
+                readback_hash_file.open(options.readback_hashes);
+            }
+
+            readback.emplace(
+                device, READBACK_SLOTS,
+                [&, warned = false](const ReadbackImage &p_image) mutable {
+                    if (readback_hash_file.is_open()) {
+                        readback_hash_file << fmt::format(
+                            "{} {:016x}\n", p_image.frame,
+                            hash_pixels(p_image.pixels));
+                    }
+
+                    if (options.readback_frames.empty()) {
+                        return;
+                    }
+
+                    const auto path = fmt::format(
+                        "{}{:06}.ppm", options.readback_frames, p_image.frame);
+                    if (!write_ppm(path, p_image) && !warned) {
+                        fmt::println("[WARNING]: Could not write '{}'.", path);
+                        warned = true;
+                    }
+                });
         }
+    }
+
+    const auto recreate_swapchain = [&](VkExtent2D framebuffer_extent) {
+        vkDeviceWaitIdle(device.get());
+        framebuffers.destroy();
+        depth_pyramid.destroy();
+        graph.reset();
+        swapchain.destroy();
+
+        swapchain.create(device, framebuffer_extent);
+        build_graph();
+        command_cache.resize(
+            static_cast<uint32_t>(swapchain.get_images().size()));
+        pacer.reset();
+    };
+
+    TripleBuffer<RenderSnapshot> snapshots;
+
+    // Records, submits and presents the latest snapshot, while the main
+    // thread simulates the next one.
+    std::thread render_thread{[&]() {
+        TRACE_THREAD_NAME("Render");
+
+        try {
+            auto last_statistics_time = glfwGetTime();
+            double simulation_milliseconds = 0.0;
+            double render_milliseconds = 0.0;
+            double gpu_milliseconds = 0.0;
+            uint32_t gpu_frame_count = 0;
+            uint32_t frame_count = 0;
+            bool presented = false;
+
+            while (true) {
+                TRACE_SCOPE("Frame");
+
+                {
+                    TRACE_SCOPE("Wait for the frame fence");
+                    frame_fence.wait();
+                }
+
+                // Every copy recorded so far belongs to a finished frame.
+                if (readback.has_value()) {
+                    readback->collect();
+                }
+
+                // The fence also covers the previous frame's timestamps.
+                if (frame_timestamps_written) {
+                    const auto timestamps = frame_timestamps.read(0, 2);
+                    const auto milliseconds = frame_timestamps.to_milliseconds(
+                        timestamps[0], timestamps[1]);
+                    gpu_milliseconds += milliseconds;
+                    TRACE_COUNTER("GPU frame ms", milliseconds);
+                    gpu_frame_count++;
+                    frame_timestamps_written = false;
+
+                    // A new scale changes the recorded render area.
+                    if (options.dynamic_resolution &&
+                        resolution_scaler.update(milliseconds)) {
+                        command_cache.invalidate();
+                    }
+                }
+
+                // With pacing, the main thread only polls input and builds
+                // the snapshot once asked to after the pacing sleep, so that
+                // the frame renders input sampled as late as it allows.
+                pacer.begin_frame(swapchain);
+                if (options.frame_pacing) {
+                    snapshots.request();
+                }
+                if (!snapshots.take()) {
+                    break;
+                }
+
+                const auto &snapshot = snapshots.get_read_slot();
+                TRACE_FLOW_END("Snapshot", snapshot.sequence);
+                const auto render_start = std::chrono::steady_clock::now();
+
+                const auto acquired =
+                    swapchain.acquire_image(image_acquired_semaphore);
+                if (acquired.should_recreate) {
+                    recreate_swapchain(snapshot.framebuffer_extent);
+                    continue;
+                }
+
+                image_index = acquired.image_index;
+                frame_fence.reset();
+
+                // A mirror that has to be recreated sits this frame out.
+                for (auto &mirror : mirrors) {
+                    const auto mirror_acquired =
+                        mirror.swapchain.acquire_image(
+                            mirror.image_acquired_semaphore);
+                    mirror.acquired = !mirror_acquired.should_recreate;
+                    mirror.image_index = mirror_acquired.image_index;
+
+                    if (mirror_acquired.should_recreate) {
+                        vkDeviceWaitIdle(device.get());
+                        mirror.swapchain.destroy();
+                        mirror.swapchain.create(device,
+                                                mirror.framebuffer_extent);
+                    }
+                }
+
+                // The fence guarantees that the previous frame, including its
+                // copy of the culling counters, has finished.
+                if (glfwGetTime() - last_statistics_time >= 1.0) {
+                    const auto statistics = culling.read_statistics();
+                    fmt::println(
+                        "[INFO]: {} objects: {} early draws, {} late draws, "
+                        "{} frustum culled, {} occlusion culled, {} "
+                        "triangles",
+                        culling.get_object_count(), statistics.early_draws,
+                        statistics.late_draws, statistics.frustum_culled,
+                        statistics.occlusion_culled, statistics.triangles);
+
+                    const auto latency = pacer.take_latency_statistics();
+                    fmt::println(
+                        "[INFO]: Latency to {}: {:.2f} ms average, {:.2f} ms "
+                        "max over {} frames",
+                        latency.measured_to_present ? "present"
+                                                    : "GPU completion",
+                        latency.average_milliseconds, latency.max_milliseconds,
+                        latency.frame_count);
+
+                    const auto commands = encoder.take_statistics();
+                    fmt::println("[INFO]: Commands: {} issued, {} filtered as "
+                                 "redundant",
+                                 commands.get_issued(),
+                                 commands.get_filtered());
+
+                    if (pass_statistics_written) {
+                        log_pass_statistics(graph, *pass_statistics,
+                                            render_extent);
+                    }
+
+                    const auto cache = command_cache.take_statistics();
+                    fmt::println("[INFO]: Command buffers: {} recorded, {} "
+                                 "replayed",
+                                 cache.recorded, cache.replayed);
+
+                    if (readback.has_value()) {
+                        const auto copies = readback->take_statistics();
+                        fmt::println("[INFO]: Readback: {} copied, {} "
+                                     "consumed, {} dropped",
+                                     copies.recorded, copies.consumed,
+                                     copies.dropped);
+                    }
+
+                    if (gpu_frame_count > 0) {
+                        fmt::println("[INFO]: GPU {:.2f} ms, rendering at "
+                                     "{}x{} ({:.0f}%)",
+                                     gpu_milliseconds / gpu_frame_count,
+                                     render_extent.width, render_extent.height,
+                                     resolution_scaler.get_scale() * 100.0f);
+                    }
+
+                    const auto elapsed = glfwGetTime() - last_statistics_time;
+                    if (frame_count > 0) {
+                        fmt::println(
+                            "[INFO]: Simulation {:.2f} ms, render {:.2f} ms, "
+                            "frame {:.2f} ms",
+                            simulation_milliseconds / frame_count,
+                            render_milliseconds / frame_count,
+                            elapsed * 1000.0 / frame_count);
+                    }
+
+                    simulation_milliseconds = 0.0;
+                    render_milliseconds = 0.0;
+                    gpu_milliseconds = 0.0;
+                    gpu_frame_count = 0;
+                    frame_count = 0;
+                    last_statistics_time = glfwGetTime();
+                }
+
+                extent = swapchain.get_extent();
+                render_extent = resolution_scaler.get_render_extent(extent);
+                culling.set_viewport_scale(glm::vec2{
+                    static_cast<float>(render_extent.width) /
+                        static_cast<float>(std::max(extent.width, 1u)),
+                    static_cast<float>(render_extent.height) /
+                        static_cast<float>(std::max(extent.height, 1u)),
+                });
+                auto projection = glm::perspective(
+                    glm::radians(60.0f),
+                    static_cast<float>(extent.width) /
+                        static_cast<float>(std::max(extent.height, 1u)),
+                    0.1f, 1000.0f);
+                projection[1][1] *= -1.0f;
+
+                // Cached command buffers read the camera from here too, so
+                // moving it does not invalidate them.
+                const auto view_projection = projection * snapshot.view;
+                culling.set_lod_selection(LodSelection{
+                    .threshold_pixels = options.lod_threshold,
+                    .viewport_height = render_extent.height,
+                });
+                culling.update_camera(view_projection);
+
+                if (capture.has_value()) {
+                    capture->frames.push_back(CapturedFrame{
+                        .view_projection = view_projection,
+                        .render_extent = render_extent,
+                    });
+
+                    if (capture->frames.size() >= options.capture_frames) {
+                        write_capture(options.capture, *capture);
+                        capture.reset();
+                    }
+                }
+
+                // A readback copies into another slot every frame, and
+                // mirrors blit into whichever image they acquired.
+                if (!options.cache_commands || readback.has_value() ||
+                    !mirrors.empty()) {
+                    command_cache.invalidate();
+                }
+
+                const auto command_buffer = command_cache.get(
+                    image_index, [&](VkCommandBuffer p_command_buffer) {
+                        TRACE_SCOPE("Record");
+
+                        encoder.reset(p_command_buffer);
+                        graph.set_image(swapchain_image,
+                                        swapchain.get_images()[image_index]);
+
+                        frame_timestamps.reset(p_command_buffer);
+                        if (pass_statistics.has_value()) {
+                            pass_statistics->reset(p_command_buffer);
+                        }
+                        frame_timestamps.write(
+                            p_command_buffer, 0,
+                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+                        graph.execute(p_command_buffer,
+                                      pass_statistics.has_value()
+                                          ? &*pass_statistics
+                                          : nullptr);
+                        if (readback.has_value()) {
+                            readback->record_copy(
+                                p_command_buffer,
+                                swapchain.get_images()[image_index],
+                                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                swapchain.get_extent(), swapchain.get_format());
+                        }
+                        for (const auto &mirror : mirrors) {
+                            if (mirror.acquired) {
+                                record_mirror_blit(
+                                    p_command_buffer,
+                                    swapchain.get_images()[image_index],
+                                    swapchain.get_extent(),
+                                    mirror.swapchain
+                                        .get_images()[mirror.image_index],
+                                    mirror.swapchain.get_extent(),
+                                    upscale_filter);
+                            }
+                        }
+                        frame_timestamps.write(
+                            p_command_buffer, 1,
+                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+                    });
+
+                // Every window renders in the same submit and presents in
+                // the same batch, the main window first.
+                std::array<VkSemaphore, Device::MAX_BATCHED_PRESENTS>
+                    wait_semaphores;
+                std::array<SwapchainPresent, Device::MAX_BATCHED_PRESENTS>
+                    presents;
+                uint32_t present_count = 0;
+
+                wait_semaphores[0] = image_acquired_semaphore.get();
+                presents[present_count++] = SwapchainPresent{
+                    .swapchain = &swapchain,
+                    .image_index = image_index,
+                    .present_id = pacer.get_present_id(),
+                    .should_recreate = false,
+                };
+                for (const auto &mirror : mirrors) {
+                    if (mirror.acquired) {
+                        wait_semaphores[present_count] =
+                            mirror.image_acquired_semaphore.get();
+                        presents[present_count++] = SwapchainPresent{
+                            .swapchain = &mirror.swapchain,
+                            .image_index = mirror.image_index,
+                            .present_id = 0,
+                            .should_recreate = false,
+                        };
+                    }
+                }
+
+                device.submit_to_graphics(
+                    command_buffer,
+                    std::span{wait_semaphores}.first(present_count),
+                    rendering_done_semaphore, frame_fence);
+                frame_timestamps_written = true;
+                pass_statistics_written = pass_statistics.has_value();
+
+                device.present(std::span{presents}.first(present_count),
+                               rendering_done_semaphore);
+                const auto should_recreate = presents[0].should_recreate;
+                pacer.end_frame();
+
+                if (!presented) {
+                    startup.finish(options.startup_trace);
+                    presented = true;
+                }
+
+                simulation_milliseconds += snapshot.simulation_milliseconds;
+                render_milliseconds +=
+                    std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - render_start)
+                        .count();
+                frame_count++;
+
+                if (should_recreate) {
+                    recreate_swapchain(snapshot.framebuffer_extent);
+                }
+
+                // Presents came back in the order the mirrors were added.
+                uint32_t mirror_present = 1;
+                for (auto &mirror : mirrors) {
+                    if (mirror.acquired &&
+                        presents[mirror_present++].should_recreate) {
+                        vkDeviceWaitIdle(device.get());
+                        mirror.swapchain.destroy();
+                        mirror.swapchain.create(device,
+                                                mirror.framebuffer_extent);
+                    }
+                }
+            }
+        } catch (Error error) {
+            fmt::println("[ERROR]: Render thread: {}", error);
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+
+        // Unblocks the main thread if rendering stopped first.
+        snapshots.close();
+        vkDeviceWaitIdle(device.get());
+    }};
+
+    // Only changes when GLFW reports a resize, instead of being queried every
+    // frame.
+    VkExtent2D framebuffer_extent = get_framebuffer_extent(window);
+
+    glfwSetWindowUserPointer(window, &framebuffer_extent);
+    glfwSetFramebufferSizeCallback(
+        window, [](GLFWwindow *p_window, int p_width, int p_height) {
+            *static_cast<VkExtent2D *>(glfwGetWindowUserPointer(p_window)) =
+                VkExtent2D{
+                    .width = static_cast<uint32_t>(p_width),
+                    .height = static_cast<uint32_t>(p_height),
+                };
+        });
+
+    auto last_memory_log_time = glfwGetTime();
+    bool memory_key_was_down = false;
+    bool trace_key_was_down = false;
+    uint64_t snapshot_sequence = 0;
+
+    TRACE_THREAD_NAME("Main");
+
+    // Closing any window closes them all.
+    const auto should_close = [&]() {
+        return glfwWindowShouldClose(window) ||
+               std::any_of(mirrors.begin(), mirrors.end(),
+                           [](const MirrorWindow &p_mirror) {
+                               return glfwWindowShouldClose(
+                                   p_mirror.window.get());
+                           });
+    };
+
+    // Input and simulation. Each snapshot is built while the render thread
+    // works on the previous one or, with pacing, once the render thread asks
+    // for it.
+    while (!should_close()) {
+        if (options.frame_pacing && !snapshots.wait_until_requested()) {
+            break;
+        }
+
+        TRACE_SCOPE("Main loop");
 
         glfwPollEvents();
+
+        const auto memory_key_down =
+            glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+        if (memory_key_down && !memory_key_was_down) {
+            device.get_memory_tracker().log_report();
+        }
+        memory_key_was_down = memory_key_down;
+
+        const auto trace_key_down =
+            glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+        if (trace_key_down && !trace_key_was_down) {
+            write_trace(options.trace);
+        }
+        trace_key_was_down = trace_key_down;
+
+        if (glfwGetTime() - last_memory_log_time >= MEMORY_LOG_INTERVAL) {
+            device.get_memory_tracker().log_summary();
+            last_memory_log_time = glfwGetTime();
+        }
+
+        const auto simulation_start = std::chrono::steady_clock::now();
+
+        // Sweep the camera sideways across the grid so that objects keep
+        // entering and leaving the frustum.
+        const auto camera_x =
+            static_cast<float>(std::sin(glfwGetTime() * 0.25)) * 50.0f;
+
+        auto &snapshot = snapshots.get_write_slot();
+        snapshot.view = glm::lookAt(glm::vec3{camera_x, 0.0f, 5.0f},
+                                    glm::vec3{camera_x, 0.0f, 0.0f},
+                                    glm::vec3{0.0f, 1.0f, 0.0f});
+        snapshot.framebuffer_extent = framebuffer_extent;
+        snapshot.simulation_milliseconds =
+            std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - simulation_start)
+                .count();
+        snapshot.sequence = snapshot_sequence++;
+        TRACE_FLOW_BEGIN("Snapshot", snapshot.sequence);
+        snapshots.publish();
+
+        // Stay at most one frame ahead of the render thread.
+        if (!options.frame_pacing && !snapshots.wait_until_taken()) {
+            break;
+        }
     }
 
-    vkDeviceWaitIdle(device.get());
+    snapshots.close();
+    render_thread.join();
 
+    mirrors.clear();
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
@@ -0,0 +1,267 @@
+#include "memory_tracker.hpp"
+
+namespace {
+constexpr double MEBIBYTE = 1024.0 * 1024.0;
+
+// Fraction of a heap's budget above which a warning is logged.
+constexpr double BUDGET_WARNING_THRESHOLD = 0.9;
+
+double to_mebibytes(VkDeviceSize p_bytes) {
+    return static_cast<double>(p_bytes) / MEBIBYTE;
+}
+
+auto memory_property_names(VkMemoryPropertyFlags p_flags) -> std::string {
+    std::string names;
+
+    const auto append = [&](VkMemoryPropertyFlags flag, std::string_view name) {
+        if ((p_flags & flag) == 0) {
+            return;
+        }
+        if (!names.empty()) {
+            names += " | ";
+        }
+        names += name;
+    };
+
+    append(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "device local");
+    append(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, "host visible");
+    append(VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "host coherent");
+    append(VK_MEMORY_PROPERTY_HOST_CACHED_BIT, "host cached");
+    append(VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, "lazily allocated");
+
+    return names.empty() ? std::string{"none"} : names;
+}
+} // namespace
+
+auto memory_category_name(MemoryCategory p_category) -> std::string_view {
+    switch (p_category) {
+    case MemoryCategory::Geometry:
+        return "geometry";
+    case MemoryCategory::Staging:
+        return "staging";
+    case MemoryCategory::Uniform:
+        return "uniform";
+    case MemoryCategory::Storage:
+        return "storage";
+    case MemoryCategory::Readback:
+        return "readback";
+    case MemoryCategory::Texture:
+        return "texture";
+    case MemoryCategory::Attachment:
+        return "attachment";
+    case MemoryCategory::Transient:
+        return "transient";
+    }
+
+    return "unknown";
+}
+
+MemoryTracker::MemoryTracker(VkPhysicalDevice p_physical_device,
+                             const DeviceCapabilities &p_capabilities)
+    : physical_device(p_physical_device),
+      has_budget(p_capabilities.memory_budget &&
+                 p_capabilities.api_version >= VK_API_VERSION_1_1) {
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+    type_usage.resize(memory_properties.memoryTypeCount);
+    heap_warned.resize(memory_properties.memoryHeapCount);
+}
+
+auto MemoryTracker::allocate(VkDevice p_device,
+                             const VkMemoryAllocateInfo &p_allocate_info,
+                             MemoryCategory p_category) -> VkDeviceMemory {
+    VkDeviceMemory memory;
+    const auto result =
+        vkAllocateMemory(p_device, &p_allocate_info, nullptr, &memory);
+
+    if (result != VK_SUCCESS) {
+        fmt::println("[ERROR]: Failed to allocate {:.2f} MiB of {} memory: {}",
+                     to_mebibytes(p_allocate_info.allocationSize),
+                     memory_category_name(p_category), result);
+        log_report();
+        throw Error::VulkanError;
+    }
+
+    const std::lock_guard lock{mutex};
+
+    allocations.emplace(memory, Allocation{
+                                    .size = p_allocate_info.allocationSize,
+                                    .type_index =
+                                        p_allocate_info.memoryTypeIndex,
+                                    .category = p_category,
+                                });
+
+    auto &type = type_usage.at(p_allocate_info.memoryTypeIndex);
+    type.bytes += p_allocate_info.allocationSize;
+    type.allocation_count++;
+
+    auto &category = category_usage.at(static_cast<size_t>(p_category));
+    category.bytes += p_allocate_info.allocationSize;
+    category.allocation_count++;
+
+    return memory;
+}
+
+void MemoryTracker::free(VkDevice p_device, VkDeviceMemory p_memory) {
+    if (p_memory == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // The entry goes before the memory does. Once freed, the handle can be
+    // handed out again to an allocation on another thread, whose entry this
+    // would otherwise erase.
+    {
+        const std::lock_guard lock{mutex};
+
+        const auto allocation = allocations.find(p_memory);
+        if (allocation != allocations.end()) {
+            auto &type = type_usage.at(allocation->second.type_index);
+            type.bytes -= allocation->second.size;
+            type.allocation_count--;
+
+            auto &category = category_usage.at(
+                static_cast<size_t>(allocation->second.category));
+            category.bytes -= allocation->second.size;
+            category.allocation_count--;
+
+            allocations.erase(allocation);
+        }
+    }
+
+    vkFreeMemory(p_device, p_memory, nullptr);
+}
+
+auto MemoryTracker::get_report() const -> MemoryReport {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+        .pNext = nullptr,
+        .heapBudget = {},
+        .heapUsage = {},
+    };
+
+    if (has_budget) {
+        VkPhysicalDeviceMemoryProperties2 properties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+            .pNext = &budget_properties,
+            .memoryProperties = {},
+        };
+        vkGetPhysicalDeviceMemoryProperties2(physical_device, &properties);
+    }
+
+    MemoryReport report{
+        .has_budget = has_budget,
+        .heaps = {},
+        .types = {},
+        .categories = {},
+    };
+
+    const std::lock_guard lock{mutex};
+
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++) {
+        const auto &heap = memory_properties.memoryHeaps[i];
+        report.heaps.push_back(MemoryHeapReport{
+            .size = heap.size,
+            .device_local =
+                (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+            .budget = heap.size,
+            .usage = 0,
+            .allocated = {},
+        });
+    }
+
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+        const auto &type = memory_properties.memoryTypes[i];
+        report.types.push_back(MemoryTypeReport{
+            .heap_index = type.heapIndex,
+            .property_flags = type.propertyFlags,
+            .allocated = type_usage[i],
+        });
+
+        auto &heap = report.heaps.at(type.heapIndex).allocated;
+        heap.bytes += type_usage[i].bytes;
+        heap.allocation_count += type_usage[i].allocation_count;
+    }
+
+    for (uint32_t i = 0; i < report.heaps.size(); i++) {
+        auto &heap = report.heaps[i];
+        if (has_budget) {
+            heap.budget = budget_properties.heapBudget[i];
+            heap.usage = budget_properties.heapUsage[i];
+        } else {
+            heap.usage = heap.allocated.bytes;
+        }
+    }
+
+    report.categories = category_usage;
+    return report;
+}
+
+void MemoryTracker::log_summary() const {
+    const auto report = get_report();
+
+    for (uint32_t i = 0; i < report.heaps.size(); i++) {
+        const auto &heap = report.heaps[i];
+        if (heap.allocated.allocation_count == 0 && heap.usage == 0) {
+            continue;
+        }
+
+        const auto fraction =
+            heap.budget != 0 ? static_cast<double>(heap.usage) /
+                                   static_cast<double>(heap.budget)
+                             : 0.0;
+
+        fmt::println("[INFO]: Heap {} ({}): {:.1f} / {:.1f} MiB budget "
+                     "({:.0f}%), {:.1f} MiB in {} allocations by the engine",
+                     i, heap.device_local ? "device local" : "host",
+                     to_mebibytes(heap.usage), to_mebibytes(heap.budget),
+                     fraction * 100.0, to_mebibytes(heap.allocated.bytes),
+                     heap.allocated.allocation_count);
+
+        const auto over = fraction > BUDGET_WARNING_THRESHOLD;
+        bool was_over;
+        {
+            const std::lock_guard lock{mutex};
+            was_over = heap_warned[i];
+            heap_warned[i] = over;
+        }
+
+        if (over && !was_over) {
+            fmt::println("[WARNING]: Heap {} is at {:.0f}% of its budget, "
+                         "allocations may start to be evicted.",
+                         i, fraction * 100.0);
+        }
+    }
+}
+
+void MemoryTracker::log_report() const {
+    const auto report = get_report();
+
+    fmt::println("[INFO]: Memory report ({})",
+                 report.has_budget ? "budget from VK_EXT_memory_budget"
+                                   : "no budget, usage is engine allocations");
+    log_summary();
+
+    for (uint32_t i = 0; i < report.types.size(); i++) {
+        const auto &type = report.types[i];
+        if (type.allocated.allocation_count == 0) {
+            continue;
+        }
+
+        fmt::println("[INFO]:   Type {} (heap {}, {}): {:.2f} MiB in {} "
+                     "allocations",
+                     i, type.heap_index,
+                     memory_property_names(type.property_flags),
+                     to_mebibytes(type.allocated.bytes),
+                     type.allocated.allocation_count);
+    }
+
+    for (size_t i = 0; i < report.categories.size(); i++) {
+        const auto &category = report.categories[i];
+        if (category.allocation_count == 0) {
+            continue;
+        }
+
+        fmt::println("[INFO]:   {}: {:.2f} MiB in {} allocations",
+                     memory_category_name(static_cast<MemoryCategory>(i)),
+                     to_mebibytes(category.bytes), category.allocation_count);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "capabilities.hpp"
+
+enum class MemoryCategory {
+    // Vertex, index and geometry heap buffers.
+    Geometry,
+    Staging,
+    Uniform,
+    // Storage and indirect buffers.
+    Storage,
+    Readback,
+    // Sampled images.
+    Texture,
+    // Attachments and storage images that live across frames.
+    Attachment,
+    // Memory the render graph places its transient images in.
+    Transient,
+};
+
+constexpr size_t MEMORY_CATEGORY_COUNT = 8;
+
+auto memory_category_name(MemoryCategory category) -> std::string_view;
+
+struct MemoryUsage {
+    VkDeviceSize bytes;
+    uint32_t allocation_count;
+};
+
+struct MemoryHeapReport {
+    VkDeviceSize size;
+    bool device_local;
+    // What this process may use of the heap before the driver starts to
+    // evict, and what it uses. Without VK_EXT_memory_budget the budget is the
+    // heap size and the usage is what was allocated through the tracker.
+    VkDeviceSize budget;
+    VkDeviceSize usage;
+    // Allocated through the tracker.
+    MemoryUsage allocated;
+};
+
+struct MemoryTypeReport {
+    uint32_t heap_index;
+    VkMemoryPropertyFlags property_flags;
+    MemoryUsage allocated;
+};
+
+struct MemoryReport {
+    // Whether budget and usage come from VK_EXT_memory_budget.
+    bool has_budget;
+    std::vector<MemoryHeapReport> heaps;
+    std::vector<MemoryTypeReport> types;
+    std::array<MemoryUsage, MEMORY_CATEGORY_COUNT> categories;
+};
+
+// Accounts for every VkDeviceMemory the engine allocates, by heap, memory
+// type and category, and reads the live budget of each heap when the device
+// has VK_EXT_memory_budget. Safe to use from several threads.
+class MemoryTracker {
+  public:
+    MemoryTracker(VkPhysicalDevice physical_device,
+                  const DeviceCapabilities &capabilities);
+
+    NO_COPY(MemoryTracker);
+
+    // Allocates through vkAllocateMemory. On failure the full report is
+    // logged before throwing.
+    auto allocate(VkDevice device, const VkMemoryAllocateInfo &allocate_info,
+                  MemoryCategory category) -> VkDeviceMemory;
+
+    void free(VkDevice device, VkDeviceMemory memory);
+
+    auto get_report() const -> MemoryReport;
+
+    // One line per heap with budget, usage and what the engine allocated.
+    void log_summary() const;
+
+    // The summary followed by every memory type and category in use.
+    void log_report() const;
+
+  private:
+    struct Allocation {
+        VkDeviceSize size;
+        uint32_t type_index;
+        MemoryCategory category;
+    };
+
+    VkPhysicalDevice physical_device;
+    bool has_budget;
+    VkPhysicalDeviceMemoryProperties memory_properties;
+
+    mutable std::mutex mutex;
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+    std::vector<MemoryUsage> type_usage;
+    std::array<MemoryUsage, MEMORY_CATEGORY_COUNT> category_usage{};
+
+    // Heaps that were over 90% of their budget at the last summary, so that
+    // the warning is only printed when a heap crosses the line.
+    mutable std::vector<bool> heap_warned;
+};
@@ -0,0 +1,96 @@
+#include "offset_allocator.hpp"
+
+OffsetAllocator::OffsetAllocator(uint32_t p_capacity)
+    : capacity(p_capacity), used(0) {
+    reset();
+}
+
+auto OffsetAllocator::allocate(uint32_t p_size) -> std::optional<uint32_t> {
+    if (p_size == 0) {
+        return {};
+    }
+
+    const auto best_fit = free_ranges_by_size.lower_bound(p_size);
+    if (best_fit == free_ranges_by_size.end()) {
+        return {};
+    }
+
+    const auto offset = best_fit->second;
+    const auto range = free_ranges.find(offset);
+    const auto range_size = range->second;
+
+    remove_free_range(range);
+
+    if (range_size > p_size) {
+        add_free_range(offset + p_size, range_size - p_size);
+    }
+
+    allocations.emplace(offset, p_size);
+    used += p_size;
+
+    return offset;
+}
+
+void OffsetAllocator::free(uint32_t p_offset) {
+    const auto allocation = allocations.find(p_offset);
+    if (allocation == allocations.end()) {
+        fmt::println("[WARNING]: Freeing offset {}, which is not allocated.",
+                     p_offset);
+        return;
+    }
+
+    auto offset = p_offset;
+    auto size = allocation->second;
+
+    allocations.erase(allocation);
+    used -= size;
+
+    // Merge with the free range that starts where this one ends.
+    const auto next = free_ranges.find(offset + size);
+    if (next != free_ranges.end()) {
+        size += next->second;
+        remove_free_range(next);
+    }
+
+    // And with the one that ends where it starts.
+    const auto following = free_ranges.lower_bound(offset);
+    if (following != free_ranges.begin()) {
+        const auto previous = std::prev(following);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            remove_free_range(previous);
+        }
+    }
+
+    add_free_range(offset, size);
+}
+
+void OffsetAllocator::reset() {
+    free_ranges.clear();
+    free_ranges_by_size.clear();
+    allocations.clear();
+    used = 0;
+
+    if (capacity > 0) {
+        add_free_range(0, capacity);
+    }
+}
+
+void OffsetAllocator::add_free_range(uint32_t p_offset, uint32_t p_size) {
+    free_ranges.emplace(p_offset, p_size);
+    free_ranges_by_size.emplace(p_size, p_offset);
+}
+
+void OffsetAllocator::remove_free_range(
+    std::map<uint32_t, uint32_t>::iterator p_range) {
+    auto [first, last] = free_ranges_by_size.equal_range(p_range->second);
+    for (auto it = first; it != last; it++) {
+        if (it->second == p_range->first) {
+            free_ranges_by_size.erase(it);
+            break;
+        }
+    }
+
+    free_ranges.erase(p_range);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "common.hpp"
+
+// Hands out ranges of a fixed size space of offsets, for sub-allocating one
+// large buffer. Allocation is best fit and freed ranges are merged with free
+// neighbours, which keeps fragmentation down without moving anything; moving
+// is left to the owner of the memory (see GeometryHeap::compact).
+class OffsetAllocator {
+  public:
+    explicit OffsetAllocator(uint32_t capacity);
+
+    // Returns the offset of a range of `size` units, or nothing if there is
+    // no free range that large.
+    auto allocate(uint32_t size) -> std::optional<uint32_t>;
+
+    // Frees a range returned by `allocate`.
+    void free(uint32_t offset);
+
+    // Frees everything.
+    void reset();
+
+    inline uint32_t get_capacity() const { return capacity; }
+
+    inline uint32_t get_used() const { return used; }
+
+    inline uint32_t get_allocation_count() const {
+        return static_cast<uint32_t>(allocations.size());
+    }
+
+    inline uint32_t get_free_range_count() const {
+        return static_cast<uint32_t>(free_ranges.size());
+    }
+
+    inline uint32_t get_largest_free() const {
+        return free_ranges_by_size.empty()
+                   ? 0
+                   : free_ranges_by_size.rbegin()->first;
+    }
+
+  private:
+    void add_free_range(uint32_t offset, uint32_t size);
+    void remove_free_range(std::map<uint32_t, uint32_t>::iterator range);
+
+    uint32_t capacity;
+    uint32_t used;
+
+    // Offset to size, for merging with neighbours.
+    std::map<uint32_t, uint32_t> free_ranges;
+    // Size to offset, for best fit.
+    std::multimap<uint32_t, uint32_t> free_ranges_by_size;
+    // Offset to size of every live allocation.
+    std::unordered_map<uint32_t, uint32_t> allocations;
+};
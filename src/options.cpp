@@ -0,0 +1,112 @@
+#include "options.hpp"
+
+namespace {
+std::optional<VkPresentModeKHR> parse_present_mode(std::string_view p_name) {
+    if (p_name == "immediate") {
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    } else if (p_name == "mailbox") {
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    } else if (p_name == "fifo") {
+        return VK_PRESENT_MODE_FIFO_KHR;
+    } else if (p_name == "fifo-relaxed") {
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    }
+
+    fmt::println("[WARNING]: Unknown present mode '{}', expected immediate, "
+                 "mailbox, fifo or fifo-relaxed.",
+                 p_name);
+    return {};
+}
+} // namespace
+
+auto parse_options(int argc, char **argv) -> Options {
+    Options options{};
+
+    if (const auto device = std::getenv("JUBES_DEVICE"); device != nullptr) {
+        options.device = device;
+    }
+
+    if (const auto validation = std::getenv("JUBES_VALIDATION");
+        validation != nullptr) {
+        options.validation = std::string_view{validation} != "0";
+    }
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view argument{argv[i]};
+
+        if (argument == "--cull-benchmark") {
+            options.cull_benchmark = true;
+        } else if (argument == "--mesh-benchmark") {
+            options.mesh_benchmark = true;
+        } else if (argument == "--draw-benchmark") {
+            options.draw_benchmark = true;
+        } else if (argument == "--job-benchmark") {
+            options.job_benchmark = true;
+        } else if (argument == "--job-workers" && i + 1 < argc) {
+            options.job_workers =
+                static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--no-occlusion") {
+            options.occlusion_culling = false;
+        } else if (argument == "--vertex-pulling") {
+            options.vertex_pulling = true;
+        } else if (argument == "--frame-pacing") {
+            options.frame_pacing = true;
+        } else if (argument == "--dynamic-resolution") {
+            options.dynamic_resolution = true;
+        } else if (argument == "--frame-budget" && i + 1 < argc) {
+            options.frame_budget = std::strtod(argv[++i], nullptr);
+        } else if (argument == "--cache-commands") {
+            options.cache_commands = true;
+        } else if (argument == "--pipeline-statistics") {
+            options.pipeline_statistics = true;
+        } else if (argument == "--overdraw") {
+            options.overdraw = true;
+        } else if (argument == "--present-mode" && i + 1 < argc) {
+            options.present_mode = parse_present_mode(argv[++i]);
+        } else if (argument == "--swapchain-images" && i + 1 < argc) {
+            options.swapchain_images =
+                static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--windows" && i + 1 < argc) {
+            options.windows =
+                static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--validation") {
+            options.validation = true;
+        } else if (argument == "--no-validation") {
+            options.validation = false;
+        } else if (argument == "--device" && i + 1 < argc) {
+            options.device = argv[++i];
+        } else if (argument == "--texture" && i + 1 < argc) {
+            options.texture = argv[++i];
+        } else if (argument == "--startup-trace" && i + 1 < argc) {
+            options.startup_trace = argv[++i];
+        } else if (argument == "--capture" && i + 1 < argc) {
+            options.capture = argv[++i];
+        } else if (argument == "--capture-frames" && i + 1 < argc) {
+            options.capture_frames =
+                static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--replay" && i + 1 < argc) {
+            options.replay = argv[++i];
+        } else if (argument == "--replay-iterations" && i + 1 < argc) {
+            options.replay_iterations =
+                static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--readback-hashes" && i + 1 < argc) {
+            options.readback_hashes = argv[++i];
+        } else if (argument == "--readback-frames" && i + 1 < argc) {
+            options.readback_frames = argv[++i];
+        } else if (argument == "--trace" && i + 1 < argc) {
+            options.trace = argv[++i];
+        } else if (argument == "--lod") {
+            options.lod = true;
+        } else if (argument == "--lod-threshold" && i + 1 < argc) {
+            options.lod_threshold = std::strtof(argv[++i], nullptr);
+        } else if (argument == "--objects" && i + 1 < argc) {
+            options.object_count =
+                static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            fmt::println("[WARNING]: Ignoring unknown argument '{}'.",
+                         argument);
+        }
+    }
+
+    return options;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "common.hpp"
+
+struct Options {
+    // Number of objects placed in the scene.
+    uint32_t object_count = 4096;
+
+    // Draw a finely tessellated sphere with a LOD chain instead of the quad.
+    bool lod = false;
+    // Objects are drawn at the coarsest level whose simplification error
+    // stays within this many pixels. Zero always draws full detail.
+    float lod_threshold = 1.0f;
+
+    // Test objects against the depth pyramid in addition to the frustum.
+    bool occlusion_culling = true;
+
+    // Physical device to use, by index or part of its name. Defaults to the
+    // JUBES_DEVICE environment variable; empty picks the best scoring device.
+    std::string device;
+
+    // Enable the Khronos validation layer. Defaults to the JUBES_VALIDATION
+    // environment variable (0 disables it) and has no effect in builds
+    // without JUBES_DEBUG_UTILS.
+    bool validation = true;
+
+    // Fetch vertices from the geometry heap in the vertex shader instead of
+    // through fixed-function vertex input.
+    bool vertex_pulling = false;
+
+    // Present mode of the swapchain. Empty prefers mailbox, then fifo.
+    std::optional<VkPresentModeKHR> present_mode;
+
+    // Number of swapchain images. Zero picks one more than the minimum.
+    uint32_t swapchain_images = 0;
+
+    // Number of windows. Windows after the first mirror its frame through
+    // their own swapchains on the same device, and all of them present
+    // together.
+    uint32_t windows = 1;
+
+    // Delay the start of each frame so that it renders the newest possible
+    // simulation snapshot. Needs VK_KHR_present_wait.
+    bool frame_pacing = false;
+
+    // Scale the resolution the scene is rendered at so that the GPU time of a
+    // frame stays within `frame_budget` milliseconds. The result is upscaled
+    // to the swapchain.
+    bool dynamic_resolution = false;
+    double frame_budget = 16.0;
+
+    // Record a command buffer once per swapchain image and replay it until
+    // the swapchain is recreated, instead of recording every frame.
+    bool cache_commands = false;
+
+    // Measure the vertex, fragment and compute work of every render graph
+    // pass with pipeline statistics queries, and log it every second. Needs
+    // the pipelineStatisticsQuery feature.
+    bool pipeline_statistics = false;
+
+    // Draw the scene additively in a constant color instead, so that the
+    // brightness of a pixel shows how many fragments were shaded there.
+    bool overdraw = false;
+
+    // KTX2 texture to load at startup.
+    std::string texture;
+
+    // Where to write the startup timeline as a Chrome trace, up to the first
+    // present. The timeline is logged either way.
+    std::string startup_trace;
+
+    // Record the scene and the camera of the first `capture_frames` frames to
+    // this file.
+    std::string capture;
+    uint32_t capture_frames = 60;
+
+    // Replay a capture offscreen `replay_iterations` times and print its
+    // timings instead of opening the render loop. The window stays hidden.
+    std::string replay;
+    uint32_t replay_iterations = 10;
+
+    // Copy every presented frame back to the host without stalling the
+    // render loop, and append a hash of each to `readback_hashes` and/or
+    // write each to `readback_frames` followed by the frame number and .ppm.
+    // Frames are dropped when their consumer falls behind.
+    std::string readback_hashes;
+    std::string readback_frames;
+
+    // Where T writes the CPU trace in builds with JUBES_TRACING.
+    std::string trace = "trace.json";
+
+    // Run the GPU culling benchmark instead of opening the render loop.
+    bool cull_benchmark = false;
+
+    // Run the geometry heap benchmark instead of opening the render loop.
+    bool mesh_benchmark = false;
+
+    // Run the draw list benchmark instead of opening the render loop.
+    bool draw_benchmark = false;
+
+    // Run the job system benchmark instead of opening the render loop.
+    bool job_benchmark = false;
+
+    // Job worker threads. Zero starts one per hardware thread besides the
+    // main thread.
+    uint32_t job_workers = 0;
+};
+
+auto parse_options(int argc, char **argv) -> Options;
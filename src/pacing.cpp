@@ -0,0 +1,132 @@
+#include "pacing.hpp"
+#include "trace.hpp"
+
+namespace {
+// Weight of the newest sample in the moving averages.
+constexpr double SMOOTHING = 0.1;
+
+// Slack left between the predicted end of a frame and the refresh, to absorb
+// frames that run longer than average.
+constexpr double PACING_MARGIN = 0.001;
+
+// Presents that take longer than this (a minimized window, for instance) are
+// not waited on any further and do not count as refresh intervals.
+constexpr uint64_t PRESENT_WAIT_TIMEOUT = 100'000'000;
+
+double to_seconds(std::chrono::steady_clock::duration p_duration) {
+    return std::chrono::duration<double>(p_duration).count();
+}
+
+double smooth(double p_average, double p_sample) {
+    return p_average == 0.0 ? p_sample
+                            : p_average + (p_sample - p_average) * SMOOTHING;
+}
+} // namespace
+
+FramePacer::FramePacer(const Device &p_device, bool p_pacing)
+    : device(p_device), pacing(p_pacing), wait_for_present(nullptr),
+      present_id(0), refresh_interval(0.0), frame_time(0.0),
+      latency_frames(0), latency_sum(0.0), latency_max(0.0) {
+    if (p_device.get_capabilities().present_wait) {
+        wait_for_present = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+            vkGetDeviceProcAddr(p_device.get(), "vkWaitForPresentKHR"));
+    }
+
+    if (pacing && wait_for_present == nullptr) {
+        fmt::println("[WARNING]: Frame pacing needs VK_KHR_present_wait, "
+                     "which the device does not have. Only latency will be "
+                     "measured.");
+    }
+}
+
+void FramePacer::begin_frame(const Swapchain &p_swapchain) {
+    TRACE_SCOPE("FramePacer::begin_frame");
+
+    if (pending_frame.has_value()) {
+        // The fence has just signalled, so this is when the GPU finished.
+        const auto gpu_done = Clock::now();
+        frame_time =
+            smooth(frame_time, to_seconds(gpu_done - pending_frame->start));
+
+        // Waiting for the present blocks until the previous frame is on
+        // screen, which would cap unpaced mailbox and immediate modes at the
+        // refresh rate. Those measure up to the GPU finishing instead.
+        if (is_waiting_for_present()) {
+            const auto result = wait_for_present(
+                device.get(), p_swapchain.get(), pending_frame->present_id,
+                PRESENT_WAIT_TIMEOUT);
+            const auto presented = Clock::now();
+
+            if (result == VK_SUCCESS) {
+                record_latency(presented - pending_frame->start);
+
+                if (last_present.has_value()) {
+                    refresh_interval = smooth(
+                        refresh_interval, to_seconds(presented - *last_present));
+                }
+                last_present = presented;
+            } else {
+                last_present.reset();
+            }
+        } else {
+            record_latency(gpu_done - pending_frame->start);
+        }
+
+        pending_frame.reset();
+    }
+
+    if (pacing && last_present.has_value() && refresh_interval > 0.0) {
+        // Start just late enough for an average frame to finish right before
+        // the refresh after the one the previous frame was shown on.
+        const auto delay = refresh_interval - frame_time - PACING_MARGIN;
+        const auto target =
+            *last_present + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(delay));
+
+        if (delay > 0.0 && target > Clock::now()) {
+            std::this_thread::sleep_until(target);
+        }
+    }
+
+    frame_start = Clock::now();
+
+    if (device.get_capabilities().present_id) {
+        present_id++;
+    }
+}
+
+void FramePacer::end_frame() {
+    pending_frame = PendingFrame{
+        .present_id = present_id,
+        .start = frame_start,
+    };
+}
+
+void FramePacer::reset() {
+    pending_frame.reset();
+    last_present.reset();
+}
+
+auto FramePacer::take_latency_statistics() -> LatencyStatistics {
+    const LatencyStatistics statistics{
+        .frame_count = latency_frames,
+        .average_milliseconds =
+            latency_frames == 0 ? 0.0 : latency_sum / latency_frames * 1000.0,
+        .max_milliseconds = latency_max * 1000.0,
+        .measured_to_present = is_waiting_for_present(),
+    };
+
+    latency_frames = 0;
+    latency_sum = 0.0;
+    latency_max = 0.0;
+
+    return statistics;
+}
+
+void FramePacer::record_latency(Clock::duration p_latency) {
+    const auto seconds = to_seconds(p_latency);
+
+    latency_frames++;
+    latency_sum += seconds;
+    latency_max = std::max(latency_max, seconds);
+}
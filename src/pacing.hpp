@@ -0,0 +1,79 @@
+#pragma once
+
+#include "devices.hpp"
+#include "present.hpp"
+
+struct LatencyStatistics {
+    uint32_t frame_count;
+    double average_milliseconds;
+    double max_milliseconds;
+    // Whether latency was measured up to the image reaching the display
+    // (VK_KHR_present_wait) or only up to the GPU finishing the frame.
+    bool measured_to_present;
+};
+
+// Measures the time from the start of a frame's CPU work to its present and,
+// optionally, paces frames so that CPU work (and with it the choice of
+// simulation snapshot to render) starts as late as possible while still
+// making the next refresh.
+//
+// Pacing needs VK_KHR_present_wait: the previous frame is waited on until it
+// is displayed, and the CPU then sleeps for the part of the refresh interval
+// the frame is not expected to need. Without pacing, or without present wait,
+// frames are never held back beyond the frame fence and only latency up to
+// the end of the GPU's work is measured.
+class FramePacer {
+  public:
+    FramePacer(const Device &device, bool pacing);
+
+    NO_COPY(FramePacer);
+
+    // Call once the previous frame's fence has signalled, before taking the
+    // snapshot the new frame renders.
+    void begin_frame(const Swapchain &swapchain);
+
+    // Call after the frame has been presented with `get_present_id`.
+    void end_frame();
+
+    // Forgets presents made to the old swapchain. Call after recreating it.
+    void reset();
+
+    // The id to present the current frame with, or zero without
+    // VK_KHR_present_id.
+    inline uint64_t get_present_id() const { return present_id; }
+
+    // Returns latency since the previous call.
+    auto take_latency_statistics() -> LatencyStatistics;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingFrame {
+        uint64_t present_id;
+        Clock::time_point start;
+    };
+
+    void record_latency(Clock::duration latency);
+
+    inline bool is_waiting_for_present() const {
+        return pacing && wait_for_present != nullptr;
+    }
+
+    const Device &device;
+    bool pacing;
+
+    PFN_vkWaitForPresentKHR wait_for_present;
+
+    uint64_t present_id;
+    Clock::time_point frame_start;
+    std::optional<PendingFrame> pending_frame;
+    std::optional<Clock::time_point> last_present;
+
+    // Exponential moving averages, in seconds.
+    double refresh_interval;
+    double frame_time;
+
+    uint32_t latency_frames;
+    double latency_sum;
+    double latency_max;
+};
@@ -5,15 +5,33 @@
 #include <string>
 #include <string_view>
 #include <map>
+#include <unordered_map>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <cstdint>
+#include <cstring>
 #include <cmath>
+#include <cctype>
+#include <cstdlib>
 #include <tuple>
 #include <optional>
 #include <array>
 #include <algorithm>
+#include <numeric>
 #include <span>
+#include <type_traits>
+#include <bit>
 
 #include <vulkan/vulkan.h>
 
-#include <glm/glm.hpp>
\ No newline at end of file
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
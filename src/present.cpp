@@ -1,33 +1,81 @@
 #include "sync.hpp"
 
 #include "present.hpp"
+#include "trace.hpp"
+
+auto present_mode_name(VkPresentModeKHR p_mode) -> std::string_view {
+    switch (p_mode) {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR:
+        return "fifo";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        return "fifo-relaxed";
+    default:
+        return "other";
+    }
+}
+
+Surface::Surface(const Device &p_device, GLFWwindow *p_window)
+    : device(p_device), window(p_window) {
+    VK_ERROR(glfwCreateWindowSurface(device.get_instance(), window, nullptr,
+                                     &surface));
+
+    // The present family was only checked against the display, not against
+    // this window.
+    VkBool32 supports_presentation;
+    vkGetPhysicalDeviceSurfaceSupportKHR(device.get_physical(),
+                                         device.get_present_family(), surface,
+                                         &supports_presentation);
+    if (supports_presentation != VK_TRUE) {
+        vkDestroySurfaceKHR(device.get_instance(), surface, nullptr);
+        fmt::println("[ERROR]: The device can not present to the window.");
+        throw Error::VulkanError;
+    }
+}
+
+Surface::~Surface() {
+    vkDestroySurfaceKHR(device.get_instance(), surface, nullptr);
+}
+
+void Swapchain::create(const Device &p_device) {
+    int width, height;
+    glfwGetFramebufferSize(surface.get_window(), &width, &height);
+
+    create(p_device, VkExtent2D{
+                         .width = static_cast<uint32_t>(width),
+                         .height = static_cast<uint32_t>(height),
+                     });
+}
+
+void Swapchain::create(const Device &p_device,
+                       VkExtent2D p_framebuffer_extent) {
+    TRACE_SCOPE("Swapchain::create");
 
-void Swapchain::create(const Device &p_device, GLFWwindow *p_window) {
     VkSurfaceCapabilitiesKHR surface_capabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
-        p_device.get_physical(), p_device.get_surface(), &surface_capabilities);
+        p_device.get_physical(), surface.get(), &surface_capabilities);
 
     uint32_t format_count;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(p_device.get_physical(),
-                                         p_device.get_surface(), &format_count,
-                                         nullptr);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(p_device.get_physical(), surface.get(),
+                                         &format_count, nullptr);
 
     uint32_t present_mode_count;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(p_device.get_physical(),
-                                              p_device.get_surface(),
-                                              &present_mode_count, nullptr);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(
+        p_device.get_physical(), surface.get(), &present_mode_count, nullptr);
 
     // In the part in which we select a device, there should be at least one
     // format and one swapchain, so we should not need to worry about it.
 
     std::vector<VkSurfaceFormatKHR> formats(format_count);
-    vkGetPhysicalDeviceSurfaceFormatsKHR(p_device.get_physical(),
-                                         p_device.get_surface(), &format_count,
-                                         formats.data());
+    vkGetPhysicalDeviceSurfaceFormatsKHR(p_device.get_physical(), surface.get(),
+                                         &format_count, formats.data());
 
     std::vector<VkPresentModeKHR> present_modes(present_mode_count);
     vkGetPhysicalDeviceSurfacePresentModesKHR(
-        p_device.get_physical(), p_device.get_surface(), &present_mode_count,
+        p_device.get_physical(), surface.get(), &present_mode_count,
         present_modes.data());
 
     VkSurfaceFormatKHR surface_format = formats.at(0);
@@ -40,35 +88,58 @@ void Swapchain::create(const Device &p_device, GLFWwindow *p_window) {
         }
     }
 
-    VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+    const auto wanted_mode =
+        settings.present_mode.value_or(VK_PRESENT_MODE_MAILBOX_KHR);
+
+    present_mode = VK_PRESENT_MODE_FIFO_KHR;
     for (const auto mode : present_modes) {
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
+        if (mode == wanted_mode) {
             present_mode = mode;
         }
     }
 
+    if (settings.present_mode.has_value() && present_mode != wanted_mode) {
+        fmt::println("[WARNING]: The surface does not support the {} present "
+                     "mode, using fifo.",
+                     present_mode_name(wanted_mode));
+    }
+
     VkExtent2D swap_extent = surface_capabilities.currentExtent;
     if (swap_extent.width == std::numeric_limits<uint32_t>::max()) {
-        int width, height;
-        glfwGetFramebufferSize(p_window, &width, &height);
-
         swap_extent.width =
-            std::clamp(static_cast<uint32_t>(width),
+            std::clamp(p_framebuffer_extent.width,
                        surface_capabilities.minImageExtent.width,
                        surface_capabilities.maxImageExtent.width);
 
         swap_extent.height =
-            std::clamp(static_cast<uint32_t>(height),
+            std::clamp(p_framebuffer_extent.height,
                        surface_capabilities.minImageExtent.height,
                        surface_capabilities.maxImageExtent.height);
     }
 
-    uint32_t image_count = surface_capabilities.minImageCount + 1;
+    uint32_t image_count = settings.image_count != 0
+                               ? std::max(settings.image_count,
+                                          surface_capabilities.minImageCount)
+                               : surface_capabilities.minImageCount + 1;
     if (image_count > surface_capabilities.maxImageCount &&
         surface_capabilities.maxImageCount != 0) {
         image_count = surface_capabilities.maxImageCount;
     }
 
+    // The scene is drawn offscreen and then blitted into the image.
+    if ((surface_capabilities.supportedUsageFlags &
+         VK_IMAGE_USAGE_TRANSFER_DST_BIT) == 0) {
+        fmt::println("[ERROR]: The surface does not support transfers to "
+                     "swapchain images.");
+        throw Error::VulkanError;
+    }
+
+    // Reading images back is optional.
+    usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+            (surface_capabilities.supportedUsageFlags &
+             VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
     std::array queue_families{p_device.get_graphics_family(),
                               p_device.get_present_family()};
 
@@ -79,13 +150,13 @@ void Swapchain::create(const Device &p_device, GLFWwindow *p_window) {
         .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
         .pNext = nullptr,
         .flags = 0,
-        .surface = p_device.get_surface(),
+        .surface = surface.get(),
         .minImageCount = image_count,
         .imageFormat = surface_format.format,
         .imageColorSpace = surface_format.colorSpace,
         .imageExtent = swap_extent,
         .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageUsage = usage,
         .imageSharingMode = queue_families_same ? VK_SHARING_MODE_EXCLUSIVE
                                                 : VK_SHARING_MODE_CONCURRENT,
         .queueFamilyIndexCount =
@@ -157,6 +228,25 @@ void Swapchain::create(const Device &p_device, GLFWwindow *p_window) {
 
     image_format = surface_format.format;
     extent = swap_extent;
+
+    fmt::println("[INFO]: Created a {}x{} swapchain with {} images, present "
+                 "mode {}.",
+                 extent.width, extent.height, images.size(),
+                 present_mode_name(present_mode));
+
+    if constexpr (DEBUG_UTILS_ENABLED) {
+        set_debug_name(device, VK_OBJECT_TYPE_SWAPCHAIN_KHR,
+                       to_debug_handle(swapchain), "Swapchain");
+
+        for (size_t i = 0; i < images.size(); i++) {
+            set_debug_name(device, VK_OBJECT_TYPE_IMAGE,
+                           to_debug_handle(images[i]),
+                           fmt::format("Swapchain image {}", i));
+            set_debug_name(device, VK_OBJECT_TYPE_IMAGE_VIEW,
+                           to_debug_handle(image_views[i]),
+                           fmt::format("Swapchain image view {}", i));
+        }
+    }
 }
 
 void Swapchain::destroy() {
@@ -171,6 +261,8 @@ void Swapchain::destroy() {
 }
 
 Swapchain::AcquiredImage Swapchain::acquire_image(const Semaphore& signal_semaphore) {
+    TRACE_SCOPE("Swapchain::acquire_image");
+
     uint32_t image_index = 0;
     const auto result = vkAcquireNextImageKHR(device.get(), swapchain, UINT64_MAX,
                                         signal_semaphore.get(),
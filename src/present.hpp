@@ -5,13 +5,53 @@
 
 struct Semaphore;
 
+struct SwapchainSettings {
+    // Falls back to FIFO, which is always supported, when the surface does not
+    // support the requested mode. Empty prefers MAILBOX, then FIFO.
+    std::optional<VkPresentModeKHR> present_mode;
+
+    // Clamped to what the surface supports. Zero means one more than the
+    // surface's minimum.
+    uint32_t image_count = 0;
+};
+
+auto present_mode_name(VkPresentModeKHR mode) -> std::string_view;
+
+// The surface of one window. Any number of them can share a device, as long
+// as its present queue family can present to each.
+class Surface {
+  public:
+    Surface(const Device &device, GLFWwindow *window);
+
+    NO_COPY(Surface);
+
+    inline VkSurfaceKHR get() const { return surface; }
+
+    inline GLFWwindow *get_window() const { return window; }
+
+    ~Surface();
+
+  private:
+    const Device &device;
+    GLFWwindow *window;
+    VkSurfaceKHR surface;
+};
+
 class Swapchain {
   public:
-    inline Swapchain(const Device &device, GLFWwindow *window) : device(device) {
-        create(device, window);
+    inline Swapchain(const Device &device, const Surface &surface,
+                     const SwapchainSettings &settings = {})
+        : device(device), surface(surface), settings(settings) {
+        create(device);
     }
 
-    void create(const Device &device, GLFWwindow *window);
+    // Asks GLFW for the size of the surface's window, so it has to be called
+    // from the main thread.
+    void create(const Device &device);
+
+    // Uses `framebuffer_extent` when the surface leaves the extent to the
+    // swapchain. Unlike the overload above, may be called from any thread.
+    void create(const Device &device, VkExtent2D framebuffer_extent);
 
     void destroy();
 
@@ -31,22 +71,34 @@ class Swapchain {
 
     inline VkFormat get_format() const { return image_format; }
 
+    inline const std::vector<VkImage> &get_images() const { return images; }
+
     inline const std::vector<VkImageView> &get_image_views() const {
         return image_views;
     }
 
     inline const VkExtent2D &get_extent() const { return extent; }
 
+    inline VkPresentModeKHR get_present_mode() const { return present_mode; }
+
+    // Includes VK_IMAGE_USAGE_TRANSFER_SRC_BIT when the surface allows the
+    // images to be copied from.
+    inline VkImageUsageFlags get_usage() const { return usage; }
+
     inline ~Swapchain() {
         destroy();
     }
 
   private:
     const Device &device;
+    const Surface &surface;
+    SwapchainSettings settings;
 
     VkSwapchainKHR swapchain;
     VkFormat image_format;
     VkExtent2D extent;
+    VkPresentModeKHR present_mode;
+    VkImageUsageFlags usage;
 
     std::vector<VkImage> images;
     std::vector<VkImageView> image_views;
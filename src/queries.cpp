@@ -0,0 +1,88 @@
+#include "queries.hpp"
+
+TimestampQueries::TimestampQueries(const Device &p_device, uint32_t p_count)
+    : count(p_count), device(p_device) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.get_physical(), &properties);
+    timestamp_period = properties.limits.timestampPeriod;
+
+    const VkQueryPoolCreateInfo pool_info{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = count,
+        .pipelineStatistics = 0,
+    };
+
+    VK_ERROR(vkCreateQueryPool(device.get(), &pool_info, nullptr, &pool));
+}
+
+void TimestampQueries::reset(VkCommandBuffer p_command_buffer) const {
+    vkCmdResetQueryPool(p_command_buffer, pool, 0, count);
+}
+
+void TimestampQueries::write(VkCommandBuffer p_command_buffer, uint32_t p_query,
+                             VkPipelineStageFlagBits p_stage) const {
+    vkCmdWriteTimestamp(p_command_buffer, p_stage, pool, p_query);
+}
+
+auto TimestampQueries::read(uint32_t p_first, uint32_t p_count) const
+    -> std::vector<uint64_t> {
+    std::vector<uint64_t> timestamps(p_count);
+
+    VK_ERROR(vkGetQueryPoolResults(
+        device.get(), pool, p_first, p_count,
+        timestamps.size() * sizeof(uint64_t), timestamps.data(),
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+    return timestamps;
+}
+
+PipelineStatisticsQueries::PipelineStatisticsQueries(const Device &p_device,
+                                                     uint32_t p_count)
+    : count(p_count), device(p_device) {
+    // Results are written in the order of these bits, which is the order of
+    // PipelineStatistics.
+    const VkQueryPoolCreateInfo pool_info{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        .queryCount = count,
+        .pipelineStatistics =
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT,
+    };
+
+    VK_ERROR(vkCreateQueryPool(device.get(), &pool_info, nullptr, &pool));
+}
+
+void PipelineStatisticsQueries::reset(VkCommandBuffer p_command_buffer) const {
+    vkCmdResetQueryPool(p_command_buffer, pool, 0, count);
+}
+
+void PipelineStatisticsQueries::begin(VkCommandBuffer p_command_buffer,
+                                      uint32_t p_query) const {
+    vkCmdBeginQuery(p_command_buffer, pool, p_query, 0);
+}
+
+void PipelineStatisticsQueries::end(VkCommandBuffer p_command_buffer,
+                                    uint32_t p_query) const {
+    vkCmdEndQuery(p_command_buffer, pool, p_query);
+}
+
+auto PipelineStatisticsQueries::read(uint32_t p_query) const
+    -> PipelineStatistics {
+    PipelineStatistics statistics;
+
+    VK_ERROR(vkGetQueryPoolResults(
+        device.get(), pool, p_query, 1, sizeof(statistics), &statistics,
+        sizeof(statistics), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+    return statistics;
+}
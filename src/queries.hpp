@@ -0,0 +1,83 @@
+#pragma once
+
+#include "devices.hpp"
+
+class TimestampQueries {
+  public:
+    TimestampQueries(const Device &device, uint32_t count);
+
+    NO_COPY(TimestampQueries);
+
+    // Must be recorded outside of a render pass before any of the queries are
+    // written again.
+    void reset(VkCommandBuffer command_buffer) const;
+
+    void write(VkCommandBuffer command_buffer, uint32_t query,
+               VkPipelineStageFlagBits stage) const;
+
+    // Waits for the results of queries [first, first + count).
+    auto read(uint32_t first, uint32_t count) const -> std::vector<uint64_t>;
+
+    // Converts the difference between two timestamps into milliseconds.
+    inline double to_milliseconds(uint64_t begin, uint64_t end) const {
+        return static_cast<double>(end - begin) * timestamp_period / 1e6;
+    }
+
+    inline VkQueryPool get() const { return pool; }
+
+    inline ~TimestampQueries() {
+        vkDestroyQueryPool(device.get(), pool, nullptr);
+    }
+
+  private:
+    VkQueryPool pool;
+    uint32_t count;
+    double timestamp_period;
+
+    const Device &device;
+};
+
+// What the GPU did between the beginning and the end of a query, in the
+// order Vulkan writes the counters.
+struct PipelineStatistics {
+    uint64_t input_vertices;
+    uint64_t vertex_invocations;
+    // Primitives that reached clipping, and the ones that came out of it.
+    uint64_t clipping_invocations;
+    uint64_t clipping_primitives;
+    uint64_t fragment_invocations;
+    uint64_t compute_invocations;
+};
+
+// Needs the pipelineStatisticsQuery feature.
+class PipelineStatisticsQueries {
+  public:
+    PipelineStatisticsQueries(const Device &device, uint32_t count);
+
+    NO_COPY(PipelineStatisticsQueries);
+
+    // Must be recorded outside of a render pass before any of the queries
+    // begin again.
+    void reset(VkCommandBuffer command_buffer) const;
+
+    // A query that begins outside of a render pass also has to end outside
+    // of it.
+    void begin(VkCommandBuffer command_buffer, uint32_t query) const;
+    void end(VkCommandBuffer command_buffer, uint32_t query) const;
+
+    // Waits for the result of a query, which has to have been written since
+    // its last reset.
+    auto read(uint32_t query) const -> PipelineStatistics;
+
+    inline uint32_t get_count() const { return count; }
+
+    inline ~PipelineStatisticsQueries() {
+        vkDestroyQueryPool(device.get(), pool, nullptr);
+    }
+
+  private:
+    VkQueryPool pool;
+    uint32_t count;
+
+    const Device &device;
+};
@@ -0,0 +1,254 @@
+#include "readback.hpp"
+#include "trace.hpp"
+
+namespace {
+constexpr VkDeviceSize BYTES_PER_TEXEL = 4;
+
+constexpr VkImageSubresourceRange COLOR_RANGE{
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .baseMipLevel = 0,
+    .levelCount = 1,
+    .baseArrayLayer = 0,
+    .layerCount = 1,
+};
+} // namespace
+
+ReadbackRing::ReadbackRing(const Device &p_device, uint32_t p_slot_count,
+                           Consumer p_consumer)
+    : device(p_device), consumer(std::move(p_consumer)),
+      slots(std::max(p_slot_count, 1u)), next_slot(0), frame(0),
+      stopping(false), statistics{} {
+    for (auto &slot : slots) {
+        slot.data = nullptr;
+        slot.state = SlotState::Free;
+    }
+
+    worker = std::thread{[this]() { work(); }};
+}
+
+bool ReadbackRing::record_copy(VkCommandBuffer p_command_buffer,
+                               VkImage p_image, VkImageLayout p_layout,
+                               VkExtent2D p_extent, VkFormat p_format) {
+    auto &slot = slots[next_slot];
+    const auto copy_frame = frame++;
+
+    {
+        const std::lock_guard lock{mutex};
+        if (slot.state != SlotState::Free) {
+            statistics.dropped++;
+            return false;
+        }
+    }
+
+    // Nothing else touches a free slot, so it can grow without the lock.
+    const auto size = BYTES_PER_TEXEL * p_extent.width * p_extent.height;
+    if (slot.buffer == nullptr || slot.buffer->get_size() < size) {
+        if (slot.buffer != nullptr) {
+            vkUnmapMemory(device.get(), slot.buffer->get_memory());
+        }
+
+        slot.buffer =
+            std::make_unique<Buffer>(device, size, Buffer::Type::Readback);
+        slot.buffer->set_debug_name("Readback");
+        VK_ERROR(vkMapMemory(device.get(), slot.buffer->get_memory(), 0,
+                             VK_WHOLE_SIZE, 0, &slot.data));
+    }
+
+    const VkImageMemoryBarrier to_transfer{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .oldLayout = p_layout,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = p_image,
+        .subresourceRange = COLOR_RANGE,
+    };
+    vkCmdPipelineBarrier(p_command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &to_transfer);
+
+    const VkBufferImageCopy region{
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {p_extent.width, p_extent.height, 1},
+    };
+    vkCmdCopyImageToBuffer(p_command_buffer, p_image,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           slot.buffer->get(), 1, &region);
+
+    // The image goes back to where it was, and the copy is made visible to
+    // the host, which reads it once the frame's fence has signalled.
+    const VkImageMemoryBarrier to_original{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .dstAccessMask = 0,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .newLayout = p_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = p_image,
+        .subresourceRange = COLOR_RANGE,
+    };
+    const VkBufferMemoryBarrier to_host{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = slot.buffer->get(),
+        .offset = 0,
+        .size = size,
+    };
+    vkCmdPipelineBarrier(p_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT |
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0, 0, nullptr, 1, &to_host, 1, &to_original);
+
+    slot.frame = copy_frame;
+    slot.extent = p_extent;
+    slot.format = p_format;
+    next_slot = (next_slot + 1) % static_cast<uint32_t>(slots.size());
+
+    const std::lock_guard lock{mutex};
+    slot.state = SlotState::Recorded;
+    statistics.recorded++;
+    return true;
+}
+
+void ReadbackRing::collect() {
+    const std::lock_guard lock{mutex};
+
+    // Oldest first, which starts at the slot the next copy would use.
+    const auto count = static_cast<uint32_t>(slots.size());
+    for (uint32_t i = 0; i < count; i++) {
+        const auto index = (next_slot + i) % count;
+        if (slots[index].state == SlotState::Recorded) {
+            slots[index].state = SlotState::Consuming;
+            queue.push_back(index);
+        }
+    }
+
+    condition.notify_one();
+}
+
+auto ReadbackRing::take_statistics() -> ReadbackStatistics {
+    const std::lock_guard lock{mutex};
+    const auto taken = statistics;
+    statistics = {};
+    return taken;
+}
+
+ReadbackRing::~ReadbackRing() {
+    {
+        const std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    condition.notify_one();
+    worker.join();
+
+    for (const auto &slot : slots) {
+        if (slot.buffer != nullptr) {
+            vkUnmapMemory(device.get(), slot.buffer->get_memory());
+        }
+    }
+}
+
+void ReadbackRing::work() {
+    while (true) {
+        uint32_t index;
+        {
+            std::unique_lock lock{mutex};
+            condition.wait(lock,
+                           [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+
+            index = queue.front();
+            queue.pop_front();
+        }
+
+        // The slot is not touched by the render thread until it is free
+        // again.
+        const auto &slot = slots[index];
+        {
+            TRACE_SCOPE("Readback");
+            consumer(ReadbackImage{
+                .frame = slot.frame,
+                .extent = slot.extent,
+                .format = slot.format,
+                .pixels = std::span{static_cast<const std::byte *>(slot.data),
+                                    BYTES_PER_TEXEL * slot.extent.width *
+                                        slot.extent.height},
+            });
+        }
+
+        const std::lock_guard lock{mutex};
+        slots[index].state = SlotState::Free;
+        statistics.consumed++;
+    }
+}
+
+auto hash_pixels(std::span<const std::byte> p_pixels) -> uint64_t {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const auto byte : p_pixels) {
+        hash ^= static_cast<uint64_t>(byte);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+bool write_ppm(std::string_view p_path, const ReadbackImage &p_image) {
+    bool bgra;
+    switch (p_image.format) {
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        bgra = true;
+        break;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        bgra = false;
+        break;
+    default:
+        return false;
+    }
+
+    std::ofstream file{std::string{p_path}, std::ios::binary};
+    if (!file) {
+        return false;
+    }
+
+    file << fmt::format("P6\n{} {}\n255\n", p_image.extent.width,
+                        p_image.extent.height);
+
+    std::vector<char> row(3 * p_image.extent.width);
+    for (uint32_t y = 0; y < p_image.extent.height; y++) {
+        const auto texels =
+            p_image.pixels.subspan(BYTES_PER_TEXEL * p_image.extent.width * y);
+
+        for (uint32_t x = 0; x < p_image.extent.width; x++) {
+            const auto texel = texels.subspan(BYTES_PER_TEXEL * x);
+            row[3 * x + 0] = static_cast<char>(texel[bgra ? 2 : 0]);
+            row[3 * x + 1] = static_cast<char>(texel[1]);
+            row[3 * x + 2] = static_cast<char>(texel[bgra ? 0 : 2]);
+        }
+
+        file.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+
+    return static_cast<bool>(file);
+}
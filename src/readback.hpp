@@ -0,0 +1,92 @@
+#pragma once
+
+#include "buffers.hpp"
+
+// A copied image, as the consumer sees it. Rows are tightly packed.
+struct ReadbackImage {
+    // Counts every copy the ring was asked for, including dropped ones.
+    uint64_t frame;
+    VkExtent2D extent;
+    VkFormat format;
+    std::span<const std::byte> pixels;
+};
+
+struct ReadbackStatistics {
+    uint32_t recorded;
+    // Copies that were skipped because every slot was still waiting for the
+    // GPU or the consumer.
+    uint32_t dropped;
+    uint32_t consumed;
+};
+
+// Copies images into a ring of host-visible buffers and hands them to a
+// worker thread once the GPU is done with them, so that neither the render
+// loop nor the GPU ever waits for a readback. When the consumer falls
+// behind, new copies are dropped rather than stalling the frame.
+//
+// Only formats with 4 bytes per texel are supported.
+class ReadbackRing {
+  public:
+    using Consumer = std::function<void(const ReadbackImage &)>;
+
+    // `consumer` is called on the ring's worker thread, one image at a time.
+    ReadbackRing(const Device &device, uint32_t slot_count, Consumer consumer);
+
+    NO_COPY(ReadbackRing);
+
+    // Records a copy of the first mip level of `image`, which is in `layout`
+    // before and after the copy. Must be recorded outside of a render pass.
+    // Returns false when the copy was dropped.
+    bool record_copy(VkCommandBuffer command_buffer, VkImage image,
+                     VkImageLayout layout, VkExtent2D extent, VkFormat format);
+
+    // Hands every copy recorded so far to the worker. Only call once the GPU
+    // has finished all command buffers that recorded one, e.g. right after
+    // waiting for the frame fence.
+    void collect();
+
+    // Returns the counters accumulated since the last call and clears them.
+    auto take_statistics() -> ReadbackStatistics;
+
+    // Waits for the worker to consume what it was handed. Copies that were
+    // never collected are dropped, and the GPU must be done with them.
+    ~ReadbackRing();
+
+  private:
+    enum class SlotState { Free, Recorded, Consuming };
+
+    struct Slot {
+        // Created on first use and grown for larger images.
+        std::unique_ptr<Buffer> buffer;
+        void *data;
+        SlotState state;
+        uint64_t frame;
+        VkExtent2D extent;
+        VkFormat format;
+    };
+
+    void work();
+
+    const Device &device;
+    Consumer consumer;
+
+    std::vector<Slot> slots;
+    uint32_t next_slot;
+    uint64_t frame;
+
+    // Guards the slot states, the queue and the statistics.
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<uint32_t> queue;
+    bool stopping;
+    ReadbackStatistics statistics;
+
+    std::thread worker;
+};
+
+// FNV-1a, to compare frames across runs without storing them.
+auto hash_pixels(std::span<const std::byte> pixels) -> uint64_t;
+
+// Writes a binary PPM without alpha. Returns false for formats other than
+// 8-bit RGBA and BGRA, or when the file can not be written.
+bool write_ppm(std::string_view path, const ReadbackImage &image);
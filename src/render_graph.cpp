@@ -0,0 +1,740 @@
+#include "render_graph.hpp"
+#include "trace.hpp"
+
+namespace {
+struct UsageInfo {
+    VkPipelineStageFlags2 stages;
+    VkAccessFlags2 access;
+    VkImageLayout layout;
+    // Whether the previous contents of the resource can be thrown away.
+    bool discards;
+};
+
+constexpr VkAccessFlags2 WRITE_ACCESS =
+    VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT |
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+constexpr VkPipelineStageFlags2 FRAGMENT_TESTS =
+    VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+    VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+// Only stages and accesses that also exist in the original flags are used, so
+// that the barriers can be recorded without synchronization2.
+UsageInfo usage_info(ResourceUsage p_usage) {
+    switch (p_usage) {
+    case ResourceUsage::None:
+        return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case ResourceUsage::SwapchainAcquire:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case ResourceUsage::IndirectRead:
+        return {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case ResourceUsage::VertexShaderRead:
+        return {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+                VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case ResourceUsage::ComputeRead:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+    case ResourceUsage::ComputeWrite:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, false};
+    case ResourceUsage::ComputeSampled:
+        return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+    case ResourceUsage::TransferRead:
+        return {VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false};
+    case ResourceUsage::TransferWrite:
+        return {VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false};
+    case ResourceUsage::ColorAttachment:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, false};
+    case ResourceUsage::ColorAttachmentClear:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+    case ResourceUsage::DepthAttachment:
+        return {FRAGMENT_TESTS,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, false};
+    case ResourceUsage::DepthAttachmentClear:
+        return {FRAGMENT_TESTS, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true};
+    case ResourceUsage::Present:
+        return {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false};
+    case ResourceUsage::HostRead:
+        return {VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, false};
+    }
+
+    return {};
+}
+
+bool is_write(ResourceUsage p_usage) {
+    return (usage_info(p_usage).access & WRITE_ACCESS) != 0;
+}
+
+// What is known about a resource at some point of the frame.
+struct TrackedState {
+    // Stages of the last write (or layout transition) and its accesses that
+    // still have to be made available.
+    VkPipelineStageFlags2 write_stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 write_access = VK_ACCESS_2_NONE;
+    // Stages that read the resource since the last write.
+    VkPipelineStageFlags2 read_stages = VK_PIPELINE_STAGE_2_NONE;
+    // What the last write has already been made visible to.
+    VkPipelineStageFlags2 visible_stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 visible_access = VK_ACCESS_2_NONE;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+TrackedState initial_state(ResourceUsage p_usage) {
+    const auto info = usage_info(p_usage);
+    const auto writes = (info.access & WRITE_ACCESS) != 0;
+
+    return TrackedState{
+        .write_stages = writes ? info.stages : VK_PIPELINE_STAGE_2_NONE,
+        .write_access = info.access & WRITE_ACCESS,
+        .read_stages = writes ? VK_PIPELINE_STAGE_2_NONE : info.stages,
+        .visible_stages = VK_PIPELINE_STAGE_2_NONE,
+        .visible_access = VK_ACCESS_2_NONE,
+        .layout = info.layout,
+    };
+}
+
+struct Transition {
+    VkPipelineStageFlags2 src_stages;
+    VkAccessFlags2 src_access;
+    VkPipelineStageFlags2 dst_stages;
+    VkAccessFlags2 dst_access;
+    VkImageLayout old_layout;
+    VkImageLayout new_layout;
+};
+
+// Moves the state on to the usage and returns the barrier that has to come
+// before it, if any.
+std::optional<Transition> advance(TrackedState &p_state, ResourceUsage p_usage,
+                                  bool p_is_image) {
+    const auto info = usage_info(p_usage);
+    const auto changes_layout = p_is_image && info.layout != p_state.layout;
+    const auto writes = (info.access & WRITE_ACCESS) != 0;
+
+    std::optional<Transition> transition;
+
+    if (writes || changes_layout) {
+        // Write-after-write and write-after-read hazards, and transitions.
+        const auto src_stages = p_state.write_stages | p_state.read_stages;
+
+        if (src_stages != VK_PIPELINE_STAGE_2_NONE || changes_layout) {
+            transition = Transition{
+                .src_stages = src_stages,
+                .src_access = p_state.write_access,
+                .dst_stages = info.stages,
+                .dst_access = info.access,
+                .old_layout = info.discards ? VK_IMAGE_LAYOUT_UNDEFINED
+                                            : p_state.layout,
+                .new_layout = info.layout,
+            };
+        }
+
+        p_state.write_stages = info.stages;
+        p_state.write_access = info.access & WRITE_ACCESS;
+        p_state.layout = info.layout;
+
+        if (writes) {
+            p_state.read_stages = VK_PIPELINE_STAGE_2_NONE;
+            p_state.visible_stages = VK_PIPELINE_STAGE_2_NONE;
+            p_state.visible_access = VK_ACCESS_2_NONE;
+        } else {
+            // A transition for a read: the reader already sees it.
+            p_state.read_stages = info.stages;
+            p_state.visible_stages = info.stages;
+            p_state.visible_access = info.access;
+        }
+
+        return transition;
+    }
+
+    // Read-after-write hazards. Reads after reads need nothing.
+    const auto is_visible =
+        (info.stages & ~p_state.visible_stages) == 0 &&
+        (info.access & ~p_state.visible_access) == 0;
+
+    if (p_state.write_stages != VK_PIPELINE_STAGE_2_NONE && !is_visible) {
+        transition = Transition{
+            .src_stages = p_state.write_stages,
+            .src_access = p_state.write_access,
+            .dst_stages = info.stages,
+            .dst_access = info.access,
+            .old_layout = p_state.layout,
+            .new_layout = p_state.layout,
+        };
+
+        p_state.visible_stages |= info.stages;
+        p_state.visible_access |= info.access;
+    }
+
+    p_state.read_stages |= info.stages;
+
+    return transition;
+}
+
+bool overlaps(std::pair<uint32_t, uint32_t> p_a,
+              std::pair<uint32_t, uint32_t> p_b) {
+    return p_a.first <= p_b.second && p_b.first <= p_a.second;
+}
+} // namespace
+
+void RenderGraph::PassBuilder::use(ResourceId p_resource,
+                                   ResourceUsage p_usage) {
+    graph.passes.at(pass).uses.push_back(Use{
+        .resource = p_resource,
+        .usage = p_usage,
+    });
+}
+
+void RenderGraph::PassBuilder::set_side_effects() {
+    graph.passes.at(pass).side_effects = true;
+}
+
+RenderGraph::RenderGraph(const Device &p_device)
+    : device(p_device), statistics{} {}
+
+auto RenderGraph::import_buffer(std::string_view p_name, VkBuffer p_buffer,
+                                ResourceUsage p_initial) -> ResourceId {
+    resources.push_back(Resource{
+        .name = std::string{p_name},
+        .is_image = false,
+        .buffer = p_buffer,
+        .image = VK_NULL_HANDLE,
+        .aspect = 0,
+        .initial = p_initial,
+        .final_usage = {},
+        .transient = {},
+    });
+
+    return static_cast<ResourceId>(resources.size() - 1);
+}
+
+auto RenderGraph::import_image(std::string_view p_name, VkImage p_image,
+                               VkImageAspectFlags p_aspect,
+                               ResourceUsage p_initial) -> ResourceId {
+    resources.push_back(Resource{
+        .name = std::string{p_name},
+        .is_image = true,
+        .buffer = VK_NULL_HANDLE,
+        .image = p_image,
+        .aspect = p_aspect,
+        .initial = p_initial,
+        .final_usage = {},
+        .transient = {},
+    });
+
+    return static_cast<ResourceId>(resources.size() - 1);
+}
+
+auto RenderGraph::create_image(std::string_view p_name,
+                               const TransientImageInfo &p_info)
+    -> ResourceId {
+    resources.push_back(Resource{
+        .name = std::string{p_name},
+        .is_image = true,
+        .buffer = VK_NULL_HANDLE,
+        .image = VK_NULL_HANDLE,
+        .aspect = p_info.aspect,
+        .initial = ResourceUsage::None,
+        .final_usage = {},
+        .transient = p_info,
+    });
+
+    return static_cast<ResourceId>(resources.size() - 1);
+}
+
+void RenderGraph::add_pass(std::string_view p_name, const Setup &p_setup,
+                           Execute p_execute) {
+    passes.push_back(Pass{
+        .name = std::string{p_name},
+        .uses = {},
+        .side_effects = false,
+        .execute = std::move(p_execute),
+        .culled = false,
+        .barriers = {},
+    });
+
+    PassBuilder builder{*this, static_cast<uint32_t>(passes.size() - 1)};
+    p_setup(builder);
+}
+
+void RenderGraph::set_output(ResourceId p_resource,
+                             ResourceUsage p_final_usage) {
+    resources.at(p_resource).final_usage = p_final_usage;
+}
+
+void RenderGraph::compile() {
+    cull_passes();
+    allocate_transients();
+    plan_barriers();
+
+    fmt::println("[INFO]: Render graph: {} of {} passes culled, {} barriers "
+                 "({} image barriers) per frame, {} transient images in {} "
+                 "allocations ({} KiB, {} KiB without aliasing).",
+                 statistics.culled_pass_count, statistics.pass_count,
+                 statistics.barrier_count, statistics.image_barrier_count,
+                 statistics.transient_image_count,
+                 statistics.transient_allocation_count,
+                 statistics.aliased_transient_bytes / 1024,
+                 statistics.transient_bytes / 1024);
+}
+
+void RenderGraph::cull_passes() {
+    // Walks the passes backwards, keeping those that write something a later
+    // kept pass or the end of the frame needs.
+    std::vector<bool> needed(resources.size(), false);
+    for (ResourceId id = 0; id < resources.size(); id++) {
+        needed.at(id) = resources.at(id).final_usage.has_value();
+    }
+
+    statistics.pass_count = static_cast<uint32_t>(passes.size());
+    statistics.culled_pass_count = 0;
+
+    for (auto pass = passes.rbegin(); pass != passes.rend(); pass++) {
+        const auto writes_needed = std::any_of(
+            pass->uses.begin(), pass->uses.end(), [&](const Use &use) {
+                return is_write(use.usage) && needed.at(use.resource);
+            });
+
+        pass->culled = !pass->side_effects && !writes_needed;
+        if (pass->culled) {
+            statistics.culled_pass_count++;
+            continue;
+        }
+
+        // What the pass overwrites completely is not needed from earlier
+        // passes, everything else it touches is.
+        for (const auto &use : pass->uses) {
+            if (usage_info(use.usage).discards) {
+                needed.at(use.resource) = false;
+            }
+        }
+
+        for (const auto &use : pass->uses) {
+            if (!usage_info(use.usage).discards) {
+                needed.at(use.resource) = true;
+            }
+        }
+    }
+}
+
+void RenderGraph::allocate_transients() {
+    transient_images.clear();
+    transient_images.resize(resources.size());
+    alias_predecessors.assign(resources.size(), std::nullopt);
+
+    // The first and last kept pass to use each resource.
+    std::vector<std::pair<uint32_t, uint32_t>> lifetimes(
+        resources.size(), {std::numeric_limits<uint32_t>::max(), 0});
+
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (passes.at(i).culled) {
+            continue;
+        }
+
+        for (const auto &use : passes.at(i).uses) {
+            auto &lifetime = lifetimes.at(use.resource);
+            lifetime.first = std::min(lifetime.first, i);
+            lifetime.second = std::max(lifetime.second, i);
+        }
+    }
+
+    std::vector<ResourceId> transients;
+    std::vector<VkMemoryRequirements> requirements(resources.size());
+
+    for (ResourceId id = 0; id < resources.size(); id++) {
+        auto &resource = resources.at(id);
+        if (!resource.transient.has_value()) {
+            continue;
+        }
+
+        const auto &info = resource.transient.value();
+        transient_images.at(id) = std::make_unique<Image>(
+            device, info.extent, info.format, info.usage, info.aspect, 1,
+            Image::Memory::External);
+        resource.image = transient_images.at(id)->get();
+        requirements.at(id) = transient_images.at(id)->get_memory_requirements();
+
+        transients.push_back(id);
+    }
+
+    // Largest first, each into the first allocation that is compatible and
+    // not in use during the image's lifetime.
+    std::sort(transients.begin(), transients.end(),
+              [&](ResourceId a, ResourceId b) {
+                  return requirements.at(a).size > requirements.at(b).size;
+              });
+
+    struct Slot {
+        VkDeviceSize size;
+        uint32_t memory_type_bits;
+        std::vector<ResourceId> occupants;
+    };
+
+    std::vector<Slot> slots;
+
+    statistics.transient_image_count =
+        static_cast<uint32_t>(transients.size());
+    statistics.transient_bytes = 0;
+
+    for (const auto id : transients) {
+        const auto &requirement = requirements.at(id);
+        statistics.transient_bytes += requirement.size;
+
+        const auto slot = std::find_if(
+            slots.begin(), slots.end(), [&](const Slot &candidate) {
+                return (candidate.memory_type_bits &
+                        requirement.memoryTypeBits) != 0 &&
+                       std::none_of(candidate.occupants.begin(),
+                                    candidate.occupants.end(),
+                                    [&](ResourceId occupant) {
+                                        return overlaps(
+                                            lifetimes.at(occupant),
+                                            lifetimes.at(id));
+                                    });
+            });
+
+        if (slot == slots.end()) {
+            slots.push_back(Slot{
+                .size = requirement.size,
+                .memory_type_bits = requirement.memoryTypeBits,
+                .occupants = {id},
+            });
+        } else {
+            slot->size = std::max(slot->size, requirement.size);
+            slot->memory_type_bits &= requirement.memoryTypeBits;
+            slot->occupants.push_back(id);
+        }
+    }
+
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(device.get_physical(),
+                                        &memory_properties);
+
+    statistics.transient_allocation_count =
+        static_cast<uint32_t>(slots.size());
+    statistics.aliased_transient_bytes = 0;
+
+    for (const auto &slot : slots) {
+        std::optional<uint32_t> memory_type_index;
+
+        for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+            const auto has_type_bit = (slot.memory_type_bits & (1 << i)) != 0;
+            const auto is_device_local =
+                (memory_properties.memoryTypes[i].propertyFlags &
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+
+            if (has_type_bit && is_device_local) {
+                memory_type_index = i;
+                break;
+            }
+        }
+
+        if (!memory_type_index.has_value()) {
+            fmt::println("[ERROR]: No device local memory type for a "
+                         "transient slot.");
+            throw Error::OutOfMemoryError;
+        }
+
+        const VkMemoryAllocateInfo allocate_info{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .allocationSize = slot.size,
+            .memoryTypeIndex = memory_type_index.value(),
+        };
+
+        const auto memory = device.get_memory_tracker().allocate(
+            device.get(), allocate_info, MemoryCategory::Transient);
+        transient_memory.push_back(memory);
+        statistics.aliased_transient_bytes += slot.size;
+
+        for (const auto id : slot.occupants) {
+            transient_images.at(id)->bind_memory(memory, 0);
+            transient_images.at(id)->set_debug_name(resources.at(id).name);
+
+            // The occupant that last used the memory before this one starts.
+            for (const auto other : slot.occupants) {
+                const auto &lifetime = lifetimes.at(other);
+                if (other == id || lifetime.first > lifetime.second ||
+                    lifetime.second >= lifetimes.at(id).first) {
+                    continue;
+                }
+
+                auto &predecessor = alias_predecessors.at(id);
+                if (!predecessor.has_value() ||
+                    lifetimes.at(*predecessor).second < lifetime.second) {
+                    predecessor = other;
+                }
+            }
+        }
+    }
+}
+
+void RenderGraph::plan_barriers() {
+    std::vector<TrackedState> states;
+    std::vector<bool> used(resources.size(), false);
+
+    states.reserve(resources.size());
+    for (const auto &resource : resources) {
+        states.push_back(initial_state(resource.initial));
+    }
+
+    const auto plan = [&](ResourceId p_id, ResourceUsage p_usage,
+                          std::vector<Barrier> &p_barriers) {
+        auto &state = states.at(p_id);
+
+        // Memory shared with an earlier transient image has to wait for that
+        // image to be done with it.
+        if (!used.at(p_id) && alias_predecessors.at(p_id).has_value()) {
+            const auto &predecessor = states.at(*alias_predecessors.at(p_id));
+            state.write_stages =
+                predecessor.write_stages | predecessor.read_stages;
+            state.write_access = predecessor.write_access;
+        }
+        used.at(p_id) = true;
+
+        const auto transition =
+            advance(state, p_usage, resources.at(p_id).is_image);
+        if (transition.has_value()) {
+            p_barriers.push_back(Barrier{
+                .resource = p_id,
+                .src_stages = transition->src_stages,
+                .src_access = transition->src_access,
+                .dst_stages = transition->dst_stages,
+                .dst_access = transition->dst_access,
+                .old_layout = transition->old_layout,
+                .new_layout = transition->new_layout,
+            });
+        }
+    };
+
+    statistics.barrier_count = 0;
+    statistics.image_barrier_count = 0;
+
+    const auto count = [&](const std::vector<Barrier> &p_barriers) {
+        if (!p_barriers.empty()) {
+            statistics.barrier_count++;
+        }
+
+        statistics.image_barrier_count += static_cast<uint32_t>(
+            std::count_if(p_barriers.begin(), p_barriers.end(),
+                          [&](const Barrier &barrier) {
+                              return resources.at(barrier.resource).is_image;
+                          }));
+    };
+
+    for (auto &pass : passes) {
+        pass.barriers.clear();
+        if (pass.culled) {
+            continue;
+        }
+
+        for (const auto &use : pass.uses) {
+            plan(use.resource, use.usage, pass.barriers);
+        }
+
+        count(pass.barriers);
+    }
+
+    final_barriers.clear();
+    for (ResourceId id = 0; id < resources.size(); id++) {
+        const auto &final_usage = resources.at(id).final_usage;
+        if (final_usage.has_value()) {
+            plan(id, final_usage.value(), final_barriers);
+        }
+    }
+
+    count(final_barriers);
+}
+
+void RenderGraph::set_image(ResourceId p_resource, VkImage p_image) {
+    resources.at(p_resource).image = p_image;
+}
+
+void RenderGraph::execute(
+    VkCommandBuffer p_command_buffer,
+    const PipelineStatisticsQueries *p_statistics) const {
+    TRACE_SCOPE("RenderGraph::execute");
+
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        const auto &pass = passes[i];
+        if (pass.culled) {
+            continue;
+        }
+
+        record_barriers(p_command_buffer, pass.barriers);
+
+        const DebugLabel label{device, p_command_buffer, pass.name};
+        if (p_statistics != nullptr) {
+            p_statistics->begin(p_command_buffer, i);
+        }
+        pass.execute(p_command_buffer);
+        if (p_statistics != nullptr) {
+            p_statistics->end(p_command_buffer, i);
+        }
+    }
+
+    record_barriers(p_command_buffer, final_barriers);
+}
+
+void RenderGraph::record_barriers(VkCommandBuffer p_command_buffer,
+                                  std::span<const Barrier> p_barriers) const {
+    if (p_barriers.empty()) {
+        return;
+    }
+
+    // Buffers are covered by one global memory barrier, which is as cheap as
+    // a buffer barrier and saves naming every range.
+    VkMemoryBarrier2 memory_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .srcAccessMask = VK_ACCESS_2_NONE,
+        .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask = VK_ACCESS_2_NONE,
+    };
+    bool has_memory_barrier = false;
+
+    std::vector<VkImageMemoryBarrier2> image_barriers;
+
+    for (const auto &barrier : p_barriers) {
+        const auto &resource = resources.at(barrier.resource);
+
+        if (!resource.is_image) {
+            memory_barrier.srcStageMask |= barrier.src_stages;
+            memory_barrier.srcAccessMask |= barrier.src_access;
+            memory_barrier.dstStageMask |= barrier.dst_stages;
+            memory_barrier.dstAccessMask |= barrier.dst_access;
+            has_memory_barrier = true;
+            continue;
+        }
+
+        image_barriers.push_back(VkImageMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = barrier.src_stages,
+            .srcAccessMask = barrier.src_access,
+            .dstStageMask = barrier.dst_stages,
+            .dstAccessMask = barrier.dst_access,
+            .oldLayout = barrier.old_layout,
+            .newLayout = barrier.new_layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = resource.image,
+            .subresourceRange =
+                {
+                    .aspectMask = resource.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                    .baseArrayLayer = 0,
+                    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                },
+        });
+    }
+
+    if (device.get_capabilities().synchronization2) {
+        const VkDependencyInfo dependency_info{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .dependencyFlags = 0,
+            .memoryBarrierCount = has_memory_barrier ? 1u : 0u,
+            .pMemoryBarriers = &memory_barrier,
+            .bufferMemoryBarrierCount = 0,
+            .pBufferMemoryBarriers = nullptr,
+            .imageMemoryBarrierCount =
+                static_cast<uint32_t>(image_barriers.size()),
+            .pImageMemoryBarriers = image_barriers.data(),
+        };
+
+        vkCmdPipelineBarrier2(p_command_buffer, &dependency_info);
+        return;
+    }
+
+    // Without synchronization2 all barriers share one pair of stage masks.
+    // The flags used by the graph have the same values in both versions.
+    VkPipelineStageFlags src_stages = 0;
+    VkPipelineStageFlags dst_stages = 0;
+
+    const VkMemoryBarrier legacy_memory_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = static_cast<VkAccessFlags>(memory_barrier.srcAccessMask),
+        .dstAccessMask = static_cast<VkAccessFlags>(memory_barrier.dstAccessMask),
+    };
+
+    if (has_memory_barrier) {
+        src_stages |= static_cast<VkPipelineStageFlags>(
+            memory_barrier.srcStageMask);
+        dst_stages |= static_cast<VkPipelineStageFlags>(
+            memory_barrier.dstStageMask);
+    }
+
+    std::vector<VkImageMemoryBarrier> legacy_image_barriers;
+    legacy_image_barriers.reserve(image_barriers.size());
+
+    for (const auto &barrier : image_barriers) {
+        src_stages |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+        dst_stages |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+        legacy_image_barriers.push_back(VkImageMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask),
+            .dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask),
+            .oldLayout = barrier.oldLayout,
+            .newLayout = barrier.newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = barrier.image,
+            .subresourceRange = barrier.subresourceRange,
+        });
+    }
+
+    vkCmdPipelineBarrier(
+        p_command_buffer,
+        src_stages != 0 ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        dst_stages != 0 ? dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+        has_memory_barrier ? 1u : 0u, &legacy_memory_barrier, 0, nullptr,
+        static_cast<uint32_t>(legacy_image_barriers.size()),
+        legacy_image_barriers.data());
+}
+
+void RenderGraph::reset() {
+    passes.clear();
+    resources.clear();
+    final_barriers.clear();
+    transient_images.clear();
+    alias_predecessors.clear();
+
+    for (const auto memory : transient_memory) {
+        device.get_memory_tracker().free(device.get(), memory);
+    }
+
+    transient_memory.clear();
+    statistics = {};
+}
+
+auto RenderGraph::get_image(ResourceId p_resource) const -> const Image & {
+    return *transient_images.at(p_resource);
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "images.hpp"
+#include "queries.hpp"
+
+using ResourceId = uint32_t;
+
+// How a pass uses a resource. Every usage stands for a fixed pipeline stage,
+// set of accesses and, for images, layout.
+enum class ResourceUsage {
+    // Not used yet. Images are in VK_IMAGE_LAYOUT_UNDEFINED.
+    None,
+    // A freshly acquired swapchain image: the acquire semaphore is waited on
+    // at the color attachment output stage.
+    SwapchainAcquire,
+    IndirectRead,
+    // Storage buffer reads in the vertex shader.
+    VertexShaderRead,
+    // Storage buffer or storage image reads in a compute shader. Images are
+    // in VK_IMAGE_LAYOUT_GENERAL.
+    ComputeRead,
+    // Storage buffer or storage image reads and writes in a compute shader.
+    // Images are in VK_IMAGE_LAYOUT_GENERAL.
+    ComputeWrite,
+    // Sampled image reads in a compute shader.
+    ComputeSampled,
+    TransferRead,
+    TransferWrite,
+    ColorAttachment,
+    // A color attachment whose previous contents are not needed.
+    ColorAttachmentClear,
+    DepthAttachment,
+    // A depth attachment whose previous contents are not needed.
+    DepthAttachmentClear,
+    Present,
+    HostRead,
+};
+
+struct TransientImageInfo {
+    VkExtent2D extent;
+    VkFormat format;
+    VkImageUsageFlags usage;
+    VkImageAspectFlags aspect;
+};
+
+struct RenderGraphStatistics {
+    uint32_t pass_count;
+    uint32_t culled_pass_count;
+    // Pipeline barrier commands recorded per frame, and the image barriers in
+    // them.
+    uint32_t barrier_count;
+    uint32_t image_barrier_count;
+    uint32_t transient_image_count;
+    uint32_t transient_allocation_count;
+    // Memory the transient images would need on their own, and what they use
+    // after aliasing.
+    VkDeviceSize transient_bytes;
+    VkDeviceSize aliased_transient_bytes;
+};
+
+// The passes of a frame and the resources they use. From the declared usages
+// the graph derives every barrier and layout transition between passes,
+// drops passes whose results nothing uses and places transient images whose
+// lifetimes do not overlap in the same memory.
+//
+// The graph is built and compiled once and then executed every frame, so
+// pass callbacks should reference per-frame state rather than copy it. It has
+// to be rebuilt when resources are recreated, e.g. with the swapchain.
+//
+// Barriers are recorded with synchronization2 when the device has it, and
+// with the equivalent vkCmdPipelineBarrier otherwise.
+class RenderGraph {
+  public:
+    class PassBuilder;
+
+    using Setup = std::function<void(PassBuilder &)>;
+    using Execute = std::function<void(VkCommandBuffer)>;
+
+    class PassBuilder {
+      public:
+        void use(ResourceId resource, ResourceUsage usage);
+
+        // Keeps the pass even when nothing uses what it writes.
+        void set_side_effects();
+
+      private:
+        friend class RenderGraph;
+
+        explicit PassBuilder(RenderGraph &graph, uint32_t pass)
+            : graph(graph), pass(pass) {}
+
+        RenderGraph &graph;
+        uint32_t pass;
+    };
+
+    explicit RenderGraph(const Device &device);
+
+    NO_COPY(RenderGraph);
+
+    // `initial` is how the resource was last used before the frame starts.
+    auto import_buffer(std::string_view name, VkBuffer buffer,
+                       ResourceUsage initial) -> ResourceId;
+
+    // The image may be null until `set_image` is called, which has to happen
+    // before `execute`.
+    auto import_image(std::string_view name, VkImage image,
+                      VkImageAspectFlags aspect, ResourceUsage initial)
+        -> ResourceId;
+
+    // An image that only lives within a frame. Created by `compile`, possibly
+    // sharing memory with other transient images, and undefined at the start
+    // of every frame.
+    auto create_image(std::string_view name, const TransientImageInfo &info)
+        -> ResourceId;
+
+    void add_pass(std::string_view name, const Setup &setup,
+                  Execute execute);
+
+    // Marks a resource as a result of the frame, to be left in
+    // `final_usage` at its end. Passes that contribute to no result are
+    // culled.
+    void set_output(ResourceId resource, ResourceUsage final_usage);
+
+    // Culls passes, plans the barriers and allocates transient images.
+    void compile();
+
+    // Points an imported image at a different image, e.g. at the acquired
+    // swapchain image.
+    void set_image(ResourceId resource, VkImage image);
+
+    // With `statistics`, which needs a query per added pass, every pass that
+    // is not culled is wrapped in the query of the same index.
+    void execute(VkCommandBuffer command_buffer,
+                 const PipelineStatisticsQueries *statistics = nullptr) const;
+
+    inline uint32_t get_pass_count() const {
+        return static_cast<uint32_t>(passes.size());
+    }
+
+    inline std::string_view get_pass_name(uint32_t pass) const {
+        return passes.at(pass).name;
+    }
+
+    // Only valid after `compile`. Culled passes never write their query.
+    inline bool is_pass_culled(uint32_t pass) const {
+        return passes.at(pass).culled;
+    }
+
+    // Drops all passes, resources and transient images. The GPU must be done
+    // with them.
+    void reset();
+
+    // A transient image. Only valid after `compile`.
+    auto get_image(ResourceId resource) const -> const Image &;
+
+    inline const RenderGraphStatistics &get_statistics() const {
+        return statistics;
+    }
+
+    inline ~RenderGraph() { reset(); }
+
+  private:
+    struct Resource {
+        std::string name;
+        bool is_image;
+        VkBuffer buffer;
+        VkImage image;
+        VkImageAspectFlags aspect;
+        ResourceUsage initial;
+        std::optional<ResourceUsage> final_usage;
+        std::optional<TransientImageInfo> transient;
+    };
+
+    struct Use {
+        ResourceId resource;
+        ResourceUsage usage;
+    };
+
+    struct Barrier {
+        ResourceId resource;
+        VkPipelineStageFlags2 src_stages;
+        VkAccessFlags2 src_access;
+        VkPipelineStageFlags2 dst_stages;
+        VkAccessFlags2 dst_access;
+        VkImageLayout old_layout;
+        VkImageLayout new_layout;
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<Use> uses;
+        bool side_effects;
+        Execute execute;
+        bool culled;
+        std::vector<Barrier> barriers;
+    };
+
+    void cull_passes();
+    void allocate_transients();
+    void plan_barriers();
+    void record_barriers(VkCommandBuffer command_buffer,
+                         std::span<const Barrier> barriers) const;
+
+    const Device &device;
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<Barrier> final_barriers;
+
+    // Indexed by ResourceId, empty for imported resources.
+    std::vector<std::unique_ptr<Image>> transient_images;
+    // Per transient image, the transient image that used its memory last
+    // before it within the frame.
+    std::vector<std::optional<ResourceId>> alias_predecessors;
+    std::vector<VkDeviceMemory> transient_memory;
+
+    RenderGraphStatistics statistics;
+};
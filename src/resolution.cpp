@@ -0,0 +1,108 @@
+#include "resolution.hpp"
+
+namespace {
+// Weight of the newest frame in the average.
+constexpr double SMOOTHING = 0.1;
+// Frames to wait after a change before the scale may change again, so that
+// the average reflects the new scale.
+constexpr uint32_t SETTLE_FRAMES = 8;
+// Aim below the budget to leave room for spikes, and hold within a band
+// around the aim.
+constexpr double TARGET_FRACTION = 0.9;
+constexpr double HOLD_FRACTION = 0.08;
+// Scales are multiples of STEP and change by at most MAX_STEP at once.
+constexpr float STEP = 0.05f;
+constexpr float MAX_STEP = 0.1f;
+} // namespace
+
+ResolutionScaler::ResolutionScaler(const ResolutionSettings &p_settings)
+    : settings(p_settings), scale(p_settings.max_scale),
+      average_milliseconds(0.0), settled_frames(0) {}
+
+bool ResolutionScaler::update(double p_gpu_milliseconds) {
+    if (p_gpu_milliseconds <= 0.0) {
+        return false;
+    }
+
+    average_milliseconds =
+        average_milliseconds == 0.0
+            ? p_gpu_milliseconds
+            : average_milliseconds +
+                  SMOOTHING * (p_gpu_milliseconds - average_milliseconds);
+
+    if (settled_frames < SETTLE_FRAMES) {
+        settled_frames++;
+        return false;
+    }
+
+    const auto target = settings.budget_milliseconds * TARGET_FRACTION;
+    if (std::abs(average_milliseconds - target) <=
+        settings.budget_milliseconds * HOLD_FRACTION) {
+        return false;
+    }
+
+    // The cost of a frame mostly follows its pixel count, which is the square
+    // of the scale.
+    auto wanted =
+        scale * static_cast<float>(std::sqrt(target / average_milliseconds));
+    wanted = std::clamp(wanted, scale - MAX_STEP, scale + MAX_STEP);
+    wanted = std::round(wanted / STEP) * STEP;
+    wanted = std::clamp(wanted, settings.min_scale, settings.max_scale);
+
+    if (std::abs(wanted - scale) < STEP * 0.5f) {
+        return false;
+    }
+
+    // Predict the new frame time rather than dragging the old one along.
+    average_milliseconds *= (wanted * wanted) / (scale * scale);
+    scale = wanted;
+    settled_frames = 0;
+    return true;
+}
+
+auto ResolutionScaler::get_render_extent(VkExtent2D p_output_extent) const
+    -> VkExtent2D {
+    const auto scaled = [&](uint32_t size) {
+        return std::max(
+            static_cast<uint32_t>(std::round(static_cast<float>(size) * scale)),
+            1u);
+    };
+
+    return VkExtent2D{
+        .width = scaled(p_output_extent.width),
+        .height = scaled(p_output_extent.height),
+    };
+}
+
+void record_upscale(VkCommandBuffer p_command_buffer, VkImage p_source,
+                    VkExtent2D p_source_extent, VkImage p_destination,
+                    VkExtent2D p_destination_extent, VkFilter p_filter) {
+    const VkImageSubresourceLayers subresource{
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .mipLevel = 0,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+
+    const VkImageBlit region{
+        .srcSubresource = subresource,
+        .srcOffsets =
+            {
+                VkOffset3D{0, 0, 0},
+                VkOffset3D{static_cast<int32_t>(p_source_extent.width),
+                           static_cast<int32_t>(p_source_extent.height), 1},
+            },
+        .dstSubresource = subresource,
+        .dstOffsets =
+            {
+                VkOffset3D{0, 0, 0},
+                VkOffset3D{static_cast<int32_t>(p_destination_extent.width),
+                           static_cast<int32_t>(p_destination_extent.height),
+                           1},
+            },
+    };
+
+    vkCmdBlitImage(p_command_buffer, p_source,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, p_destination,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, p_filter);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common.hpp"
+
+struct ResolutionSettings {
+    // GPU time per frame to stay within.
+    double budget_milliseconds;
+    float min_scale;
+    float max_scale;
+};
+
+// Picks the fraction of the output resolution to render at, from measured GPU
+// frame times. The times are smoothed, the scale moves in coarse steps and
+// holds while the frame time is close enough to the budget, so that it does
+// not change every frame or oscillate between two steps.
+class ResolutionScaler {
+  public:
+    explicit ResolutionScaler(const ResolutionSettings &settings);
+
+    NO_COPY(ResolutionScaler);
+
+    // Feeds the GPU time of a frame rendered at the current scale. Returns
+    // whether the scale changed.
+    bool update(double gpu_milliseconds);
+
+    inline float get_scale() const { return scale; }
+
+    inline double get_average_milliseconds() const {
+        return average_milliseconds;
+    }
+
+    // The scaled extent, at least one pixel in each dimension.
+    auto get_render_extent(VkExtent2D output_extent) const -> VkExtent2D;
+
+  private:
+    ResolutionSettings settings;
+
+    float scale;
+    double average_milliseconds;
+    // Frames measured since the scale last changed.
+    uint32_t settled_frames;
+};
+
+// Blits the top left `source_extent` of `source` over all of `destination`.
+// The images must be in the transfer source and destination layouts.
+void record_upscale(VkCommandBuffer command_buffer, VkImage source,
+                    VkExtent2D source_extent, VkImage destination,
+                    VkExtent2D destination_extent, VkFilter filter);
@@ -0,0 +1,18 @@
+#include "shaders.hpp"
+
+auto find_shader(std::string_view p_name) -> std::span<const uint32_t> {
+    const auto shaders = get_embedded_shaders();
+
+    const auto shader = std::lower_bound(
+        shaders.begin(), shaders.end(), p_name,
+        [](const EmbeddedShader &shader, std::string_view name) {
+            return shader.name < name;
+        });
+
+    if (shader == shaders.end() || shader->name != p_name) {
+        fmt::println("[ERROR]: No shader named '{}' was embedded.", p_name);
+        throw Error::ShaderNotFoundError;
+    }
+
+    return shader->code;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "common.hpp"
+
+// SPIR-V compiled from shaders/ at build time and embedded in the executable.
+struct EmbeddedShader {
+    // The source file name, e.g. "main.vert".
+    std::string_view name;
+    std::span<const uint32_t> code;
+};
+
+// Sorted by name. Defined in the source file the build generates from the
+// compiled shaders.
+auto get_embedded_shaders() -> std::span<const EmbeddedShader>;
+
+// Throws Error::ShaderNotFoundError when no shader has that name.
+auto find_shader(std::string_view name) -> std::span<const uint32_t>;
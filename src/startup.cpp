@@ -0,0 +1,115 @@
+#include "startup.hpp"
+#include "trace.hpp"
+
+namespace {
+double milliseconds_between(std::chrono::steady_clock::time_point p_start,
+                            std::chrono::steady_clock::time_point p_end) {
+    return std::chrono::duration<double, std::milli>(p_end - p_start).count();
+}
+} // namespace
+
+StartupTimeline::StartupTimeline()
+    : origin(std::chrono::steady_clock::now()), finished(false) {}
+
+StartupTimeline::Phase::Phase(StartupTimeline &p_timeline,
+                              std::string_view p_name)
+    : timeline(p_timeline), name(p_name),
+      start(std::chrono::steady_clock::now()), ended(false) {}
+
+void StartupTimeline::Phase::end() {
+    if (ended) {
+        return;
+    }
+
+    timeline.record(name, start, std::chrono::steady_clock::now());
+    ended = true;
+}
+
+void StartupTimeline::finish(std::string_view p_trace_path) {
+    const auto now = std::chrono::steady_clock::now();
+
+    const std::lock_guard lock{mutex};
+    if (finished) {
+        return;
+    }
+    finished = true;
+
+    fmt::println("[INFO]: First present after {:.2f} ms",
+                 milliseconds_between(origin, now));
+    for (const auto &event : events) {
+        fmt::println("[INFO]:   {:<28} thread {}: {:8.2f} ms at {:8.2f} ms",
+                     event.name, event.thread, event.duration_milliseconds,
+                     event.start_milliseconds);
+    }
+
+    if (!p_trace_path.empty()) {
+        write_trace(p_trace_path);
+    }
+}
+
+void StartupTimeline::record(std::string_view p_name,
+                             std::chrono::steady_clock::time_point p_start,
+                             std::chrono::steady_clock::time_point p_end) {
+    const std::lock_guard lock{mutex};
+
+    const auto id = std::this_thread::get_id();
+    auto thread = std::find(threads.begin(), threads.end(), id);
+    if (thread == threads.end()) {
+        thread = threads.insert(threads.end(), id);
+    }
+
+    events.push_back(Event{
+        .name = std::string{p_name},
+        .thread = static_cast<uint32_t>(thread - threads.begin()),
+        .start_milliseconds = milliseconds_between(origin, p_start),
+        .duration_milliseconds = milliseconds_between(p_start, p_end),
+    });
+}
+
+void StartupTimeline::write_trace(std::string_view p_path) const {
+    ChromeTraceWriter writer{p_path};
+    if (!writer.is_open()) {
+        return;
+    }
+
+    for (const auto &event : events) {
+        writer.write_event(
+            TraceEvent{
+                .name = event.name.c_str(),
+                .type = TraceEventType::Scope,
+                .timestamp =
+                    static_cast<int64_t>(event.start_milliseconds * 1e6),
+                .duration =
+                    static_cast<int64_t>(event.duration_milliseconds * 1e6),
+                .value = 0.0,
+                .id = 0,
+            },
+            event.thread);
+    }
+
+    fmt::println("[INFO]: Wrote the startup trace to '{}'", p_path);
+}
+
+StartupTask::StartupTask(JobSystem &p_jobs, StartupTimeline &p_timeline,
+                         std::string_view p_name, std::function<void()> p_work)
+    : jobs(p_jobs) {
+    jobs.run(counter, [this, &p_timeline, name = std::string{p_name},
+                       work = std::move(p_work)]() {
+        const StartupTimeline::Phase phase{p_timeline, name};
+        try {
+            work();
+        } catch (Error task_error) {
+            error = task_error;
+        }
+    });
+}
+
+void StartupTask::wait() {
+    jobs.wait(counter);
+
+    if (error.has_value()) {
+        throw *error;
+    }
+}
+
+StartupTask::~StartupTask() { jobs.wait(counter); }
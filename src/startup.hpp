@@ -0,0 +1,80 @@
+#pragma once
+
+#include "jobs.hpp"
+
+// Wall-clock phases of startup on every thread, up to the first present.
+// Phases may be recorded from any thread.
+class StartupTimeline {
+  public:
+    // Starts the clock.
+    StartupTimeline();
+
+    NO_COPY(StartupTimeline);
+
+    // Runs from its construction until `end` or its destruction.
+    class Phase {
+      public:
+        Phase(StartupTimeline &timeline, std::string_view name);
+
+        NO_COPY(Phase);
+
+        void end();
+
+        inline ~Phase() { end(); }
+
+      private:
+        StartupTimeline &timeline;
+        std::string name;
+        std::chrono::steady_clock::time_point start;
+        bool ended;
+    };
+
+    // Records the first present, logs every phase and, unless `trace_path`
+    // is empty, writes them as a Chrome trace that chrome://tracing and
+    // Perfetto open. Only the first call does anything.
+    void finish(std::string_view trace_path);
+
+  private:
+    struct Event {
+        std::string name;
+        uint32_t thread;
+        double start_milliseconds;
+        double duration_milliseconds;
+    };
+
+    void record(std::string_view name,
+                std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+
+    void write_trace(std::string_view path) const;
+
+    std::chrono::steady_clock::time_point origin;
+
+    std::mutex mutex;
+    std::vector<Event> events;
+    // Threads in the order they first recorded a phase. The index is the
+    // thread's id in the trace.
+    std::vector<std::thread::id> threads;
+    bool finished;
+};
+
+// Startup work that runs on the job system while the calling thread brings
+// up something else. An error thrown by the work is rethrown by `wait`.
+class StartupTask {
+  public:
+    StartupTask(JobSystem &jobs, StartupTimeline &timeline,
+                std::string_view name, std::function<void()> work);
+
+    NO_COPY(StartupTask);
+
+    void wait();
+
+    // Waits without rethrowing, since the work may reference locals of the
+    // scope that is being left.
+    ~StartupTask();
+
+  private:
+    JobSystem &jobs;
+    JobCounter counter;
+    std::optional<Error> error;
+};
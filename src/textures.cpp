@@ -0,0 +1,364 @@
+#include "textures.hpp"
+
+#include "buffers.hpp"
+
+namespace {
+bool is_bc(VkFormat p_format) {
+    return p_format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK &&
+           p_format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+bool is_etc2(VkFormat p_format) {
+    return p_format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK &&
+           p_format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK;
+}
+
+// Whether the remaining levels can be blitted from the base level.
+bool can_generate_mips(const Device &p_device, VkFormat p_format) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(p_device.get_physical(), p_format,
+                                        &properties);
+
+    constexpr VkFormatFeatureFlags required =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+uint32_t get_level_count(const Device &p_device, const TextureData &p_data) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(p_device.get_physical(), p_data.format,
+                                        &properties);
+
+    const auto &capabilities = p_device.get_capabilities();
+    const auto is_enabled =
+        (!is_bc(p_data.format) || capabilities.texture_compression_bc) &&
+        (!is_etc2(p_data.format) || capabilities.texture_compression_etc2);
+
+    if (!is_enabled || (properties.optimalTilingFeatures &
+                        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0) {
+        fmt::println("[ERROR]: The device cannot sample textures of format {}.",
+                     static_cast<int>(p_data.format));
+        throw Error::UnsupportedFormatError;
+    }
+
+    const auto provided = static_cast<uint32_t>(p_data.levels.size());
+    if (!p_data.generate_mips) {
+        return provided;
+    }
+
+    if (!can_generate_mips(p_device, p_data.format)) {
+        fmt::println("[WARNING]: Cannot generate mips for format {}, using the "
+                     "provided levels only.",
+                     static_cast<int>(p_data.format));
+        return provided;
+    }
+
+    return static_cast<uint32_t>(std::bit_width(
+        std::max(p_data.extent.width, p_data.extent.height)));
+}
+
+VkImageSubresourceRange level_range(uint32_t p_base_level,
+                                    uint32_t p_level_count) {
+    return VkImageSubresourceRange{
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = p_base_level,
+        .levelCount = p_level_count,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+}
+
+void transition(VkCommandBuffer p_command_buffer, VkImage p_image,
+                const VkImageSubresourceRange &p_range,
+                VkImageLayout p_old_layout, VkImageLayout p_new_layout,
+                VkAccessFlags p_src_access, VkAccessFlags p_dst_access,
+                VkPipelineStageFlags p_src_stages,
+                VkPipelineStageFlags p_dst_stages) {
+    const VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = p_src_access,
+        .dstAccessMask = p_dst_access,
+        .oldLayout = p_old_layout,
+        .newLayout = p_new_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = p_image,
+        .subresourceRange = p_range,
+    };
+
+    vkCmdPipelineBarrier(p_command_buffer, p_src_stages, p_dst_stages, 0, 0,
+                         nullptr, 0, nullptr, 1, &barrier);
+}
+
+constexpr VkPipelineStageFlags SHADER_STAGES =
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+VkExtent2D level_extent(VkExtent2D p_extent, uint32_t p_level) {
+    return VkExtent2D{
+        .width = std::max(p_extent.width >> p_level, 1u),
+        .height = std::max(p_extent.height >> p_level, 1u),
+    };
+}
+} // namespace
+
+auto get_format_block(VkFormat p_format) -> std::optional<FormatBlock> {
+    switch (p_format) {
+    case VK_FORMAT_R8_UNORM:
+        return FormatBlock{1, 1, 1, false};
+    case VK_FORMAT_R8G8_UNORM:
+        return FormatBlock{1, 1, 2, false};
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return FormatBlock{1, 1, 4, false};
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        return FormatBlock{1, 1, 8, false};
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+        return FormatBlock{1, 1, 16, false};
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+        return FormatBlock{4, 4, 8, true};
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+        return FormatBlock{4, 4, 16, true};
+    default:
+        return {};
+    }
+}
+
+auto get_level_size(const FormatBlock &p_block, VkExtent2D p_extent,
+                    uint32_t p_level) -> VkDeviceSize {
+    const auto extent = level_extent(p_extent, p_level);
+    const VkDeviceSize blocks_x =
+        (extent.width + p_block.width - 1) / p_block.width;
+    const VkDeviceSize blocks_y =
+        (extent.height + p_block.height - 1) / p_block.height;
+    return blocks_x * blocks_y * p_block.size;
+}
+
+Texture::Texture(const Device &p_device, const CommandPool &p_command_pool,
+                 const TextureData &p_data)
+    : device(p_device),
+      image(p_device, p_data.extent, p_data.format,
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT, get_level_count(p_device, p_data)) {
+    upload(p_command_pool, p_data);
+}
+
+void Texture::upload(const CommandPool &p_command_pool,
+                     const TextureData &p_data) {
+    VkDeviceSize staging_size = 0;
+    for (const auto &level : p_data.levels) {
+        staging_size += level.size;
+    }
+
+    StagingBuffer staging{device, staging_size};
+
+    std::vector<VkBufferImageCopy> regions;
+    regions.reserve(p_data.levels.size());
+
+    auto staging_data = static_cast<char *>(staging.map_memory());
+    VkDeviceSize staging_offset = 0;
+
+    for (uint32_t level = 0; level < p_data.levels.size(); level++) {
+        const auto &source = p_data.levels[level];
+        std::memcpy(staging_data + staging_offset,
+                    p_data.bytes.data() + source.offset, source.size);
+
+        const auto extent = level_extent(p_data.extent, level);
+        regions.push_back(VkBufferImageCopy{
+            .bufferOffset = staging_offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            .imageOffset = {0, 0, 0},
+            .imageExtent = {extent.width, extent.height, 1},
+        });
+
+        staging_offset += source.size;
+    }
+
+    staging.unmap_memory();
+
+    const auto command_buffer = p_command_pool.begin_one_time();
+    const auto level_count = image.get_mip_levels();
+    const auto provided = static_cast<uint32_t>(p_data.levels.size());
+
+    transition(command_buffer, image.get(), level_range(0, level_count),
+               VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+               0, VK_ACCESS_TRANSFER_WRITE_BIT,
+               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+               VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    vkCmdCopyBufferToImage(command_buffer, staging.get().get(), image.get(),
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()),
+                           regions.data());
+
+    // The provided levels other than the last are final already.
+    if (provided > 1) {
+        transition(command_buffer, image.get(), level_range(0, provided - 1),
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                   VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                   VK_PIPELINE_STAGE_TRANSFER_BIT, SHADER_STAGES);
+    }
+
+    // Every generated level is blitted from the one above it, which becomes
+    // final once it has been read.
+    for (uint32_t level = provided; level < level_count; level++) {
+        transition(command_buffer, image.get(), level_range(level - 1, 1),
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                   VK_PIPELINE_STAGE_TRANSFER_BIT,
+                   VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        const auto source_extent = level_extent(p_data.extent, level - 1);
+        const auto destination_extent = level_extent(p_data.extent, level);
+
+        const VkImageBlit blit{
+            .srcSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level - 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            .srcOffsets =
+                {
+                    {0, 0, 0},
+                    {static_cast<int32_t>(source_extent.width),
+                     static_cast<int32_t>(source_extent.height), 1},
+                },
+            .dstSubresource =
+                {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            .dstOffsets =
+                {
+                    {0, 0, 0},
+                    {static_cast<int32_t>(destination_extent.width),
+                     static_cast<int32_t>(destination_extent.height), 1},
+                },
+        };
+
+        vkCmdBlitImage(command_buffer, image.get(),
+                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.get(),
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                       VK_FILTER_LINEAR);
+
+        transition(command_buffer, image.get(), level_range(level - 1, 1),
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                   VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+                   VK_PIPELINE_STAGE_TRANSFER_BIT, SHADER_STAGES);
+    }
+
+    transition(command_buffer, image.get(), level_range(level_count - 1, 1),
+               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+               VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+               VK_PIPELINE_STAGE_TRANSFER_BIT, SHADER_STAGES);
+
+    p_command_pool.end_one_time(command_buffer);
+}
+
+SamplerCache::SamplerCache(const Device &p_device)
+    : device(p_device), device_max_anisotropy(1.0f) {
+    if (device.get_capabilities().sampler_anisotropy) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device.get_physical(), &properties);
+        device_max_anisotropy = properties.limits.maxSamplerAnisotropy;
+    }
+}
+
+auto SamplerCache::get(const SamplerSettings &p_settings) -> VkSampler {
+    if (const auto cached = samplers.find(p_settings);
+        cached != samplers.end()) {
+        return cached->second;
+    }
+
+    const auto max_anisotropy =
+        std::clamp(p_settings.max_anisotropy, 1.0f, device_max_anisotropy);
+
+    const VkSamplerCreateInfo sampler_info{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .magFilter = p_settings.filter,
+        .minFilter = p_settings.filter,
+        .mipmapMode = p_settings.mipmap_mode,
+        .addressModeU = p_settings.address_mode,
+        .addressModeV = p_settings.address_mode,
+        .addressModeW = p_settings.address_mode,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = max_anisotropy > 1.0f ? VK_TRUE : VK_FALSE,
+        .maxAnisotropy = max_anisotropy,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    VkSampler sampler;
+    VK_ERROR(vkCreateSampler(device.get(), &sampler_info, nullptr, &sampler));
+
+    samplers.emplace(p_settings, sampler);
+    return sampler;
+}
+
+auto SamplerCache::Hash::operator()(const SamplerSettings &p_settings) const
+    -> size_t {
+    auto hash = std::hash<float>{}(p_settings.max_anisotropy);
+    for (const auto value :
+         {static_cast<size_t>(p_settings.filter),
+          static_cast<size_t>(p_settings.mipmap_mode),
+          static_cast<size_t>(p_settings.address_mode)}) {
+        hash = hash * 31 + value;
+    }
+    return hash;
+}
+
+SamplerCache::~SamplerCache() {
+    for (const auto &[settings, sampler] : samplers) {
+        vkDestroySampler(device.get(), sampler, nullptr);
+    }
+}
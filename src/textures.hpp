@@ -0,0 +1,98 @@
+#pragma once
+
+#include "images.hpp"
+
+// Dimensions and size of a format's texel blocks. Uncompressed formats have
+// 1x1 blocks.
+struct FormatBlock {
+    uint32_t width;
+    uint32_t height;
+    uint32_t size;
+    bool compressed;
+};
+
+// Empty for formats textures cannot be created with.
+auto get_format_block(VkFormat format) -> std::optional<FormatBlock>;
+
+// Bytes taken by one mip level of an image with the given base extent.
+auto get_level_size(const FormatBlock &block, VkExtent2D extent,
+                    uint32_t level) -> VkDeviceSize;
+
+struct TextureLevel {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+// Texel data to upload into a texture. `levels` point into `bytes`, base
+// level first, and hold tightly packed rows of texel blocks.
+struct TextureData {
+    VkFormat format;
+    VkExtent2D extent;
+    std::vector<char> bytes;
+    std::vector<TextureLevel> levels;
+    // Complete the mip chain below the given levels on the GPU. Ignored for
+    // formats that cannot be blitted, such as block-compressed ones.
+    bool generate_mips;
+};
+
+// A sampled image uploaded through a staging buffer. Levels missing from the
+// data are generated by successively blitting each level into the next with
+// linear filtering. Textures are in SHADER_READ_ONLY_OPTIMAL once created.
+class Texture {
+  public:
+    Texture(const Device &device, const CommandPool &command_pool,
+            const TextureData &data);
+
+    NO_COPY(Texture);
+
+    inline const Image &get_image() const { return image; }
+
+    inline VkImageView get_view() const { return image.get_view(); }
+
+    inline void set_debug_name(std::string_view name) const {
+        image.set_debug_name(name);
+    }
+
+  private:
+    void upload(const CommandPool &command_pool, const TextureData &data);
+
+    const Device &device;
+
+    Image image;
+};
+
+struct SamplerSettings {
+    VkFilter filter = VK_FILTER_LINEAR;
+    VkSamplerMipmapMode mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    // 1 disables anisotropic filtering. Clamped to what the device supports.
+    float max_anisotropy = 1.0f;
+
+    auto operator==(const SamplerSettings &) const -> bool = default;
+};
+
+// Hands out one VkSampler per distinct SamplerSettings. Samplers live as long
+// as the cache.
+class SamplerCache {
+  public:
+    explicit SamplerCache(const Device &device);
+
+    NO_COPY(SamplerCache);
+
+    auto get(const SamplerSettings &settings) -> VkSampler;
+
+    inline size_t get_sampler_count() const { return samplers.size(); }
+
+    ~SamplerCache();
+
+  private:
+    struct Hash {
+        auto operator()(const SamplerSettings &settings) const -> size_t;
+    };
+
+    const Device &device;
+
+    float device_max_anisotropy;
+
+    std::unordered_map<SamplerSettings, VkSampler, Hash> samplers;
+};
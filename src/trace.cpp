@@ -0,0 +1,207 @@
+#include "trace.hpp"
+
+namespace {
+// Names are mostly literals from the source, but quotes and backslashes
+// would still break the JSON.
+auto escape_json(std::string_view p_text) -> std::string {
+    std::string escaped;
+    escaped.reserve(p_text.size());
+
+    for (const auto c : p_text) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(c);
+    }
+
+    return escaped;
+}
+} // namespace
+
+ChromeTraceWriter::ChromeTraceWriter(std::string_view p_path)
+    : file(std::string{p_path}), event_count(0) {
+    if (!file) {
+        fmt::println("[WARNING]: Could not write a trace to '{}'.", p_path);
+        file.close();
+        return;
+    }
+
+    // Also gives every later event a predecessor to put its comma after.
+    file << "{\"traceEvents\":[\n"
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"args\":{\"name\":\"Jubes\"}}";
+}
+
+ChromeTraceWriter::~ChromeTraceWriter() {
+    if (file.is_open()) {
+        file << "\n]}\n";
+    }
+}
+
+void ChromeTraceWriter::write_thread_name(size_t p_thread,
+                                          std::string_view p_name) {
+    write(fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                      "\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                      p_thread, escape_json(p_name)));
+}
+
+void ChromeTraceWriter::write_event(const TraceEvent &p_event,
+                                    size_t p_thread) {
+    const auto name = escape_json(p_event.name);
+    // Chrome traces count in microseconds.
+    const auto timestamp = static_cast<double>(p_event.timestamp) / 1000.0;
+
+    switch (p_event.type) {
+    case TraceEventType::Scope:
+        write(fmt::format("{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,"
+                          "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                          name, p_thread, timestamp,
+                          static_cast<double>(p_event.duration) / 1000.0));
+        break;
+    case TraceEventType::Counter:
+        write(fmt::format("{{\"name\":\"{}\",\"ph\":\"C\",\"pid\":1,"
+                          "\"tid\":{},\"ts\":{:.3f},"
+                          "\"args\":{{\"value\":{}}}}}",
+                          name, p_thread, timestamp, p_event.value));
+        break;
+    case TraceEventType::FlowBegin:
+        write(fmt::format("{{\"name\":\"{}\",\"cat\":\"flow\",\"ph\":\"s\","
+                          "\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"id\":{}}}",
+                          name, p_thread, timestamp, p_event.id));
+        break;
+    case TraceEventType::FlowEnd:
+        // Bound to the scope around it rather than the next one to start.
+        write(fmt::format("{{\"name\":\"{}\",\"cat\":\"flow\",\"ph\":\"f\","
+                          "\"bp\":\"e\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},"
+                          "\"id\":{}}}",
+                          name, p_thread, timestamp, p_event.id));
+        break;
+    }
+
+    event_count++;
+}
+
+void ChromeTraceWriter::write(std::string_view p_json) {
+    if (file.is_open()) {
+        file << ",\n" << p_json;
+    }
+}
+
+#ifdef JUBES_TRACING
+
+namespace {
+// 1.5 MiB per thread that traces anything.
+constexpr uint64_t RING_CAPACITY = 1 << 15;
+
+// Only its own thread writes to a ring. Readers copy the events and then
+// drop the ones that may have been overwritten while they copied.
+struct TraceRing {
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<uint64_t> written{0};
+    // Guarded by the registry's mutex.
+    std::string thread_name;
+};
+
+struct TraceRegistry {
+    std::chrono::steady_clock::time_point origin =
+        std::chrono::steady_clock::now();
+
+    std::mutex mutex;
+    // Rings outlive their threads, so that their events can still be
+    // exported.
+    std::vector<std::unique_ptr<TraceRing>> rings;
+};
+
+auto get_registry() -> TraceRegistry & {
+    static TraceRegistry registry;
+    return registry;
+}
+
+auto get_thread_ring() -> TraceRing & {
+    thread_local TraceRing *ring = nullptr;
+
+    if (ring == nullptr) {
+        auto &registry = get_registry();
+        const std::lock_guard lock{registry.mutex};
+
+        auto &created =
+            registry.rings.emplace_back(std::make_unique<TraceRing>());
+        created->events = std::make_unique<TraceEvent[]>(RING_CAPACITY);
+        ring = created.get();
+    }
+
+    return *ring;
+}
+} // namespace
+
+auto get_trace_time() -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - get_registry().origin)
+        .count();
+}
+
+void push_trace_event(const TraceEvent &p_event) {
+    auto &ring = get_thread_ring();
+
+    const auto index = ring.written.load(std::memory_order_relaxed);
+    // Keeps the slot from being overwritten before the store that published
+    // the previous event, so that a reader who sees any of this event also
+    // sees `written` at `index` and knows the slot's old event is gone.
+    std::atomic_thread_fence(std::memory_order_release);
+    ring.events[index & (RING_CAPACITY - 1)] = p_event;
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void set_trace_thread_name(std::string_view p_name) {
+    auto &ring = get_thread_ring();
+
+    const std::lock_guard lock{get_registry().mutex};
+    ring.thread_name = p_name;
+}
+
+void write_trace(std::string_view p_path) {
+    auto &registry = get_registry();
+    const std::lock_guard lock{registry.mutex};
+
+    ChromeTraceWriter writer{p_path};
+    if (!writer.is_open()) {
+        return;
+    }
+
+    std::vector<TraceEvent> events;
+
+    for (size_t thread = 0; thread < registry.rings.size(); thread++) {
+        const auto &ring = *registry.rings[thread];
+
+        const auto thread_name = ring.thread_name.empty()
+                                     ? fmt::format("Thread {}", thread)
+                                     : ring.thread_name;
+        writer.write_thread_name(thread, thread_name);
+
+        const auto end = ring.written.load(std::memory_order_acquire);
+        const auto begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+
+        events.clear();
+        for (auto i = begin; i < end; i++) {
+            events.push_back(ring.events[i & (RING_CAPACITY - 1)]);
+        }
+
+        // The event at index i is gone once the thread has started writing
+        // index i + RING_CAPACITY, which may have happened during the copy.
+        // The fence pairs with the writer's and keeps the copy from moving
+        // past the load.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto written = ring.written.load(std::memory_order_relaxed);
+        const auto first_intact =
+            written + 1 > RING_CAPACITY ? written + 1 - RING_CAPACITY : 0;
+
+        for (auto i = std::max(begin, first_intact); i < end; i++) {
+            writer.write_event(events[i - begin], thread);
+        }
+    }
+
+    fmt::println("[INFO]: Wrote {} trace events to '{}'",
+                 writer.get_event_count(), p_path);
+}
+
+#endif
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "common.hpp"
+
+// CPU tracing for finding frame hitches. Scopes, counters and flows are
+// written into a ring per thread without locks, and `write_trace` exports
+// whatever the rings still hold as a Chrome trace, which Perfetto and
+// chrome://tracing open. Only compiled in when JUBES_TRACING is defined
+// (every configuration by default); without it the macros expand to nothing.
+#ifdef JUBES_TRACING
+constexpr bool TRACING_ENABLED = true;
+#else
+constexpr bool TRACING_ENABLED = false;
+#endif
+
+enum class TraceEventType : uint32_t {
+    Scope,
+    Counter,
+    FlowBegin,
+    FlowEnd,
+};
+
+struct TraceEvent {
+    // Has to outlive the trace, which string literals do.
+    const char *name;
+    TraceEventType type;
+    // Nanoseconds since tracing started.
+    int64_t timestamp;
+    // Scopes only.
+    int64_t duration;
+    // Counters only.
+    double value;
+    // Flows only. The events of one flow share it.
+    uint64_t id;
+};
+
+// Writes events to a Chrome trace file. Shared by the trace rings and the
+// startup timeline, and available without JUBES_TRACING.
+class ChromeTraceWriter {
+  public:
+    // Logs a warning if the file cannot be created, after which nothing is
+    // written.
+    explicit ChromeTraceWriter(std::string_view path);
+
+    NO_COPY(ChromeTraceWriter);
+
+    // Closes the list of events.
+    ~ChromeTraceWriter();
+
+    inline bool is_open() const { return file.is_open(); }
+
+    inline uint32_t get_event_count() const { return event_count; }
+
+    // Threads are numbered by the caller.
+    void write_thread_name(size_t thread, std::string_view name);
+    void write_event(const TraceEvent &event, size_t thread);
+
+  private:
+    void write(std::string_view json);
+
+    std::ofstream file;
+    uint32_t event_count;
+};
+
+#ifdef JUBES_TRACING
+
+auto get_trace_time() -> int64_t;
+
+// Appends to the calling thread's ring, which is created on first use. Once
+// the ring is full, the oldest events are overwritten.
+void push_trace_event(const TraceEvent &event);
+
+// Names the calling thread in the trace. Unnamed threads are numbered.
+void set_trace_thread_name(std::string_view name);
+
+// May be called while other threads are tracing. Events they overwrite during
+// the export are left out.
+void write_trace(std::string_view path);
+
+class TraceScope {
+  public:
+    inline explicit TraceScope(const char *p_name)
+        : name(p_name), start(get_trace_time()) {}
+
+    NO_COPY(TraceScope);
+
+    inline ~TraceScope() {
+        push_trace_event(TraceEvent{
+            .name = name,
+            .type = TraceEventType::Scope,
+            .timestamp = start,
+            .duration = get_trace_time() - start,
+            .value = 0.0,
+            .id = 0,
+        });
+    }
+
+  private:
+    const char *name;
+    int64_t start;
+};
+
+inline void trace_counter(const char *p_name, double p_value) {
+    push_trace_event(TraceEvent{
+        .name = p_name,
+        .type = TraceEventType::Counter,
+        .timestamp = get_trace_time(),
+        .duration = 0,
+        .value = p_value,
+        .id = 0,
+    });
+}
+
+// Flows draw an arrow from the scope around their beginning to the scope
+// around their end, usually on another thread.
+inline void trace_flow(TraceEventType p_type, const char *p_name,
+                       uint64_t p_id) {
+    push_trace_event(TraceEvent{
+        .name = p_name,
+        .type = p_type,
+        .timestamp = get_trace_time(),
+        .duration = 0,
+        .value = 0.0,
+        .id = p_id,
+    });
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(name)                                                      \
+    const TraceScope TRACE_CONCAT(trace_scope_, __LINE__) { name }
+#define TRACE_COUNTER(name, value) trace_counter(name, value)
+#define TRACE_FLOW_BEGIN(name, id)                                             \
+    trace_flow(TraceEventType::FlowBegin, name, id)
+#define TRACE_FLOW_END(name, id) trace_flow(TraceEventType::FlowEnd, name, id)
+#define TRACE_THREAD_NAME(name) set_trace_thread_name(name)
+
+#else
+
+inline void write_trace(std::string_view) {
+    fmt::println("[WARNING]: Tracing is not compiled into this build.");
+}
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_FLOW_BEGIN(name, id) ((void)0)
+#define TRACE_FLOW_END(name, id) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "common.hpp"
+
+// Hands values from one writer thread to one reader thread without locks.
+// The writer fills its slot and publishes it; the reader takes the most
+// recently published value. Neither ever touches the other's slot, and
+// values published while the reader was busy are skipped rather than queued.
+template <typename T> class TripleBuffer {
+  public:
+    TripleBuffer() = default;
+
+    NO_COPY(TripleBuffer);
+
+    // Writer side. The slot keeps whatever was last written to it, so only
+    // changed fields need to be updated.
+    inline T &get_write_slot() { return slots[back]; }
+
+    inline void publish() {
+        auto state = shared.load(std::memory_order_relaxed);
+        while (!shared.compare_exchange_weak(
+            state, back | FRESH | (state & FLAGS), std::memory_order_acq_rel,
+            std::memory_order_relaxed)) {
+        }
+
+        back = state & INDEX;
+        shared.notify_all();
+    }
+
+    // Blocks until the reader has taken the last published value. Returns
+    // false once the buffer is closed.
+    inline bool wait_until_taken() {
+        auto state = shared.load(std::memory_order_acquire);
+        while ((state & FRESH) != 0 && (state & CLOSED) == 0) {
+            shared.wait(state, std::memory_order_acquire);
+            state = shared.load(std::memory_order_acquire);
+        }
+
+        return (state & CLOSED) == 0;
+    }
+
+    // Blocks until the reader asks for a new value with `request`, and
+    // consumes the request. Returns false once the buffer is closed.
+    inline bool wait_until_requested() {
+        auto state = shared.load(std::memory_order_acquire);
+        while ((state & REQUESTED) == 0 && (state & CLOSED) == 0) {
+            shared.wait(state, std::memory_order_acquire);
+            state = shared.load(std::memory_order_acquire);
+        }
+
+        state = shared.fetch_and(~REQUESTED, std::memory_order_acq_rel);
+        return (state & CLOSED) == 0;
+    }
+
+    // Reader side. Wakes a writer waiting in `wait_until_requested`, so that
+    // the value it publishes next is built as late as the reader wants it.
+    inline void request() {
+        shared.fetch_or(REQUESTED, std::memory_order_acq_rel);
+        shared.notify_all();
+    }
+
+    // Blocks until a value is published that the reader has not
+    // taken yet, and makes it the read slot. Returns false once the buffer is
+    // closed.
+    inline bool take() {
+        auto state = shared.load(std::memory_order_acquire);
+        while ((state & FRESH) == 0) {
+            if ((state & CLOSED) != 0) {
+                return false;
+            }
+
+            shared.wait(state, std::memory_order_acquire);
+            state = shared.load(std::memory_order_acquire);
+        }
+
+        while (!shared.compare_exchange_weak(state, front | (state & FLAGS),
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+        }
+
+        front = state & INDEX;
+        shared.notify_all();
+        return (state & CLOSED) == 0;
+    }
+
+    inline const T &get_read_slot() const { return slots[front]; }
+
+    // Wakes up both sides for good, e.g. on shutdown.
+    inline void close() {
+        shared.fetch_or(CLOSED, std::memory_order_acq_rel);
+        shared.notify_all();
+    }
+
+  private:
+    // The slot in the middle and whether it holds a value the reader has not
+    // taken yet.
+    static constexpr uint32_t INDEX = 0b11;
+    static constexpr uint32_t FRESH = 0b100;
+    static constexpr uint32_t CLOSED = 0b1000;
+    static constexpr uint32_t REQUESTED = 0b10000;
+    // Carried over when the middle slot changes hands.
+    static constexpr uint32_t FLAGS = CLOSED | REQUESTED;
+
+    std::array<T, 3> slots{};
+    std::atomic<uint32_t> shared{1};
+    // Only touched by the writer and the reader, respectively.
+    uint32_t back = 0;
+    uint32_t front = 2;
+};